@@ -0,0 +1,344 @@
+// Checks that the per-frame spectral, onset and tonal algorithms of essentia
+// do not allocate any memory in compute(), once they have processed a first
+// frame: many analyses run concurrently in the app, and the allocator then
+// becomes a point of contention between the threads.
+//
+// Each algorithm is run on the frames of a deterministic signal (tones
+// changing every few frames, plus noise), its outputs being bound to the same
+// objects for all the frames, as an application would do. The first frame is
+// allowed to allocate (outputs and scratch buffers get their size then), the
+// following ones are not. The number of peaks varies from a frame to the
+// next, so the algorithms with variable-size outputs have to size them for
+// the largest frame on the first one.
+//
+// Build against the headers and the library shipped with the app, eg:
+//
+//   c++ -std=c++11 -O2 -Iinclude -LFrameworks -lessentia
+//       benchmarks/allocation_check.cpp -o allocation_check
+//
+// Usage: allocation_check [--frames 200] [--algorithm name]
+//
+// The exit status is 1 if any of the algorithms allocated after its first
+// frame, so that the check can be run as part of a build.
+
+#include <essentia/algorithmfactory.h>
+#include <essentia/essentia.h>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace essentia;
+using namespace essentia::standard;
+
+
+// Every heap allocation of the process, essentia's included, goes through
+// these, so that the allocations of a run can be counted
+static atomic<long long> allocations(0);
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+
+static const Real sampleRate = 44100;
+static const int frameSize = 2048;
+static const int hopSize = 1024;
+
+
+// ---- Frames ----------------------------------------------------------------
+
+// Linear congruential generator, so that the signal does not depend on the
+// implementation of rand()
+class Noise {
+public:
+    explicit Noise(unsigned int seed) : _state(seed) {}
+
+    // uniform in [-1, 1)
+    Real next() {
+        _state = _state * 1664525u + 1013904223u;
+        return Real(_state >> 8) / Real(1 << 23) - 1;
+    }
+
+private:
+    unsigned int _state;
+};
+
+// The inputs of the algorithms, for each frame
+struct Frames {
+    vector<vector<Real> > audio;
+    vector<vector<complex<Real> > > fft;
+    vector<vector<Real> > spectrum;
+    vector<vector<Real> > phase;
+    vector<vector<Real> > frequencies;   // of the spectral peaks
+    vector<vector<Real> > magnitudes;
+};
+
+static Frames makeFrames(int numberFrames) {
+    Frames frames;
+    Noise noise(1);
+
+    // a chord of 1 to 6 notes, changing every 5 frames
+    int length = (numberFrames - 1) * hopSize + frameSize;
+    vector<Real> signal(length);
+    for (int i=0; i<length; i++) {
+        int chord = i / (5 * hopSize);
+        int notes = 1 + chord % 6;
+        Real value = 0.01 * noise.next();
+        for (int n=0; n<notes; n++) {
+            Real frequency = 110 * pow(2, (3*chord + 4*n) % 36 / 12.);
+            value += 0.2 * sin(2*M_PI*frequency * i / sampleRate);
+        }
+        signal[i] = value;
+    }
+
+    Algorithm* windowing = AlgorithmFactory::create("Windowing", "type", "hann", "size", frameSize);
+    Algorithm* fft = AlgorithmFactory::create("FFT", "size", frameSize);
+    Algorithm* polar = AlgorithmFactory::create("CartesianToPolar");
+    Algorithm* peaks = AlgorithmFactory::create("SpectralPeaks", "sampleRate", sampleRate,
+                                                "maxPeaks", 60, "orderBy", "magnitude");
+    vector<Real> windowed;
+
+    for (int f=0; f<numberFrames; f++) {
+        frames.audio.push_back(vector<Real>(signal.begin() + f*hopSize,
+                                            signal.begin() + f*hopSize + frameSize));
+        frames.fft.push_back(vector<complex<Real> >());
+        frames.spectrum.push_back(vector<Real>());
+        frames.phase.push_back(vector<Real>());
+        frames.frequencies.push_back(vector<Real>());
+        frames.magnitudes.push_back(vector<Real>());
+
+        windowing->input("frame").set(frames.audio[f]);
+        windowing->output("frame").set(windowed);
+        windowing->compute();
+        fft->input("frame").set(windowed);
+        fft->output("fft").set(frames.fft[f]);
+        fft->compute();
+        polar->input("complex").set(frames.fft[f]);
+        polar->output("magnitude").set(frames.spectrum[f]);
+        polar->output("phase").set(frames.phase[f]);
+        polar->compute();
+        peaks->input("spectrum").set(frames.spectrum[f]);
+        peaks->output("frequencies").set(frames.frequencies[f]);
+        peaks->output("magnitudes").set(frames.magnitudes[f]);
+        peaks->compute();
+    }
+
+    delete windowing;
+    delete fft;
+    delete polar;
+    delete peaks;
+    return frames;
+}
+
+
+// ---- Checks ----------------------------------------------------------------
+
+struct Check {
+    const char* name;
+    Algorithm* (*create)();
+};
+
+static const int spectrumSize = frameSize/2 + 1;
+
+static const Check checks[] = {
+    { "Windowing", [] { return AlgorithmFactory::create("Windowing", "size", frameSize); } },
+    { "FFT", [] { return AlgorithmFactory::create("FFT", "size", frameSize); } },
+    { "Spectrum", [] { return AlgorithmFactory::create("Spectrum", "size", frameSize); } },
+    { "PowerSpectrum", [] { return AlgorithmFactory::create("PowerSpectrum", "size", frameSize); } },
+    { "CartesianToPolar", [] { return AlgorithmFactory::create("CartesianToPolar"); } },
+    { "Magnitude", [] { return AlgorithmFactory::create("Magnitude"); } },
+
+    { "FrequencyBands", [] { return AlgorithmFactory::create("FrequencyBands"); } },
+    { "BarkBands", [] { return AlgorithmFactory::create("BarkBands"); } },
+    { "TriangularBands", [] { return AlgorithmFactory::create("TriangularBands", "inputSize", spectrumSize); } },
+    { "MelBands", [] { return AlgorithmFactory::create("MelBands", "inputSize", spectrumSize); } },
+    { "ERBBands", [] { return AlgorithmFactory::create("ERBBands", "inputSize", spectrumSize); } },
+    { "MFCC", [] { return AlgorithmFactory::create("MFCC", "inputSize", spectrumSize); } },
+    { "GFCC", [] { return AlgorithmFactory::create("GFCC", "inputSize", spectrumSize); } },
+    { "HFC", [] { return AlgorithmFactory::create("HFC"); } },
+    { "Flux", [] { return AlgorithmFactory::create("Flux"); } },
+    { "RollOff", [] { return AlgorithmFactory::create("RollOff"); } },
+    { "SpectralContrast", [] { return AlgorithmFactory::create("SpectralContrast", "frameSize", frameSize); } },
+    { "LogSpectrum", [] { return AlgorithmFactory::create("LogSpectrum", "frameSize", spectrumSize); } },
+
+    { "PeakDetection", [] { return AlgorithmFactory::create("PeakDetection", "maxPeaks", 100,
+                                                            "orderBy", "amplitude"); } },
+    { "SpectralPeaks", [] { return AlgorithmFactory::create("SpectralPeaks", "maxPeaks", 100,
+                                                            "orderBy", "magnitude"); } },
+    { "SineModelAnal", [] { return AlgorithmFactory::create("SineModelAnal"); } },
+    { "SpectralWhitening", [] { return AlgorithmFactory::create("SpectralWhitening"); } },
+
+    { "OnsetDetection hfc", [] { return AlgorithmFactory::create("OnsetDetection", "method", "hfc"); } },
+    { "OnsetDetection complex", [] { return AlgorithmFactory::create("OnsetDetection", "method", "complex"); } },
+    { "OnsetDetection complex_phase", [] { return AlgorithmFactory::create("OnsetDetection", "method", "complex_phase"); } },
+    { "OnsetDetection flux", [] { return AlgorithmFactory::create("OnsetDetection", "method", "flux"); } },
+    { "OnsetDetection melflux", [] { return AlgorithmFactory::create("OnsetDetection", "method", "melflux"); } },
+    { "OnsetDetection rms", [] { return AlgorithmFactory::create("OnsetDetection", "method", "rms"); } },
+    { "MultiOnsetDetection", [] { return AlgorithmFactory::create("MultiOnsetDetection"); } },
+
+    { "TuningFrequency", [] { return AlgorithmFactory::create("TuningFrequency"); } },
+    { "PitchYinFFT", [] { return AlgorithmFactory::create("PitchYinFFT", "frameSize", frameSize); } },
+    { "PitchSalience", [] { return AlgorithmFactory::create("PitchSalience"); } },
+    { "HPCP", [] { return AlgorithmFactory::create("HPCP"); } },
+    { "HPCP 36 bins, 8 harmonics", [] { return AlgorithmFactory::create("HPCP", "size", 36, "harmonics", 8,
+                                                                        "maxShifted", true); } },
+    { "MultiHPCP", [] {
+        int sizes[] = { 12, 36, 120 };
+        int harmonics[] = { 0, 8, 0 };
+        return AlgorithmFactory::create("MultiHPCP", "size", arrayToVector<int>(sizes),
+                                        "harmonics", arrayToVector<int>(harmonics)); } },
+};
+
+static const int numberChecks = sizeof(checks) / sizeof(checks[0]);
+
+// The outputs of an algorithm, kept for all the frames
+struct Outputs {
+    Real reals[8];
+    vector<Real> vectors[8];
+    vector<complex<Real> > complexVectors[8];
+    vector<vector<Real> > matrices[8];
+};
+
+static void bindOutputs(Algorithm* algorithm, Outputs& outputs) {
+    vector<string> names = algorithm->outputNames();
+    vector<const type_info*> types = algorithm->outputTypes();
+    int reals = 0, vectors = 0, complexVectors = 0, matrices = 0;
+
+    for (int i=0; i<(int)names.size(); i++) {
+        OutputBase& output = algorithm->output(names[i]);
+        if (sameType(*types[i], typeid(Real))) output.set(outputs.reals[reals++]);
+        else if (sameType(*types[i], typeid(vector<Real>))) output.set(outputs.vectors[vectors++]);
+        else if (sameType(*types[i], typeid(vector<complex<Real> >))) output.set(outputs.complexVectors[complexVectors++]);
+        else if (sameType(*types[i], typeid(vector<vector<Real> >))) output.set(outputs.matrices[matrices++]);
+        else throw EssentiaException("allocation_check: unsupported type for output ", names[i]);
+    }
+}
+
+// The data of each input of an algorithm, for all the frames
+struct Inputs {
+    vector<InputBase*> inputs;
+    vector<const vector<vector<Real> >*> reals;
+    vector<const vector<vector<complex<Real> > >*> complexes;
+
+    Inputs(Algorithm* algorithm, const Frames& frames) {
+        vector<string> names = algorithm->inputNames();
+        for (int i=0; i<(int)names.size(); i++) {
+            const string& name = names[i];
+            const vector<vector<Real> >* real = 0;
+            const vector<vector<complex<Real> > >* complex = 0;
+            if (name == "frame" || name == "signal") real = &frames.audio;
+            else if (name == "spectrum" || name == "array") real = &frames.spectrum;
+            else if (name == "phase") real = &frames.phase;
+            else if (name == "fft" || name == "complex") complex = &frames.fft;
+            else if (name == "frequencies") real = &frames.frequencies;
+            else if (name == "magnitudes") real = &frames.magnitudes;
+            else throw EssentiaException("allocation_check: no data for input ", name);
+
+            inputs.push_back(&algorithm->input(name));
+            reals.push_back(real);
+            complexes.push_back(complex);
+        }
+    }
+
+    void bind(int frame) {
+        for (int i=0; i<(int)inputs.size(); i++) {
+            if (reals[i]) inputs[i]->set((*reals[i])[frame]);
+            else inputs[i]->set((*complexes[i])[frame]);
+        }
+    }
+};
+
+// Returns the number of allocations after the first frame
+static long long run(const Check& check, const Frames& frames) {
+    Algorithm* algorithm = check.create();
+
+    Outputs* outputs = new Outputs();
+    bindOutputs(algorithm, *outputs);
+
+    Inputs inputs(algorithm, frames);
+    inputs.bind(0);
+    algorithm->compute();
+
+    long long before = allocations.load();
+    for (int f=1; f<(int)frames.audio.size(); f++) {
+        inputs.bind(f);
+        algorithm->compute();
+    }
+    long long count = allocations.load() - before;
+
+    delete outputs;
+    delete algorithm;
+    return count;
+}
+
+
+static void usage() {
+    fprintf(stderr, "usage: allocation_check [--frames 200] [--algorithm name]\n");
+}
+
+int main(int argc, char* argv[]) {
+    int numberFrames = 200;
+    string only;
+
+    for (int i=1; i<argc; i++) {
+        string arg = argv[i];
+        if (i+1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "--frames") numberFrames = max(2, atoi(argv[++i]));
+        else if (arg == "--algorithm") only = argv[++i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    // keep the report readable
+    infoLevelActive = false;
+    essentia::init();
+
+    Frames frames = makeFrames(numberFrames);
+
+    printf("%-30s %11s %9s\n", "algorithm", "allocations", "per frame");
+    int failures = 0;
+    for (int c=0; c<numberChecks; c++) {
+        if (!only.empty() && string(checks[c].name).find(only) == string::npos) continue;
+
+        try {
+            long long count = run(checks[c], frames);
+            printf("%-30s %11lld %9.2f%s\n", checks[c].name, count, double(count) / (numberFrames - 1),
+                   count ? "  FAILED" : "");
+            if (count) failures++;
+        }
+        catch (exception& e) {
+            printf("%-30s  error: %s\n", checks[c].name, e.what());
+            failures++;
+        }
+    }
+
+    printf("\n%d algorithm(s) allocating after their first frame\n", failures);
+    essentia::shutdown();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,287 @@
+// Checks MonoLoader against the chain it must be equivalent to: AudioLoader,
+// MonoMixer and Resample run one after the other on the whole file. Any
+// rewrite of the loading path of the app (eg: downmixing or resampling in
+// AudioLoader's conversion) has to pass it, built against the real FFmpeg,
+// before it is merged.
+//
+// Two test files are written first, 10s of 16-bit PCM at 44100Hz: a mono one
+// and a stereo one with different content on each channel (tones, a chirp and
+// noise), so that the downmix types give different signals. Other files can
+// be added with --file. Each file is loaded at each of the given sampling
+// rates (downsampling, none and upsampling by default), with each downmix
+// type, and the outputs of both paths are compared:
+//
+//   - length:  difference of the number of samples
+//   - latency: lag of the maximum of the cross-correlation, in samples of the
+//              output (positive when MonoLoader is late)
+//   - diff:    maximum absolute difference once aligned on that lag, and the
+//              ratio of the reference to the difference [dB]
+//
+// Build against the headers and the library shipped with the app (which links
+// FFmpeg), eg:
+//
+//   c++ -std=c++11 -O2 -Iinclude -LFrameworks -lessentia
+//       benchmarks/loader_check.cpp -o loader_check
+//
+// Usage: loader_check [--rates 22050,44100,48000] [--file audio.mp3]
+//                     [--tolerance 0.001] [--length 1]
+//
+// The exit status is 1 if, for any of the cases, the latency is not null, the
+// lengths differ by more than --length samples or the samples by more than
+// --tolerance.
+
+#include <essentia/algorithmfactory.h>
+#include <essentia/essentia.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace essentia;
+using namespace essentia::standard;
+
+
+static const int fileSampleRate = 44100;
+static const int maxLag = 256;
+
+
+// Linear congruential generator, so that the test files do not depend on the
+// implementation of rand()
+class Noise {
+public:
+    explicit Noise(unsigned int seed) : _state(seed) {}
+
+    // uniform in [-1, 1)
+    Real next() {
+        _state = _state * 1664525u + 1013904223u;
+        return Real(_state >> 8) / Real(1 << 23) - 1;
+    }
+
+private:
+    unsigned int _state;
+};
+
+
+// ---- Test files ------------------------------------------------------------
+
+static void writeLittleEndian(ofstream& out, unsigned int value, int bytes) {
+    for (int i=0; i<bytes; i++) out.put(char((value >> (8*i)) & 0xff));
+}
+
+static void writeWav(const string& filename, const vector<vector<Real> >& channels) {
+    int nChannels = channels.size();
+    unsigned int nSamples = channels[0].size();
+    unsigned int dataSize = nSamples * nChannels * 2;
+
+    ofstream out(filename.c_str(), ios::binary);
+    out.write("RIFF", 4);
+    writeLittleEndian(out, 36 + dataSize, 4);
+    out.write("WAVEfmt ", 8);
+    writeLittleEndian(out, 16, 4);
+    writeLittleEndian(out, 1, 2);  // PCM
+    writeLittleEndian(out, nChannels, 2);
+    writeLittleEndian(out, fileSampleRate, 4);
+    writeLittleEndian(out, fileSampleRate * nChannels * 2, 4);
+    writeLittleEndian(out, nChannels * 2, 2);
+    writeLittleEndian(out, 16, 2);
+    out.write("data", 4);
+    writeLittleEndian(out, dataSize, 4);
+
+    for (unsigned int i=0; i<nSamples; i++) {
+        for (int c=0; c<nChannels; c++) {
+            Real value = max(Real(-1), min(Real(1), channels[c][i]));
+            writeLittleEndian(out, (unsigned int)(int)lrint(value * 32767) & 0xffff, 2);
+        }
+    }
+}
+
+static vector<Real> createChannel(Real tone, Real chirpStart, unsigned int seed) {
+    vector<Real> signal(10 * fileSampleRate);
+    Noise noise(seed);
+    for (size_t i=0; i<signal.size(); i++) {
+        Real t = Real(i) / fileSampleRate;
+        // chirp over the whole band in 10s, to show the filtering of Resample
+        Real chirpFrequency = chirpStart + 1000 * t;
+        signal[i] = 0.3 * sin(2*M_PI*tone*t)
+                  + 0.2 * sin(2*M_PI*chirpFrequency*t)
+                  + 0.05 * noise.next();
+    }
+    return signal;
+}
+
+
+// ---- Loading ---------------------------------------------------------------
+
+// AudioLoader -> MonoMixer -> Resample
+static vector<Real> loadReference(const string& filename, Real sampleRate, const string& downmix) {
+    Algorithm* loader = AlgorithmFactory::create("AudioLoader", "filename", filename,
+                                                 "computeMD5", false);
+    vector<StereoSample> stereo;
+    Real fileRate;
+    int nChannels, bitRate;
+    string md5, codec;
+    loader->output("audio").set(stereo);
+    loader->output("sampleRate").set(fileRate);
+    loader->output("numberChannels").set(nChannels);
+    loader->output("md5").set(md5);
+    loader->output("bit_rate").set(bitRate);
+    loader->output("codec").set(codec);
+    loader->compute();
+    delete loader;
+
+    Algorithm* mixer = AlgorithmFactory::create("MonoMixer", "type", downmix);
+    vector<Real> mono;
+    mixer->input("audio").set(stereo);
+    mixer->input("numberChannels").set(nChannels);
+    mixer->output("audio").set(mono);
+    mixer->compute();
+    delete mixer;
+
+    Algorithm* resample = AlgorithmFactory::create("Resample", "inputSampleRate", fileRate,
+                                                   "outputSampleRate", sampleRate);
+    vector<Real> resampled;
+    resample->input("signal").set(mono);
+    resample->output("signal").set(resampled);
+    resample->compute();
+    delete resample;
+
+    return resampled;
+}
+
+static vector<Real> loadMono(const string& filename, Real sampleRate, const string& downmix) {
+    Algorithm* loader = AlgorithmFactory::create("MonoLoader", "filename", filename,
+                                                 "sampleRate", sampleRate,
+                                                 "downmix", downmix);
+    vector<Real> audio;
+    loader->output("audio").set(audio);
+    loader->compute();
+    delete loader;
+    return audio;
+}
+
+
+// ---- Comparison ------------------------------------------------------------
+
+struct Comparison {
+    int lengthDifference;
+    int latency;
+    Real maxDifference;
+    Real ratio;  // [dB]
+};
+
+static Comparison compare(const vector<Real>& reference, const vector<Real>& tested) {
+    Comparison result;
+    result.lengthDifference = int(tested.size()) - int(reference.size());
+
+    // lag of tested against reference with the most correlation
+    double bestCorrelation = 0;
+    result.latency = 0;
+    for (int lag=-maxLag; lag<=maxLag; lag++) {
+        double correlation = 0;
+        for (int i=max(0, -lag); i<int(reference.size()) && i+lag<int(tested.size()); i++) {
+            correlation += reference[i] * tested[i+lag];
+        }
+        if (correlation > bestCorrelation) {
+            bestCorrelation = correlation;
+            result.latency = lag;
+        }
+    }
+
+    result.maxDifference = 0;
+    double energy = 0, errorEnergy = 0;
+    int lag = result.latency;
+    for (int i=max(0, -lag); i<int(reference.size()) && i+lag<int(tested.size()); i++) {
+        Real difference = tested[i+lag] - reference[i];
+        result.maxDifference = max(result.maxDifference, (Real)fabs(difference));
+        energy += reference[i] * reference[i];
+        errorEnergy += difference * difference;
+    }
+    result.ratio = errorEnergy > 0 ? 10 * log10(energy / errorEnergy) : INFINITY;
+    return result;
+}
+
+
+static vector<int> parseList(const string& str) {
+    vector<int> values;
+    stringstream in(str);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) values.push_back(atoi(item.c_str()));
+    }
+    return values;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: loader_check [--rates 22050,44100,48000] [--file audio.mp3]\n"
+                    "                    [--tolerance 0.001] [--length 1]\n");
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> rates = parseList("22050,44100,48000");
+    vector<string> files;
+    Real tolerance = 0.001;
+    int lengthTolerance = 1;
+
+    for (int i=1; i<argc; i++) {
+        string arg = argv[i];
+        if (i+1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "--rates") rates = parseList(argv[++i]);
+        else if (arg == "--file") files.push_back(argv[++i]);
+        else if (arg == "--tolerance") tolerance = atof(argv[++i]);
+        else if (arg == "--length") lengthTolerance = atoi(argv[++i]);
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    vector<vector<Real> > channels(1, createChannel(440, 50, 1));
+    writeWav("loader_check_mono.wav", channels);
+    channels.push_back(createChannel(660, 2000, 2));
+    writeWav("loader_check_stereo.wav", channels);
+    files.insert(files.begin(), "loader_check_stereo.wav");
+    files.insert(files.begin(), "loader_check_mono.wav");
+
+    essentia::init();
+
+    printf("%-24s %6s %6s %8s %8s %7s %10s %8s %5s\n", "file", "rate", "mix", "samples",
+           "length", "latency", "diff", "[dB]", "");
+
+    const char* downmixes[] = { "mix", "left", "right" };
+    int failures = 0;
+    for (size_t f=0; f<files.size(); f++) {
+        for (size_t r=0; r<rates.size(); r++) {
+            for (int d=0; d<3; d++) {
+                vector<Real> reference = loadReference(files[f], rates[r], downmixes[d]);
+                vector<Real> tested = loadMono(files[f], rates[r], downmixes[d]);
+                Comparison c = compare(reference, tested);
+
+                bool ok = c.latency == 0 && abs(c.lengthDifference) <= lengthTolerance &&
+                          c.maxDifference <= tolerance;
+                if (!ok) failures++;
+
+                printf("%-24s %6d %6s %8d %+8d %+7d %10.2e %8.1f %5s\n", files[f].c_str(), rates[r],
+                       downmixes[d], (int)reference.size(), c.lengthDifference, c.latency,
+                       c.maxDifference, c.ratio, ok ? "ok" : "FAIL");
+            }
+        }
+    }
+
+    essentia::shutdown();
+    remove("loader_check_mono.wav");
+    remove("loader_check_stereo.wav");
+
+    if (failures) {
+        printf("\n%d case(s) where MonoLoader differs from AudioLoader -> MonoMixer -> Resample\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,736 @@
+// Benchmark of the rhythm and onset algorithms of essentia on synthetic
+// signals, reporting their speed, their memory use and their accuracy
+// against the tempo (and onsets) the signals were generated with.
+//
+// The signals are fully deterministic (their noise comes from a seeded
+// generator), so that two runs on the same machine can be compared, eg:
+// before and after a change to one of the algorithms:
+//
+//   - clicks: a click on each beat
+//   - noisy:  clicks on each beat, buried in white noise
+//   - mix:    kick, snare, hi-hats, bass line and chords, as in a simple song
+//
+// Each algorithm is run on each signal in a child process of its own, so
+// that the peak memory of one run does not hide the next ones. The same
+// algorithm instance is run --repeat times, the best time giving the
+// realtime factor (seconds of audio analyzed per second), and the last run
+// giving the number of heap allocations.
+//
+// The tempo estimates are scored as in the MIREX tempo evaluation:
+// accuracy1 if within 4% of the ground truth, accuracy2 if within 4% of the
+// ground truth or of its double, triple, half or third. SuperFluxExtractor
+// only finds onsets and is scored with the F-measure of its onsets, within
+// 50 ms of the ones in the signal.
+//
+// Build against the headers and the library shipped with the app, eg:
+//
+//   c++ -std=c++11 -O2 -Iinclude -LFrameworks -lessentia
+//       benchmarks/rhythm_benchmark.cpp -o rhythm_benchmark
+//
+// Usage: rhythm_benchmark [--length 10,30,120] [--repeat 3]
+//                         [--algorithm name] [--json results.json]
+
+#include <essentia/algorithmfactory.h>
+#include <essentia/essentia.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace essentia;
+using namespace essentia::standard;
+
+
+// Every heap allocation of the process, essentia's included, goes through
+// these, so that the allocations of a run can be counted
+static atomic<long long> allocations(0);
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+
+static const Real sampleRate = 44100;
+
+static size_t peakResidentMemory() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;         // bytes
+#else
+    return (size_t)usage.ru_maxrss * 1024;  // kilobytes
+#endif
+}
+
+
+// ---- Signals ---------------------------------------------------------------
+
+// Linear congruential generator, so that the signals do not depend on the
+// implementation of rand()
+class Noise {
+public:
+    explicit Noise(unsigned int seed) : _state(seed) {}
+
+    // uniform in [-1, 1)
+    Real next() {
+        _state = _state * 1664525u + 1013904223u;
+        return Real(_state >> 8) / Real(1 << 23) - 1;
+    }
+
+private:
+    unsigned int _state;
+};
+
+// tempi which are not a multiple of each other or of the frame rate
+static const char* signalNames[] = { "clicks", "noisy", "mix" };
+static const Real signalBpms[] = { 120, 97, 134 };
+static const int numberSignals = 3;
+
+struct Signal {
+    string name;
+    Real bpm;                // ground truth
+    vector<Real> onsets;     // ground truth [s]
+    vector<Real> audio;
+};
+
+static void addClick(vector<Real>& audio, size_t start, Real gain) {
+    // 1 kHz burst, decaying in about 10 ms
+    for (size_t i=0; i<2000 && start+i<audio.size(); i++) {
+        audio[start+i] += gain * exp(-Real(i) / 200) * sin(2*M_PI*1000*i / sampleRate);
+    }
+}
+
+static void addKick(vector<Real>& audio, size_t start, Real gain) {
+    // sine sweeping down from 150 to 50 Hz
+    Real phase = 0;
+    for (size_t i=0; i<8000 && start+i<audio.size(); i++) {
+        Real frequency = 50 + 100 * exp(-Real(i) / 1500);
+        phase += 2*M_PI*frequency / sampleRate;
+        audio[start+i] += gain * exp(-Real(i) / 3000) * sin(phase);
+    }
+}
+
+static void addNoiseBurst(vector<Real>& audio, size_t start, size_t length,
+                          Real decay, Real gain, bool highPass, Noise& noise) {
+    Real previous = 0;
+    for (size_t i=0; i<length && start+i<audio.size(); i++) {
+        Real value = noise.next();
+        Real sample = highPass ? value - previous : value;
+        previous = value;
+        audio[start+i] += gain * exp(-Real(i) / decay) * sample;
+    }
+}
+
+static Signal clicks(Real seconds, Real bpm) {
+    Signal signal;
+    signal.name = signalNames[0];
+    signal.bpm = bpm;
+    signal.audio.assign(size_t(seconds * sampleRate), 0);
+    Real period = 60 / bpm;
+    for (Real t=0.1; t<seconds; t+=period) {
+        addClick(signal.audio, size_t(t * sampleRate), 0.8);
+        signal.onsets.push_back(t);
+    }
+    return signal;
+}
+
+static Signal noisyClicks(Real seconds, Real bpm) {
+    Signal signal = clicks(seconds, bpm);
+    signal.name = signalNames[1];
+    Noise noise(1);
+    for (size_t i=0; i<signal.audio.size(); i++) signal.audio[i] += 0.15 * noise.next();
+    return signal;
+}
+
+static Signal mix(Real seconds, Real bpm) {
+    Signal signal;
+    signal.name = signalNames[2];
+    signal.bpm = bpm;
+    vector<Real>& audio = signal.audio;
+    audio.assign(size_t(seconds * sampleRate), 0);
+    Noise noise(2);
+
+    Real beat = 60 / bpm;
+    int numberBeats = int((seconds - 0.1) / beat);
+    for (int b=0; b<numberBeats; b++) {
+        Real t = 0.1 + b * beat;
+        size_t start = size_t(t * sampleRate);
+        addKick(audio, start, 0.7);
+        // snare on the 2nd and 4th beats of the bar
+        if (b % 4 == 1 || b % 4 == 3) {
+            addNoiseBurst(audio, start, 6000, 1500, 0.35, false, noise);
+        }
+        // hi-hats on the eighth notes
+        addNoiseBurst(audio, start, 1500, 300, 0.12, true, noise);
+        size_t offbeat = size_t((t + beat/2) * sampleRate);
+        addNoiseBurst(audio, offbeat, 1500, 300, 0.08, true, noise);
+        signal.onsets.push_back(t);
+        signal.onsets.push_back(t + beat/2);
+    }
+
+    // bass line and chords changing on each bar, a fourth below or above
+    static const int roots[4] = { 0, 5, -2, 3 };
+    for (size_t i=0; i<audio.size(); i++) {
+        Real t = i / sampleRate;
+        int bar = int(max(t - Real(0.1), Real(0)) / (4 * beat));
+        Real root = 55 * pow(2, roots[bar % 4] / 12.);
+        Real inBeat = fmod(max(t - Real(0.1), Real(0)), beat) / beat;
+        audio[i] += 0.15 * exp(-3 * inBeat) * sin(2*M_PI*root*t);
+        audio[i] += 0.03 * (sin(2*M_PI*4*root*t) +
+                            sin(2*M_PI*4*root*pow(2, 4/12.)*t) +
+                            sin(2*M_PI*4*root*pow(2, 7/12.)*t));
+        audio[i] += 0.01 * noise.next();
+    }
+
+    return signal;
+}
+
+static Signal makeSignal(int kind, Real seconds) {
+    switch (kind) {
+    case 0:  return clicks(seconds, signalBpms[kind]);
+    case 1:  return noisyClicks(seconds, signalBpms[kind]);
+    default: return mix(seconds, signalBpms[kind]);
+    }
+}
+
+
+// ---- Algorithms ------------------------------------------------------------
+
+// Runs one algorithm on a signal, can be called several times on the same
+// instance
+class Runner {
+public:
+    virtual ~Runner() {}
+    virtual void run(const vector<Real>& audio) = 0;
+    virtual bool estimatesTempo() const { return true; }
+    Real bpm;
+    vector<Real> onsets;
+};
+
+// BPM from the median interval between the ticks
+static Real ticksToBpm(const vector<Real>& ticks) {
+    if (ticks.size() < 2) return 0;
+    vector<Real> intervals;
+    for (size_t i=1; i<ticks.size(); i++) intervals.push_back(ticks[i] - ticks[i-1]);
+    nth_element(intervals.begin(), intervals.begin() + intervals.size()/2, intervals.end());
+    Real median = intervals[intervals.size()/2];
+    return median > 0 ? 60 / median : 0;
+}
+
+class RhythmExtractor2013Runner : public Runner {
+public:
+    explicit RhythmExtractor2013Runner(const string& method) {
+        _algo = AlgorithmFactory::create("RhythmExtractor2013", "method", method);
+    }
+    ~RhythmExtractor2013Runner() { delete _algo; }
+
+    void run(const vector<Real>& audio) {
+        Real confidence;
+        vector<Real> ticks, estimates, intervals;
+        _algo->reset();
+        _algo->input("signal").set(audio);
+        _algo->output("bpm").set(bpm);
+        _algo->output("ticks").set(ticks);
+        _algo->output("confidence").set(confidence);
+        _algo->output("estimates").set(estimates);
+        _algo->output("bpmIntervals").set(intervals);
+        _algo->compute();
+    }
+
+private:
+    Algorithm* _algo;
+};
+
+class BeatTrackerDegaraRunner : public Runner {
+public:
+    BeatTrackerDegaraRunner() { _algo = AlgorithmFactory::create("BeatTrackerDegara"); }
+    ~BeatTrackerDegaraRunner() { delete _algo; }
+
+    void run(const vector<Real>& audio) {
+        vector<Real> ticks;
+        _algo->reset();
+        _algo->input("signal").set(audio);
+        _algo->output("ticks").set(ticks);
+        _algo->compute();
+        bpm = ticksToBpm(ticks);
+    }
+
+private:
+    Algorithm* _algo;
+};
+
+// for the algorithms with a signal input and a bpm output
+class BpmRunner : public Runner {
+public:
+    explicit BpmRunner(const string& name) { _algo = AlgorithmFactory::create(name); }
+    ~BpmRunner() { delete _algo; }
+
+    void run(const vector<Real>& audio) {
+        _algo->reset();
+        _algo->input("signal").set(audio);
+        _algo->output("bpm").set(bpm);
+        _algo->compute();
+    }
+
+private:
+    Algorithm* _algo;
+};
+
+// BpmHistogram on the novelty curve of the frequency bands, which are
+// computed as part of the run
+class BpmHistogramRunner : public Runner {
+public:
+    BpmHistogramRunner() {
+        const int frameSize = 2048;
+        const int hopSize = 128;
+        Real frameRate = sampleRate / hopSize;
+        _frameCutter = AlgorithmFactory::create("FrameCutter", "frameSize", frameSize,
+                                                "hopSize", hopSize, "startFromZero", true);
+        _windowing = AlgorithmFactory::create("Windowing", "type", "blackmanharris62");
+        _spectrum = AlgorithmFactory::create("Spectrum", "size", frameSize);
+        _bands = AlgorithmFactory::create("FrequencyBands", "sampleRate", sampleRate);
+        _novelty = AlgorithmFactory::create("NoveltyCurve", "frameRate", frameRate,
+                                            "weightCurveType", "hybrid");
+        _histogram = AlgorithmFactory::create("BpmHistogram", "frameRate", frameRate,
+                                              "frameSize", 4.0, "overlap", 16,
+                                              "maxPeaks", 50, "minBpm", 30.0, "maxBpm", 560.0);
+    }
+
+    ~BpmHistogramRunner() {
+        delete _frameCutter;
+        delete _windowing;
+        delete _spectrum;
+        delete _bands;
+        delete _novelty;
+        delete _histogram;
+    }
+
+    void run(const vector<Real>& audio) {
+        vector<Real> frame, windowed, spectrum, bands;
+        vector<vector<Real> > allBands;
+        _frameCutter->reset();
+        _frameCutter->input("signal").set(audio);
+        _frameCutter->output("frame").set(frame);
+        _windowing->input("frame").set(frame);
+        _windowing->output("frame").set(windowed);
+        _spectrum->input("frame").set(windowed);
+        _spectrum->output("spectrum").set(spectrum);
+        _bands->input("spectrum").set(spectrum);
+        _bands->output("bands").set(bands);
+        while (true) {
+            _frameCutter->compute();
+            if (frame.empty()) break;
+            _windowing->compute();
+            _spectrum->compute();
+            _bands->compute();
+            allBands.push_back(bands);
+        }
+
+        vector<Real> novelty;
+        _novelty->reset();
+        _novelty->input("frequencyBands").set(allBands);
+        _novelty->output("novelty").set(novelty);
+        _novelty->compute();
+
+        vector<Real> candidates, magnitudes, frameBpms, ticks, ticksMagnitude, sinusoid;
+        TNT::Array2D<Real> tempogram;
+        _histogram->reset();
+        _histogram->input("novelty").set(novelty);
+        _histogram->output("bpm").set(bpm);
+        _histogram->output("bpmCandidates").set(candidates);
+        _histogram->output("bpmMagnitudes").set(magnitudes);
+        _histogram->output("tempogram").set(tempogram);
+        _histogram->output("frameBpms").set(frameBpms);
+        _histogram->output("ticks").set(ticks);
+        _histogram->output("ticksMagnitude").set(ticksMagnitude);
+        _histogram->output("sinusoid").set(sinusoid);
+        _histogram->compute();
+    }
+
+private:
+    Algorithm* _frameCutter;
+    Algorithm* _windowing;
+    Algorithm* _spectrum;
+    Algorithm* _bands;
+    Algorithm* _novelty;
+    Algorithm* _histogram;
+};
+
+class SuperFluxRunner : public Runner {
+public:
+    SuperFluxRunner() { _algo = AlgorithmFactory::create("SuperFluxExtractor"); }
+    ~SuperFluxRunner() { delete _algo; }
+
+    bool estimatesTempo() const { return false; }
+
+    void run(const vector<Real>& audio) {
+        _algo->reset();
+        _algo->input("signal").set(audio);
+        _algo->output("onsets").set(onsets);
+        _algo->compute();
+    }
+
+private:
+    Algorithm* _algo;
+};
+
+// TempoTap, through the RhythmExtractor which feeds it with the frequency
+// bands and onset detection functions of each frame
+class TempoTapRunner : public Runner {
+public:
+    TempoTapRunner() { _algo = AlgorithmFactory::create("RhythmExtractor"); }
+    ~TempoTapRunner() { delete _algo; }
+
+    void run(const vector<Real>& audio) {
+        vector<Real> ticks, estimates, intervals;
+        _algo->reset();
+        _algo->input("signal").set(audio);
+        _algo->output("bpm").set(bpm);
+        _algo->output("ticks").set(ticks);
+        _algo->output("estimates").set(estimates);
+        _algo->output("bpmIntervals").set(intervals);
+        _algo->compute();
+    }
+
+private:
+    Algorithm* _algo;
+};
+
+static const char* algorithmNames[] = {
+    "RhythmExtractor2013-multifeature",
+    "RhythmExtractor2013-degara",
+    "BeatTrackerDegara",
+    "PercivalBpmEstimator",
+    "LoopBpmEstimator",
+    "BpmHistogram",
+    "SuperFluxExtractor",
+    "TempoTap"
+};
+
+static const int numberAlgorithms = sizeof(algorithmNames) / sizeof(algorithmNames[0]);
+
+static Runner* createRunner(int algorithm) {
+    switch (algorithm) {
+    case 0:  return new RhythmExtractor2013Runner("multifeature");
+    case 1:  return new RhythmExtractor2013Runner("degara");
+    case 2:  return new BeatTrackerDegaraRunner();
+    case 3:  return new BpmRunner("PercivalBpmEstimator");
+    case 4:  return new BpmRunner("LoopBpmEstimator");
+    case 5:  return new BpmHistogramRunner();
+    case 6:  return new SuperFluxRunner();
+    default: return new TempoTapRunner();
+    }
+}
+
+
+// ---- Scores ----------------------------------------------------------------
+
+static bool withinTolerance(Real estimate, Real truth) {
+    return fabs(estimate - truth) <= 0.04 * truth;
+}
+
+static bool accuracy1(Real estimate, Real truth) {
+    return withinTolerance(estimate, truth);
+}
+
+static bool accuracy2(Real estimate, Real truth) {
+    static const Real factors[] = { 1, 2, 3, 1/2., 1/3. };
+    for (int i=0; i<5; i++) {
+        if (withinTolerance(estimate, truth * factors[i])) return true;
+    }
+    return false;
+}
+
+// F-measure of the detected onsets, each one of the ground truth being
+// matched at most once
+static Real onsetFMeasure(const vector<Real>& detected, const vector<Real>& truth) {
+    if (detected.empty() || truth.empty()) return 0;
+    const Real tolerance = 0.05;
+    vector<char> matched(truth.size(), 0);
+    int hits = 0;
+    for (size_t i=0; i<detected.size(); i++) {
+        size_t j = lower_bound(truth.begin(), truth.end(), detected[i] - tolerance) - truth.begin();
+        for (; j<truth.size() && truth[j] <= detected[i] + tolerance; j++) {
+            if (!matched[j]) {
+                matched[j] = 1;
+                hits++;
+                break;
+            }
+        }
+    }
+    Real precision = Real(hits) / detected.size();
+    Real recall = Real(hits) / truth.size();
+    return precision + recall > 0 ? 2 * precision * recall / (precision + recall) : 0;
+}
+
+
+// ---- Runs ------------------------------------------------------------------
+
+// written by the child process to its parent
+struct Result {
+    int ok;
+    char error[256];
+    int estimatesTempo;      // otherwise, onsets only
+    double bestSeconds;
+    double firstSeconds;     // includes building the plans, tables, etc.
+    double bpm;
+    double fMeasure;
+    long long allocations;   // during the last run
+    double peakMemory;       // above what the signal takes [bytes]
+};
+
+static Result runCase(int algorithm, int signalKind, Real seconds, int repeat) {
+    Result result;
+    memset(&result, 0, sizeof(result));
+
+    try {
+        Signal signal = makeSignal(signalKind, seconds);
+        size_t baseline = peakResidentMemory();
+
+        Runner* runner = createRunner(algorithm);
+        result.bestSeconds = 1e9;
+        for (int r=0; r<repeat; r++) {
+            long long before = allocations.load();
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            runner->run(signal.audio);
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            result.allocations = allocations.load() - before;
+            if (r == 0) result.firstSeconds = elapsed;
+            result.bestSeconds = min(result.bestSeconds, elapsed);
+        }
+
+        size_t peak = peakResidentMemory();
+        result.peakMemory = peak > baseline ? double(peak - baseline) : 0;
+        result.estimatesTempo = runner->estimatesTempo();
+        result.bpm = runner->bpm;
+        result.fMeasure = result.estimatesTempo ? 0 : onsetFMeasure(runner->onsets, signal.onsets);
+        result.ok = 1;
+        delete runner;
+    }
+    catch (exception& e) {
+        snprintf(result.error, sizeof(result.error), "%s", e.what());
+    }
+    return result;
+}
+
+// Runs the case in a child process, so that its peak memory is its own
+static Result runIsolated(int algorithm, int signalKind, Real seconds, int repeat) {
+    Result result;
+    memset(&result, 0, sizeof(result));
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        snprintf(result.error, sizeof(result.error), "cannot create pipe");
+        return result;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        // keep the report readable
+        infoLevelActive = false;
+        essentia::init();
+        Result childResult = runCase(algorithm, signalKind, seconds, repeat);
+        ssize_t written = write(fds[1], &childResult, sizeof(childResult));
+        _exit(written == (ssize_t)sizeof(childResult) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        snprintf(result.error, sizeof(result.error), "cannot fork");
+        return result;
+    }
+
+    size_t got = 0;
+    while (got < sizeof(result)) {
+        ssize_t n = read(fds[0], (char*)&result + got, sizeof(result) - got);
+        if (n <= 0) break;
+        got += n;
+    }
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (got < sizeof(result)) {
+        memset(&result, 0, sizeof(result));
+        snprintf(result.error, sizeof(result.error), "crashed (status %d)", status);
+    }
+    return result;
+}
+
+
+// ---- Report ----------------------------------------------------------------
+
+struct Case {
+    int algorithm;
+    string signal;
+    Real seconds;
+    Real truth;
+    Result result;
+};
+
+static vector<Real> parseList(const string& str) {
+    vector<Real> values;
+    stringstream in(str);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) values.push_back(atof(item.c_str()));
+    }
+    return values;
+}
+
+static void writeJson(const string& filename, const vector<Case>& cases, int repeat) {
+    ofstream out(filename.c_str());
+    out << "{\"essentiaVersion\": \"" << essentia::version << "\", \"repeat\": " << repeat
+        << ", \"cases\": [";
+    for (size_t i=0; i<cases.size(); i++) {
+        const Case& c = cases[i];
+        const Result& r = c.result;
+        out << (i ? ",\n  " : "\n  ")
+            << "{\"algorithm\": \"" << algorithmNames[c.algorithm] << "\""
+            << ", \"signal\": \"" << c.signal << "\""
+            << ", \"seconds\": " << c.seconds
+            << ", \"ok\": " << (r.ok ? "true" : "false");
+        if (r.ok) {
+            out << ", \"realtimeFactor\": " << c.seconds / r.bestSeconds
+                << ", \"bestSeconds\": " << r.bestSeconds
+                << ", \"firstSeconds\": " << r.firstSeconds
+                << ", \"peakMemory\": " << (long long)r.peakMemory
+                << ", \"allocations\": " << r.allocations;
+            if (r.estimatesTempo) {
+                out << ", \"bpm\": " << r.bpm << ", \"groundTruthBpm\": " << c.truth
+                    << ", \"accuracy1\": " << (accuracy1(r.bpm, c.truth) ? "true" : "false")
+                    << ", \"accuracy2\": " << (accuracy2(r.bpm, c.truth) ? "true" : "false");
+            }
+            else {
+                out << ", \"onsetFMeasure\": " << r.fMeasure;
+            }
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+}
+
+static void usage() {
+    fprintf(stderr, "usage: rhythm_benchmark [--length 10,30,120] [--repeat 3] "
+                    "[--algorithm name] [--json results.json]\nalgorithms:");
+    for (int i=0; i<numberAlgorithms; i++) fprintf(stderr, " %s", algorithmNames[i]);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char* argv[]) {
+    vector<Real> lengths = parseList("10,30,120");
+    int repeat = 3;
+    string only;
+    string jsonFile;
+
+    for (int i=1; i<argc; i++) {
+        string arg = argv[i];
+        if (i+1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "--length") lengths = parseList(argv[++i]);
+        else if (arg == "--repeat") repeat = max(1, atoi(argv[++i]));
+        else if (arg == "--algorithm") only = argv[++i];
+        else if (arg == "--json") jsonFile = argv[++i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    printf("%-33s %-7s %6s %7s %8s %5s %9s %8s %11s\n", "algorithm", "signal", "length",
+           "truth", "estimate", "score", "realtime", "peak MB", "allocations");
+
+    vector<Case> cases;
+    for (int a=0; a<numberAlgorithms; a++) {
+        if (!only.empty() && string(algorithmNames[a]).find(only) == string::npos) continue;
+
+        int runs = 0, tempoRuns = 0, hits1 = 0, hits2 = 0;
+        double audioSeconds = 0, computeSeconds = 0;
+        for (int s=0; s<numberSignals; s++) {
+            for (size_t l=0; l<lengths.size(); l++) {
+                Case c;
+                c.algorithm = a;
+                c.seconds = lengths[l];
+                c.signal = signalNames[s];
+                c.truth = signalBpms[s];
+                c.result = runIsolated(a, s, c.seconds, repeat);
+                cases.push_back(c);
+
+                const Result& r = c.result;
+                if (!r.ok) {
+                    printf("%-33s %-7s %6.0f  failed: %s\n", algorithmNames[a], c.signal.c_str(),
+                           c.seconds, r.error);
+                    continue;
+                }
+
+                bool tempo = r.estimatesTempo;
+                char score[16];
+                if (tempo) {
+                    snprintf(score, sizeof(score), "%s", accuracy1(r.bpm, c.truth) ? "acc1" :
+                                                         accuracy2(r.bpm, c.truth) ? "acc2" : "-");
+                }
+                else {
+                    snprintf(score, sizeof(score), "%.2f", r.fMeasure);
+                }
+                char truth[16] = "-", estimate[16] = "-";
+                if (tempo) {
+                    snprintf(truth, sizeof(truth), "%.1f", c.truth);
+                    snprintf(estimate, sizeof(estimate), "%.1f", r.bpm);
+                }
+                printf("%-33s %-7s %6.0f %7s %8s %5s %8.1fx %8.1f %11lld\n",
+                       algorithmNames[a], c.signal.c_str(), c.seconds, truth, estimate, score,
+                       c.seconds / r.bestSeconds, r.peakMemory / (1024 * 1024), r.allocations);
+
+                runs++;
+                tempoRuns += tempo;
+                hits1 += tempo && accuracy1(r.bpm, c.truth);
+                hits2 += tempo && accuracy2(r.bpm, c.truth);
+                audioSeconds += c.seconds;
+                computeSeconds += r.bestSeconds;
+            }
+        }
+
+        if (runs > 0) {
+            printf("%-33s overall %.1fx realtime", algorithmNames[a], audioSeconds / computeSeconds);
+            if (tempoRuns > 0) {
+                printf(", accuracy1 %d%%, accuracy2 %d%%", 100 * hits1 / tempoRuns, 100 * hits2 / tempoRuns);
+            }
+            printf("\n\n");
+        }
+    }
+
+    if (!jsonFile.empty()) writeJson(jsonFile, cases, repeat);
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Checks that loading a slice of a file with MonoLoader (startTime, endTime),
+// which seeks in the file and only decodes the slice, gives the same samples
+// as loading the whole file and trimming it with Trimmer. The fast BPM
+// analysis of the app loads its excerpts this way, and shifts the ticks found
+// by the start of the excerpt.
+//
+// The cases worth running it on are the ones where the position reached by
+// seeking is hard to get right: mp3 files (CBR and VBR, with and without an
+// encoder delay header), AAC in mp4/m4a files (priming samples) and raw ADTS
+// AAC, plus a lossless format as a control. Each file is loaded whole at each
+// of the given sampling rates (resampled or not), then slices of --length
+// seconds are loaded: one starting near the beginning (within the first
+// second, which is not seeked to) and ones starting at 10%, 50% and 80% of
+// the file. For each slice, the output of MonoLoader is compared with the
+// trimmed whole file:
+//
+//   - length:  difference of the number of samples
+//   - offset:  lag of the maximum of the cross-correlation, in samples
+//              (positive when the slice starts before startTime)
+//   - diff:    maximum absolute difference once aligned on that lag
+//
+// Build against the headers and the library shipped with the app (which links
+// FFmpeg), eg:
+//
+//   c++ -std=c++11 -O2 -Iinclude -LFrameworks -lessentia
+//       benchmarks/slice_check.cpp -o slice_check
+//
+// Usage: slice_check [--rates 44100,22050] [--length 30] [--tolerance 0.0001]
+//                    file...
+//
+// The exit status is 1 if, for any of the slices, the offset is not null, or
+// the length or the samples differ (by more than --tolerance).
+
+#include <essentia/algorithmfactory.h>
+#include <essentia/essentia.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace essentia;
+using namespace essentia::standard;
+
+
+// the offset is searched for within maxLag samples, over the first
+// correlationLength samples of the slices
+static const int maxLag = 2048;
+static const int correlationLength = 65536;
+
+
+static vector<Real> load(const string& filename, Real sampleRate,
+                         Real startTime = 0, Real endTime = 1e6) {
+    Algorithm* loader = AlgorithmFactory::create("MonoLoader", "filename", filename,
+                                                 "sampleRate", sampleRate,
+                                                 "startTime", startTime,
+                                                 "endTime", endTime);
+    vector<Real> audio;
+    loader->output("audio").set(audio);
+    loader->compute();
+    delete loader;
+    return audio;
+}
+
+static vector<Real> trim(const vector<Real>& audio, Real sampleRate, Real startTime, Real endTime) {
+    Algorithm* trimmer = AlgorithmFactory::create("Trimmer", "sampleRate", sampleRate,
+                                                  "startTime", startTime,
+                                                  "endTime", endTime);
+    vector<Real> trimmed;
+    trimmer->input("signal").set(audio);
+    trimmer->output("signal").set(trimmed);
+    trimmer->compute();
+    delete trimmer;
+    return trimmed;
+}
+
+
+struct Comparison {
+    int lengthDifference;
+    int offset;
+    Real maxDifference;
+};
+
+static Comparison compare(const vector<Real>& reference, const vector<Real>& tested) {
+    Comparison result;
+    result.lengthDifference = int(tested.size()) - int(reference.size());
+
+    // lag of tested against reference with the most correlation
+    double bestCorrelation = 0;
+    result.offset = 0;
+    int size = min((int)reference.size(), correlationLength);
+    for (int lag=-maxLag; lag<=maxLag; lag++) {
+        double correlation = 0;
+        for (int i=max(0, -lag); i<size && i+lag<int(tested.size()); i++) {
+            correlation += reference[i] * tested[i+lag];
+        }
+        if (correlation > bestCorrelation) {
+            bestCorrelation = correlation;
+            result.offset = lag;
+        }
+    }
+
+    result.maxDifference = 0;
+    int lag = result.offset;
+    for (int i=max(0, -lag); i<int(reference.size()) && i+lag<int(tested.size()); i++) {
+        result.maxDifference = max(result.maxDifference, (Real)fabs(tested[i+lag] - reference[i]));
+    }
+    return result;
+}
+
+
+static vector<int> parseList(const string& str) {
+    vector<int> values;
+    stringstream in(str);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) values.push_back(atoi(item.c_str()));
+    }
+    return values;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: slice_check [--rates 44100,22050] [--length 30] [--tolerance 0.0001]\n"
+                    "                   file...\n");
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> rates = parseList("44100,22050");
+    Real length = 30;
+    Real tolerance = 0.0001;
+    vector<string> files;
+
+    for (int i=1; i<argc; i++) {
+        string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            files.push_back(arg);
+            continue;
+        }
+        if (i+1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "--rates") rates = parseList(argv[++i]);
+        else if (arg == "--length") length = atof(argv[++i]);
+        else if (arg == "--tolerance") tolerance = atof(argv[++i]);
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (files.empty()) {
+        usage();
+        return 1;
+    }
+
+    essentia::init();
+
+    printf("%-32s %6s %9s %9s %8s %8s %7s %10s %5s\n", "file", "rate", "start [s]", "end [s]",
+           "samples", "length", "offset", "diff", "");
+
+    const Real positions[] = { 0, 0.1, 0.5, 0.8 };
+    int failures = 0;
+    for (size_t f=0; f<files.size(); f++) {
+        for (size_t r=0; r<rates.size(); r++) {
+            Real sampleRate = rates[r];
+            vector<Real> whole = load(files[f], sampleRate);
+            Real duration = whole.size() / sampleRate;
+
+            for (int p=0; p<4; p++) {
+                // the first slice starts at an odd time, but before the
+                // preroll of the seeking
+                Real startTime = p == 0 ? 0.3217 : positions[p] * duration;
+                Real endTime = min(startTime + length, duration);
+                if (startTime >= endTime) continue;
+
+                vector<Real> reference = trim(whole, sampleRate, startTime, endTime);
+                vector<Real> slice = load(files[f], sampleRate, startTime, endTime);
+                Comparison c = compare(reference, slice);
+
+                bool ok = c.offset == 0 && c.lengthDifference == 0 && c.maxDifference <= tolerance;
+                if (!ok) failures++;
+
+                printf("%-32s %6d %9.3f %9.3f %8d %+8d %+7d %10.2e %5s\n", files[f].c_str(), rates[r],
+                       startTime, endTime, (int)reference.size(), c.lengthDifference, c.offset,
+                       c.maxDifference, ok ? "ok" : "FAIL");
+            }
+        }
+    }
+
+    essentia::shutdown();
+
+    if (failures) {
+        printf("\n%d slice(s) differing from the trimmed whole file\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+// Benchmark of the Viterbi decoding of the beat periods in TempoTapDegara
+// (findViterbiPath): the banded decoder of the algorithm against the full
+// search over all the states it replaced, checking that both find the same
+// path.
+//
+// The banded decoder is the one of the library, called through the entry
+// point TempoTapDegara exposes for this. The full search is the code of the
+// algorithm before the banded version, kept here as the reference only, and
+// runs on the prior and transition matrix of the algorithm (viterbiModel).
+//
+// The observations are deterministic (their noise comes from a seeded
+// generator) and look like the ones of TempoTapDegara: one normalized
+// weighting of the beat periods per frame, null out of the default tempo
+// range, plus the small noise added by the algorithm.
+//
+//   - tempo:   peaks at a beat period drifting over time and at its
+//              multiples, over a floor of noise
+//   - noise:   noise only
+//   - silence: null observations, for which the decoders fall back to the
+//              first state
+//
+// Build against the headers and the library shipped with the app, eg:
+//
+//   c++ -std=c++11 -O2 -Iinclude -Iinclude/essentia -Iinclude/essentia/utils
+//       -LFrameworks -lessentia benchmarks/viterbi_benchmark.cpp
+//       -o viterbi_benchmark
+//
+// Usage: viterbi_benchmark [--frames 500,4000] [--resample 1,3] [--repeat 3]
+//
+// The number of frames is the one of the ODF frames of TempoTapDegara: about
+// 0.67 per second of audio. The exit status is 1 if the paths of the two
+// decoders differ for any of the cases.
+
+#include <essentia/algorithmfactory.h>
+#include <essentia/essentia.h>
+#include <essentia/essentiamath.h>
+#include <algorithms/rhythm/tempotapdegara.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace essentia;
+using namespace essentia::standard;
+
+
+// Linear congruential generator, so that the observations do not depend on
+// the implementation of rand()
+class Noise {
+public:
+    explicit Noise(unsigned int seed) : _state(seed) {}
+
+    // uniform in [0, 1)
+    Real next() {
+        _state = _state * 1664525u + 1013904223u;
+        return Real(_state >> 8) / Real(1 << 24);
+    }
+
+private:
+    unsigned int _state;
+};
+
+
+// ---- Model ---------------------------------------------------------------
+
+struct Model {
+    TempoTapDegara* algorithm;
+    Real sampleRateODF;
+    int numberPeriods;
+    vector<Real> prior;
+    vector<vector<Real> > transitions;
+    int periodMinUserIndex;
+    int periodMaxUserIndex;
+};
+
+static Model createModel(int resample) {
+    // default parameters of TempoTapDegara
+    const Real minTempo = 40;
+    const Real maxTempo = 208;
+    const char* resampleNames[] = { "none", "x2", "x3", "x4" };
+
+    Model model;
+    model.algorithm = dynamic_cast<TempoTapDegara*>(
+        AlgorithmFactory::create("TempoTapDegara", "resample", resampleNames[resample-1]));
+    model.algorithm->viterbiModel(model.prior, model.transitions);
+    model.sampleRateODF = 44100. / 512 * resample;
+    model.numberPeriods = model.prior.size();
+    model.periodMaxUserIndex = min((int)ceil(60. / minTempo * model.sampleRateODF) - 1, model.numberPeriods - 1);
+    model.periodMinUserIndex = max((int)floor(60. / maxTempo * model.sampleRateODF) - 1, 0);
+    return model;
+}
+
+
+// ---- Observations ----------------------------------------------------------
+
+static const char* observationNames[] = { "tempo", "noise", "silence" };
+static const int numberObservations = 3;
+
+static vector<vector<Real> > createObservations(const Model& model, const string& name,
+                                                int numberFrames) {
+    int numberPeriods = model.numberPeriods;
+    vector<vector<Real> > observations(numberFrames, vector<Real>(numberPeriods, (Real) 0.));
+    Noise noise(1);
+    Real observationsMax = 0;
+
+    for (int t=0; t<numberFrames; ++t) {
+        vector<Real>& frame = observations[t];
+        if (name == "tempo") {
+            // from 90 to 150 BPM and back every 200 frames (about 5 minutes)
+            Real bpm = 120 + 30 * sin(2*M_PI*t / 200);
+            Real period = 60 * model.sampleRateODF / bpm;
+            for (int i=0; i<numberPeriods; ++i) {
+                frame[i] = 0.2 * noise.next();
+                for (int k=1; k<=3; ++k) {
+                    Real distance = (i+1 - k*period) / (2 * model.sampleRateODF / (44100./512));
+                    frame[i] += exp(-0.5 * distance*distance) / k;
+                }
+            }
+        }
+        else if (name == "noise") {
+            for (int i=0; i<numberPeriods; ++i) frame[i] = noise.next();
+        }
+
+        fill(frame.begin(), frame.begin() + model.periodMinUserIndex+1, (Real) 0.);
+        fill(frame.begin() + model.periodMaxUserIndex+1, frame.end(), (Real) 0.);
+        normalizeSum(frame);
+        observationsMax = max(observationsMax, frame[argmax(frame)]);
+    }
+
+    for (int t=0; t<numberFrames; ++t) {
+        for (int i=0; i<numberPeriods; ++i) {
+            observations[t][i] += 0.0001 * observationsMax * noise.next();
+        }
+    }
+    return observations;
+}
+
+
+// ---- Decoders --------------------------------------------------------------
+
+// TempoTapDegara::findViterbiPath before the banded version: full search over
+// all the predecessors of each state
+static void findViterbiPathFull(const Model& model, const vector<vector<Real> >& observations,
+                                vector<Real>& path) {
+    size_t numberFramesODF = observations.size();
+    const vector<Real>& prior = model.prior;
+    const vector<vector<Real> >& transitionMatrix = model.transitions;
+    int numberPeriods = prior.size();
+
+    vector<vector<Real> > delta;
+    vector<vector<Real> > psi;
+
+    vector<Real> deltaNew;
+    deltaNew.resize(numberPeriods);
+
+    for (int i=0; i<numberPeriods; ++i) {
+        deltaNew[i] = prior[i] * observations[0][i];
+    }
+    normalizeSum(deltaNew);
+    delta.push_back(deltaNew);
+
+    vector<Real> psiNew;
+    psiNew.resize(numberPeriods);
+    psi.push_back(psiNew);
+
+    vector<Real> tmp;
+    tmp.resize(numberPeriods);
+
+    for (size_t t=1; t<numberFramesODF; ++t) {
+        for (int j=0; j<numberPeriods; ++j) {
+            for (int i=0; i<numberPeriods; ++i) {
+                tmp[i] = delta.back()[i] * transitionMatrix[j][i];
+            }
+            int iMax = argmax(tmp);
+            deltaNew[j] = tmp[iMax] * observations[t][j];
+            psiNew[j] = iMax;
+        }
+        normalizeSum(deltaNew);
+        delta.push_back(deltaNew);
+        psi.push_back(psiNew);
+    }
+
+    path.resize(numberFramesODF);
+    path.back() = argmax(delta.back());
+    if (numberFramesODF >= 2) {
+        for (size_t t=numberFramesODF-2;; --t) {
+            path[t] = psi[t+1][path[t+1]];
+            if (t==0) {
+                break;
+            }
+        }
+    }
+}
+
+// TempoTapDegara::findViterbiPath, from the library
+static void findViterbiPathBanded(const Model& model, const vector<vector<Real> >& observations,
+                                  vector<Real>& path) {
+    model.algorithm->findViterbiPath(observations, path);
+}
+
+
+// ---- Runs ------------------------------------------------------------------
+
+typedef void (*Decoder)(const Model&, const vector<vector<Real> >&, vector<Real>&);
+
+// best time of the given number of runs [s]
+static double timeDecoder(Decoder decoder, const Model& model,
+                          const vector<vector<Real> >& observations,
+                          int repeat, vector<Real>& path) {
+    double best = 0;
+    for (int r=0; r<repeat; r++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        decoder(model, observations, path);
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (r == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+static vector<int> parseList(const string& str) {
+    vector<int> values;
+    stringstream in(str);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) values.push_back(atoi(item.c_str()));
+    }
+    return values;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: viterbi_benchmark [--frames 500,4000] [--resample 1,3] [--repeat 3]\n");
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> frames = parseList("500,4000");
+    vector<int> resamples = parseList("1,3");
+    int repeat = 3;
+
+    essentia::init();
+
+    for (int i=1; i<argc; i++) {
+        string arg = argv[i];
+        if (i+1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "--frames") frames = parseList(argv[++i]);
+        else if (arg == "--resample") resamples = parseList(argv[++i]);
+        else if (arg == "--repeat") repeat = max(1, atoi(argv[++i]));
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    printf("%-8s %8s %6s %7s %12s %12s %8s %5s\n", "input", "resample", "states", "frames",
+           "full [ms]", "banded [ms]", "speedup", "path");
+
+    int differences = 0;
+    for (size_t r=0; r<resamples.size(); r++) {
+        if (resamples[r] < 1 || resamples[r] > 4) {
+            fprintf(stderr, "resample must be in [1,4], as in TempoTapDegara\n");
+            return 1;
+        }
+        Model model = createModel(resamples[r]);
+
+        for (size_t f=0; f<frames.size(); f++) {
+            if (frames[f] < 1) continue;
+            for (int o=0; o<numberObservations; o++) {
+                vector<vector<Real> > observations = createObservations(model, observationNames[o], frames[f]);
+                vector<Real> fullPath, bandedPath;
+                double full = timeDecoder(findViterbiPathFull, model, observations, repeat, fullPath);
+                double banded = timeDecoder(findViterbiPathBanded, model, observations, repeat, bandedPath);
+                bool same = fullPath == bandedPath;
+                if (!same) differences++;
+
+                printf("%-8s %8d %6d %7d %12.2f %12.2f %7.1fx %5s\n", observationNames[o],
+                       resamples[r], model.numberPeriods, frames[f], full * 1000, banded * 1000,
+                       full / banded, same ? "same" : "DIFF");
+            }
+        }
+        delete model.algorithm;
+    }
+    essentia::shutdown();
+
+    if (differences) {
+        printf("\n%d case(s) where the banded path differs from the full search\n", differences);
+        return 1;
+    }
+    return 0;
+}
@@ -98,6 +98,8 @@
 #include "algorithms/spectral/panning.h"
 #include "algorithms/spectral/gfcc.h"
 #include "algorithms/spectral/hpcp.h"
+#include "algorithms/spectral/multihpcp.h"
+#include "algorithms/spectral/hpcpselector.h"
 #include "algorithms/spectral/strongpeak.h"
 #include "algorithms/spectral/rolloff.h"
 #include "algorithms/spectral/flux.h"
@@ -184,6 +186,7 @@
 #include "algorithms/standard/ifftw.h"
 #include "algorithms/standard/stereodemuxer.h"
 #include "algorithms/rhythm/onsetdetectionglobal.h"
+#include "algorithms/rhythm/spectralonsetdetectionglobal.h"
 #include "algorithms/rhythm/percivalenhanceharmonics.h"
 #include "algorithms/rhythm/bpmhistogramdescriptors.h"
 #include "algorithms/rhythm/noveltycurve.h"
@@ -192,6 +195,8 @@
 #include "algorithms/rhythm/beattrackermultifeature.h"
 #include "algorithms/rhythm/noveltycurvefixedbpmestimator.h"
 #include "algorithms/rhythm/beattrackerdegara.h"
+#include "algorithms/rhythm/beattrackerlive.h"
+#include "algorithms/rhythm/multionsetdetection.h"
 #include "algorithms/rhythm/onsetrate.h"
 #include "algorithms/rhythm/tempotapmaxagreement.h"
 #include "algorithms/rhythm/bpmrubato.h"
@@ -333,6 +338,8 @@ ESSENTIA_API void registerAlgorithm() {
     AlgorithmFactory::Registrar<Panning> regPanning;
     AlgorithmFactory::Registrar<GFCC> regGFCC;
     AlgorithmFactory::Registrar<HPCP> regHPCP;
+    AlgorithmFactory::Registrar<MultiHPCP> regMultiHPCP;
+    AlgorithmFactory::Registrar<HPCPSelector> regHPCPSelector;
     AlgorithmFactory::Registrar<StrongPeak> regStrongPeak;
     AlgorithmFactory::Registrar<RollOff> regRollOff;
     AlgorithmFactory::Registrar<Flux> regFlux;
@@ -424,6 +431,8 @@ ESSENTIA_API void registerAlgorithm() {
     AlgorithmFactory::Registrar<BeatTrackerMultiFeature> regBeatTrackerMultiFeature;
     AlgorithmFactory::Registrar<NoveltyCurveFixedBpmEstimator> regNoveltyCurveFixedBpmEstimator;
     AlgorithmFactory::Registrar<BeatTrackerDegara> regBeatTrackerDegara;
+    AlgorithmFactory::Registrar<BeatTrackerLive> regBeatTrackerLive;
+    AlgorithmFactory::Registrar<MultiOnsetDetection> regMultiOnsetDetection;
     AlgorithmFactory::Registrar<OnsetRate> regOnsetRate;
     AlgorithmFactory::Registrar<TempoTapMaxAgreement> regTempoTapMaxAgreement;
     AlgorithmFactory::Registrar<BpmRubato> regBpmRubato;
@@ -562,6 +571,8 @@ ESSENTIA_API void registerAlgorithm() {
     AlgorithmFactory::Registrar<Panning, essentia::standard::Panning> regPanning;
     AlgorithmFactory::Registrar<GFCC, essentia::standard::GFCC> regGFCC;
     AlgorithmFactory::Registrar<HPCP, essentia::standard::HPCP> regHPCP;
+    AlgorithmFactory::Registrar<MultiHPCP, essentia::standard::MultiHPCP> regMultiHPCP;
+    AlgorithmFactory::Registrar<HPCPSelector, essentia::standard::HPCPSelector> regHPCPSelector;
     AlgorithmFactory::Registrar<StrongPeak, essentia::standard::StrongPeak> regStrongPeak;
     AlgorithmFactory::Registrar<RollOff, essentia::standard::RollOff> regRollOff;
     AlgorithmFactory::Registrar<Flux, essentia::standard::Flux> regFlux;
@@ -648,6 +659,7 @@ ESSENTIA_API void registerAlgorithm() {
     AlgorithmFactory::Registrar<IFFTW, essentia::standard::IFFTW> regIFFTW;
     AlgorithmFactory::Registrar<StereoDemuxer, essentia::standard::StereoDemuxer> regStereoDemuxer;
     AlgorithmFactory::Registrar<OnsetDetectionGlobal, essentia::standard::OnsetDetectionGlobal> regOnsetDetectionGlobal;
+    AlgorithmFactory::Registrar<SpectralOnsetDetectionGlobal> regSpectralOnsetDetectionGlobal;
     AlgorithmFactory::Registrar<PercivalEnhanceHarmonics, essentia::standard::PercivalEnhanceHarmonics> regPercivalEnhanceHarmonics;
     AlgorithmFactory::Registrar<BpmHistogramDescriptors, essentia::standard::BpmHistogramDescriptors> regBpmHistogramDescriptors;
     AlgorithmFactory::Registrar<NoveltyCurve, essentia::standard::NoveltyCurve> regNoveltyCurve;
@@ -655,6 +667,8 @@ ESSENTIA_API void registerAlgorithm() {
     AlgorithmFactory::Registrar<PercivalEvaluatePulseTrains, essentia::standard::PercivalEvaluatePulseTrains> regPercivalEvaluatePulseTrains;
     AlgorithmFactory::Registrar<BeatTrackerMultiFeature, essentia::standard::BeatTrackerMultiFeature> regBeatTrackerMultiFeature;
     AlgorithmFactory::Registrar<BeatTrackerDegara, essentia::standard::BeatTrackerDegara> regBeatTrackerDegara;
+    AlgorithmFactory::Registrar<BeatTrackerLive, essentia::standard::BeatTrackerLive> regBeatTrackerLive;
+    AlgorithmFactory::Registrar<MultiOnsetDetection, essentia::standard::MultiOnsetDetection> regMultiOnsetDetection;
     AlgorithmFactory::Registrar<OnsetRate, essentia::standard::OnsetRate> regOnsetRate;
     AlgorithmFactory::Registrar<TempoTapMaxAgreement, essentia::standard::TempoTapMaxAgreement> regTempoTapMaxAgreement;
     AlgorithmFactory::Registrar<BpmRubato, essentia::standard::BpmRubato> regBpmRubato;
@@ -199,56 +199,64 @@ void MusicExtractor::compute() {
       throw EssentiaException("MusicExtractor: Error processing ", audioFilename, " file: cannot find musicbrainz recording id");
   }
   
+  // the file is decoded only once: the analyzed slice is kept in memory, at
+  // the analysis sample rate, and all the following passes read from it
   E_INFO("MusicExtractor: Compute md5 audio hash, codec, length, and EBU 128 loudness");
-  computeAudioMetadata(audioFilename, results);
-  
+  vector<StereoSample> stereoAudio;
+  int numberChannels = loadAudio(audioFilename, stereoAudio, results);
+
   E_INFO("MusicExtractor: Replay gain");
-  computeReplayGain(audioFilename, results);
-  
+  vector<AudioSample> audio;
+  computeReplayGain(stereoAudio, numberChannels, audio, results);
+  vector<StereoSample>().swap(stereoAudio);
+
   E_INFO("MusicExtractor: Compute audio features");
 
   // normalize the audio with replay gain and compute as many lowlevel, rhythm,
-  // and tonal descriptors as possible
-  
-  streaming::Algorithm* loader = factory.create("EasyLoader",
-                                    "filename",   audioFilename,
-                                    "sampleRate", analysisSampleRate,
-                                    "startTime",  startTime,
-                                    "endTime",    endTime,
-                                    "replayGain", replayGain,
-                                    "downmix",    downmix);
+  // and tonal descriptors as possible. Apply a 6dB preamp, as done by all
+  // audio players (and EasyLoader).
+  Real scalingFactor = db2amp(replayGain + 6.0);
+
+  streaming::VectorInput<AudioSample, 4096>* audioInput = new streaming::VectorInput<AudioSample, 4096>(&audio);
+  streaming::Algorithm* scale = factory.create("Scale", "factor", scalingFactor);
+  audioInput->output("data") >> scale->input("signal");
+
   MusicLowlevelDescriptors *lowlevel = new MusicLowlevelDescriptors(options);
   MusicRhythmDescriptors *rhythm = new MusicRhythmDescriptors(options);
   MusicTonalDescriptors *tonal = new MusicTonalDescriptors(options);
-  
-  SourceBase& source = loader->output("audio");
+
+  // the spectra of the tonal frames are computed once, for the tuning
+  // frequency, and reused for the other tonal descriptors
+  vector<vector<Real> > tonalSpectra;
+
+  SourceBase& source = scale->output("signal");
   lowlevel->createNetworkNeqLoud(source, results);
   lowlevel->createNetworkEqLoud(source, results);
   lowlevel->createNetworkLoudness(source, results);
   rhythm->createNetwork(source, results);
-  tonal->createNetworkTuningFrequency(source, results);
+  tonal->createNetworkTuningFrequency(source, results, &tonalSpectra);
 
-  scheduler::Network network(loader);
+  scheduler::Network network(audioInput);
   network.run();
   
   // Descriptors that require values from other descriptors in the previous chain
   lowlevel->computeAverageLoudness(results);  // requires 'loudness'
 
-  streaming::Algorithm* loader_2 = factory.create("EasyLoader",
-                                       "filename",   audioFilename,
-                                       "sampleRate", analysisSampleRate,
-                                       "startTime",  startTime,
-                                       "endTime",    endTime,
-                                       "replayGain", replayGain,
-                                       "downmix",    downmix);
+  streaming::VectorInput<AudioSample, 4096>* audioInput_2 = new streaming::VectorInput<AudioSample, 4096>(&audio);
+  streaming::Algorithm* scale_2 = factory.create("Scale", "factor", scalingFactor);
+  audioInput_2->output("data") >> scale_2->input("signal");
 
-  SourceBase& source_2 = loader_2->output("audio");
-  rhythm->createNetworkBeatsLoudness(source_2, results);  // requires 'beat_positions'
-  tonal->createNetwork(source_2, results);                // requires 'tuning frequency'
+  rhythm->createNetworkBeatsLoudness(scale_2->output("signal"), results);  // requires 'beat_positions'
 
-  scheduler::Network network_2(loader_2);
+  scheduler::Network network_2(audioInput_2);
   network_2.run();
 
+  streaming::VectorInput<vector<Real> >* spectrumInput = new streaming::VectorInput<vector<Real> >(&tonalSpectra);
+  tonal->createNetworkFromSpectrum(spectrumInput->output("data"), results);  // requires 'tuning frequency'
+
+  scheduler::Network network_3(spectrumInput);
+  network_3.run();
+
   // Descriptors that require values from other descriptors in the previous chain
   tonal->computeTuningSystemFeatures(results); // requires 'hpcp_highres'
 
@@ -438,7 +446,7 @@ void MusicExtractor::readMetadata(const string& audioFilename, Pool& results) {
 }
 
 
-void MusicExtractor::computeAudioMetadata(const string& audioFilename, Pool& results) {
+int MusicExtractor::loadAudio(const string& audioFilename, vector<StereoSample>& audio, Pool& results) {
   streaming::AlgorithmFactory& factory = streaming::AlgorithmFactory::instance();
   streaming::Algorithm* loader = factory.create("AudioLoader",
                                                 "filename",   audioFilename,
@@ -456,8 +464,10 @@ void MusicExtractor::computeAudioMetadata(const string& audioFilename, Pool& res
   streaming::Algorithm* resampleL = factory.create("Resample");
   streaming::Algorithm* trimmer = factory.create("StereoTrimmer");
   streaming::Algorithm* loudness = factory.create("LoudnessEBUR128");
+  streaming::Algorithm* storage = new streaming::VectorOutput<StereoSample>(&audio);
 
   Real inputSampleRate = lastTokenProduced<Real>(loader->output("sampleRate"));
+  int numberChannels = lastTokenProduced<int>(loader->output("numberChannels"));
   resampleR->configure("inputSampleRate", inputSampleRate,
                        "outputSampleRate", analysisSampleRate);
   resampleL->configure("inputSampleRate", inputSampleRate,
@@ -478,6 +488,7 @@ void MusicExtractor::computeAudioMetadata(const string& audioFilename, Pool& res
   loudness->output("momentaryLoudness") >> PC(results, "lowlevel.loudness_ebu128.momentary");
   loudness->output("shortTermLoudness") >> PC(results, "lowlevel.loudness_ebu128.short_term");
   loudness->output("loudnessRange") >> PC(results, "lowlevel.loudness_ebu128.loudness_range");
+  trimmer->output("signal")    >> storage->input("data");
 
   scheduler::Network network(loader);
   network.run();
@@ -507,10 +518,13 @@ void MusicExtractor::computeAudioMetadata(const string& audioFilename, Pool& res
       isLossless = true;
   }
   results.set("metadata.audio_properties.lossless", isLossless);
+
+  return numberChannels;
 }
 
 
-void MusicExtractor::computeReplayGain(const string& audioFilename, Pool& results) {
+void MusicExtractor::computeReplayGain(const vector<StereoSample>& stereoAudio, int numberChannels,
+                                       vector<AudioSample>& audio, Pool& results) {
 
   streaming::AlgorithmFactory& factory = streaming::AlgorithmFactory::instance();
 
@@ -518,19 +532,25 @@ void MusicExtractor::computeReplayGain(const string& audioFilename, Pool& result
   //int length = 0;
 
   while (true) {
-    streaming::Algorithm* audio = factory.create("EqloudLoader",
-                                      "filename",   audioFilename,
-                                      "sampleRate", analysisSampleRate,
-                                      "startTime",  startTime,
-                                      "endTime",    endTime,
-                                      "downmix",    downmix);
+    // same signal as the one of EqloudLoader, which is also the audio to
+    // analyze once scaled
+    standard::Algorithm* mixer = standard::AlgorithmFactory::create("MonoMixer", "type", downmix);
+    mixer->input("audio").set(stereoAudio);
+    mixer->input("numberChannels").set(numberChannels);
+    mixer->output("audio").set(audio);
+    mixer->compute();
+    delete mixer;
+
+    streaming::VectorInput<AudioSample, 4096>* audioInput = new streaming::VectorInput<AudioSample, 4096>(&audio);
+    streaming::Algorithm* eqloud = factory.create("EqualLoudness", "sampleRate", analysisSampleRate);
     streaming::Algorithm* rgain = factory.create("ReplayGain", "applyEqloud", false);
 
-    audio->output("audio")      >> rgain->input("signal");
+    audioInput->output("data")  >> eqloud->input("signal");
+    eqloud->output("signal")    >> rgain->input("signal");
     rgain->output("replayGain") >> PC(results, "metadata.audio_properties.replay_gain");
 
     try {
-      scheduler::Network network(audio);
+      scheduler::Network network(audioInput);
       network.run();
       //length = audio->output("audio").totalProduced();
       replayGain = results.value<Real>("metadata.audio_properties.replay_gain");
@@ -81,8 +81,9 @@ class MusicExtractor : public Algorithm {
   void setExtractorDefaultOptions();
   void mergeValues(Pool &pool);
   void readMetadata(const std::string& audioFilename, Pool& results);
-  void computeAudioMetadata(const std::string& audioFilename, Pool& results);
-  void computeReplayGain(const std::string& audioFilename, Pool& results);
+  int loadAudio(const std::string& audioFilename, std::vector<StereoSample>& audio, Pool& results);
+  void computeReplayGain(const std::vector<StereoSample>& stereoAudio, int numberChannels,
+                         std::vector<AudioSample>& audio, Pool& results);
 
   Pool computeAggregation(Pool& pool);
 
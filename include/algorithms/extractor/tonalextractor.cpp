@@ -32,7 +32,7 @@ const char* TonalExtractor::description = essentia::standard::TonalExtractor::de
 
 
 TonalExtractor::TonalExtractor(): _frameCutter(0), _windowing(0), _spectrum(0), _spectralPeaks(0),
-                                  _hpcpKey(0), _hpcpChord(0), _hpcpTuning(0), _key(0),
+                                  _multiHPCP(0), _hpcpKey(0), _hpcpChord(0), _hpcpTuning(0), _key(0),
                                   _chordsDescriptors(0), _chordsDetection(0) {
 
   declareInput(_signal, "signal", "the input audio signal");
@@ -66,21 +66,22 @@ void TonalExtractor::createInnerNetwork() {
   _frameCutter       = factory.create("FrameCutter");
   _spectrum          = factory.create("Spectrum");
   _windowing         = factory.create("Windowing", "type", "blackmanharris62");
-  _hpcpKey           = factory.create("HPCP");
-  _hpcpChord         = factory.create("HPCP");
-  _hpcpTuning        = factory.create("HPCP");
+  _multiHPCP         = factory.create("MultiHPCP");
+  _hpcpKey           = factory.create("HPCPSelector", "index", 0);
+  _hpcpChord         = factory.create("HPCPSelector", "index", 1);
+  _hpcpTuning        = factory.create("HPCPSelector", "index", 2);
 
   _signal                                >>  _frameCutter->input("signal");
   _frameCutter->output("frame")          >>  _windowing->input("frame");
   _windowing->output("frame")            >>  _spectrum->input("frame");
   _spectrum->output("spectrum")          >>  _spectralPeaks->input("spectrum");
 
-  _spectralPeaks->output("magnitudes")   >>  _hpcpKey->input("magnitudes");
-  _spectralPeaks->output("magnitudes")   >>  _hpcpChord->input("magnitudes");
-  _spectralPeaks->output("magnitudes")   >>  _hpcpTuning->input("magnitudes");
-  _spectralPeaks->output("frequencies")  >>  _hpcpKey->input("frequencies");
-  _spectralPeaks->output("frequencies")  >>  _hpcpChord->input("frequencies");
-  _spectralPeaks->output("frequencies")  >>  _hpcpTuning->input("frequencies");
+  // the three profiles are computed from the same peaks by one MultiHPCP
+  _spectralPeaks->output("magnitudes")   >>  _multiHPCP->input("magnitudes");
+  _spectralPeaks->output("frequencies")  >>  _multiHPCP->input("frequencies");
+  _multiHPCP->output("hpcps")            >>  _hpcpKey->input("hpcps");
+  _multiHPCP->output("hpcps")            >>  _hpcpChord->input("hpcps");
+  _multiHPCP->output("hpcps")            >>  _hpcpTuning->input("hpcps");
 
   _hpcpTuning->output("hpcp")            >>  _hpcpsTuning;
 
@@ -117,36 +118,30 @@ void TonalExtractor::configure() {
                           "hopSize", hopSize,
                           "silentFrames", "noise");
 
-  _hpcpKey->configure("referenceFrequency", tuningFrequency,
-                      "minFrequency", 40.0,
-                      "nonLinear", false,
-                      "maxFrequency", 5000.0,
-                      "bandPreset", false,
-                      "windowSize", 1.33333333333,
-                      "weightType", "squaredCosine",
-                      "size", 36);
-
-  _hpcpChord->configure("referenceFrequency", tuningFrequency,
-                        "minFrequency", 40.0,
-                        "nonLinear", true,
-                        "bandSplitFrequency", 500.0,
-                        "maxFrequency", 5000.0,
-                        "bandPreset", true,
-                        "windowSize", 0.5,
-                        "weightType", "cosine",
-                        "harmonics", 8,
-                        "size", 36);
-
-  _hpcpTuning->configure("referenceFrequency", tuningFrequency,
-                         "minFrequency", 40.0,
-                         "nonLinear", true,
-                         "bandSplitFrequency", 500.0,
-                         "maxFrequency", 5000.0,
-                         "bandPreset", true,
-                         "windowSize", 0.5,
-                         "weightType", "cosine",
-                         "harmonics", 8,
-                         "size", 120);
+  // in the order of the indexes of _hpcpKey, _hpcpChord and _hpcpTuning
+  vector<int> sizes(3, 36);
+  sizes[2] = 120;
+  vector<int> harmonics(3, 8);
+  harmonics[0] = 0;
+  vector<bool> bandPresets(3, true);
+  bandPresets[0] = false;
+  vector<string> weightTypes(3, "cosine");
+  weightTypes[0] = "squaredCosine";
+  vector<bool> nonLinear(3, true);
+  nonLinear[0] = false;
+  vector<Real> windowSizes(3, 0.5);
+  windowSizes[0] = 1.33333333333;
+
+  _multiHPCP->configure("referenceFrequency", vector<Real>(1, tuningFrequency),
+                        "minFrequency", vector<Real>(1, 40.0),
+                        "nonLinear", nonLinear,
+                        "bandSplitFrequency", vector<Real>(1, 500.0),
+                        "maxFrequency", vector<Real>(1, 5000.0),
+                        "bandPreset", bandPresets,
+                        "windowSize", windowSizes,
+                        "weightType", weightTypes,
+                        "harmonics", harmonics,
+                        "size", sizes);
 }
 
 
@@ -47,7 +47,7 @@ class TonalExtractor : public AlgorithmComposite {
   SourceProxy<std::string> _keyScale;
   SourceProxy<Real> _keyStrength;
 
-  Algorithm *_frameCutter, *_windowing, *_spectrum, *_spectralPeaks,
+  Algorithm *_frameCutter, *_windowing, *_spectrum, *_spectralPeaks, *_multiHPCP,
             *_hpcpKey, *_hpcpChord, *_hpcpTuning, *_key,
             *_chordsDescriptors, *_chordsDetection;
 
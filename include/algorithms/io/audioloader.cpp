@@ -18,7 +18,9 @@
  */
 
 #include "audioloader.h"
+#include "audioprobe.h"
 #include "algorithmfactory.h"
+#include <cstring>  //  strcmp()
 #include <iomanip>  //  setw()
 
 using namespace std;
@@ -30,13 +32,14 @@ const char* AudioLoader::name = essentia::standard::AudioLoader::name;
 const char* AudioLoader::category = essentia::standard::AudioLoader::category;
 const char* AudioLoader::description = essentia::standard::AudioLoader::description;
 
+const Real AudioLoader::seekPreroll = 0.5;
+
 
 AudioLoader::~AudioLoader() {
     closeAudioFile();
 
     av_freep(&_buffer);
     av_freep(&_md5Encoded);
-    av_freep(&_decodedFrame);
 }
 
 void AudioLoader::configure() {
@@ -46,6 +49,17 @@ void AudioLoader::configure() {
     //av_log_set_level(AV_LOG_VERBOSE);
     _computeMD5 = parameter("computeMD5").toBool();
     _selectedStream = parameter("audioStream").toInt();
+    _startTime = parameter("startTime").toReal();
+    _endTime = parameter("endTime").toReal();
+
+    if (_startTime > _endTime) {
+        throw EssentiaException("AudioLoader: startTime cannot be larger than endTime");
+    }
+    // the checksum is computed on the packets which are read, it would not
+    // be the one of the file when only a slice of it is loaded
+    if (_computeMD5 && (_startTime > 0 || _endTime < defaultParameters()["endTime"].toReal())) {
+        throw EssentiaException("AudioLoader: computeMD5 cannot be used when loading a slice of the file (startTime, endTime)");
+    }
     reset();
 }
 
@@ -141,6 +155,83 @@ void AudioLoader::openAudioFile(const string& filename) {
     }
 
     av_md5_init(_md5Encoded);
+
+    _startSample = (int64_t)(_startTime * _audioCtx->sample_rate + 0.5);
+    _endSample = (int64_t)(_endTime * _audioCtx->sample_rate + 0.5);
+    seekToStart();
+}
+
+
+/**
+ * Whether the timestamps of the packets read after seeking in a file of the
+ * given format are exact. The mp3 and ADTS (raw AAC) demuxers estimate the
+ * position they seek to from the bit rate, or from the coarse table of
+ * contents of the VBR headers, and their timestamps after a seek are that
+ * estimate: the slice would be shifted, by up to a few seconds for VBR files.
+ */
+static bool seeksExactly(const AVInputFormat* format) {
+    if (format->flags & AVFMT_NOTIMESTAMPS) return false;
+    return strcmp(format->name, "mp3") != 0 && strcmp(format->name, "aac") != 0;
+}
+
+
+/**
+ * Seeks to the last keyframe at least seekPreroll seconds before startTime,
+ * so that only the packets of the slice to load (plus the few ones before it)
+ * are decoded. The samples before startTime are then dropped by
+ * copyFFmpegOutput(), according to the timestamp of the first decoded frame.
+ * The preroll is decoded and dropped too: the first frames decoded after a
+ * seek are not complete (eg: mp3 frames using the bit reservoir of the
+ * previous ones, or the overlap of the AAC frames), but they are then all
+ * before startTime.
+ */
+void AudioLoader::seekToStart() {
+    _position = 0;
+    _rewind = false;
+
+    int64_t seekSample = _startSample - (int64_t)(seekPreroll * _audioCtx->sample_rate);
+    if (seekSample <= 0) return;
+
+    if (!seeksExactly(_demuxCtx->iformat)) {
+        E_DEBUG(EAlgorithm, "AudioLoader: " << _demuxCtx->iformat->name << " positions are estimated when seeking, decoding from the beginning");
+        return;
+    }
+
+    AVStream* stream = _demuxCtx->streams[_streamIdx];
+    AVRational sampleTimeBase = { 1, _audioCtx->sample_rate };
+    int64_t timestamp = av_rescale_q(seekSample, sampleTimeBase, stream->time_base);
+    if (stream->start_time != AV_NOPTS_VALUE) timestamp += stream->start_time;
+
+    if (av_seek_frame(_demuxCtx, _streamIdx, timestamp, AVSEEK_FLAG_BACKWARD) < 0) {
+        // not seekable (eg: some raw streams), decode and drop everything
+        // before startTime instead
+        E_WARNING("AudioLoader: could not seek to " << _startTime << "s, decoding from the beginning");
+        return;
+    }
+    avcodec_flush_buffers(_audioCtx);
+    _position = -1;
+}
+
+
+/**
+ * Goes back to the beginning of the file, when the position reached by
+ * seekToStart() cannot be known from the timestamps: the samples before
+ * startTime are then counted while decoding, which is exact.
+ */
+void AudioLoader::rewind() {
+    AVStream* stream = _demuxCtx->streams[_streamIdx];
+    int64_t timestamp = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+
+    E_DEBUG(EAlgorithm, "AudioLoader: no timestamp after seeking, decoding from the beginning");
+    if (av_seek_frame(_demuxCtx, _streamIdx, timestamp, AVSEEK_FLAG_BACKWARD) < 0 &&
+        av_seek_frame(_demuxCtx, _streamIdx, 0, AVSEEK_FLAG_BYTE) < 0) {
+        ostringstream msg;
+        msg << "AudioLoader: could not find the position of " << _startTime << "s in the file";
+        throw EssentiaException(msg);
+    }
+    avcodec_flush_buffers(_audioCtx);
+    _position = 0;
+    _rewind = false;
 }
 
 
@@ -162,6 +253,8 @@ void AudioLoader::closeAudioFile() {
     // free AVPacket
     // TODO: use a variable for whether _packet is initialized or not
     av_free_packet(&_packet);
+    // the frame is allocated again when the next file is opened
+    av_frame_free(&_decodedFrame);
     _demuxCtx = 0;
     _audioCtx = 0;
     _streams.clear();
@@ -218,18 +311,7 @@ AlgorithmStatus AudioLoader::process() {
             }
             // TODO: should try reading again on EAGAIN error?
             //       https://github.com/FFmpeg/FFmpeg/blob/master/ffmpeg.c
-            shouldStop(true);
-            flushPacket();
-            closeAudioFile();
-            if (_computeMD5) {
-                av_md5_final(_md5Encoded, _checksum);
-                _md5.push(uint8_t_to_hex(_checksum, 16));
-            }
-            else {
-                string md5 = "";
-                _md5.push(md5);
-            }
-            return FINISHED;
+            return endOfStream();
         }
     } while (_packet.stream_index != _streamIdx);
 
@@ -245,11 +327,37 @@ AlgorithmStatus AudioLoader::process() {
     }
     // neds to be freed !!
     av_free_packet(&_packet);
-    
+
+    if (_rewind) {
+        rewind();
+        return OK;
+    }
+
+    // the rest of the file is not needed
+    if (_position >= _endSample) {
+        return endOfStream();
+    }
+
     return OK;
 }
 
 
+AlgorithmStatus AudioLoader::endOfStream() {
+    shouldStop(true);
+    flushPacket();
+    closeAudioFile();
+    if (_computeMD5) {
+        av_md5_final(_md5Encoded, _checksum);
+        _md5.push(uint8_t_to_hex(_checksum, 16));
+    }
+    else {
+        string md5 = "";
+        _md5.push(md5);
+    }
+    return FINISHED;
+}
+
+
 int AudioLoader::decode_audio_frame(AVCodecContext* audioCtx,
                                     float* output,
                                     int* outputSize,
@@ -265,7 +373,22 @@ int AudioLoader::decode_audio_frame(AVCodecContext* audioCtx,
 
     if (len < 0) return len; // error handling should be done outside
 
-    if (gotFrame) {
+    if (gotFrame && _position < 0) {
+        // first frame after seeking, find out where we landed
+        AVStream* stream = _demuxCtx->streams[_streamIdx];
+        int64_t timestamp = av_frame_get_best_effort_timestamp(_decodedFrame);
+        if (timestamp != AV_NOPTS_VALUE) {
+            if (stream->start_time != AV_NOPTS_VALUE) timestamp -= stream->start_time;
+            AVRational sampleTimeBase = { 1, audioCtx->sample_rate };
+            _position = av_rescale_q(timestamp, stream->time_base, sampleTimeBase);
+        }
+        else {
+            // drop the frames until process() goes back to the beginning
+            _rewind = true;
+        }
+    }
+
+    if (gotFrame && !_rewind) {
         int inputSamples = _decodedFrame->nb_samples;
         int inputPlaneSize = av_samples_get_buffer_size(NULL, _nChannels, inputSamples,
                                                         audioCtx->sample_fmt, 1);
@@ -308,7 +431,7 @@ int AudioLoader::decode_audio_frame(AVCodecContext* audioCtx,
         *outputSize = outputPlaneSize;
     }
     else {
-      E_DEBUG(EAlgorithm, "AudioLoader: tried to decode packet but didn't get any frame...");
+      if (!gotFrame) E_DEBUG(EAlgorithm, "AudioLoader: tried to decode packet but didn't get any frame...");
       *outputSize = 0;
     }
 
@@ -428,8 +551,17 @@ inline Real scale(int16_t value) {
 */
 
 void AudioLoader::copyFFmpegOutput() {
-    int nsamples = _dataSize / (av_get_bytes_per_sample(AV_SAMPLE_FMT_FLT)  * _nChannels);
-    if (nsamples == 0) return;
+    int decodedSamples = _dataSize / (av_get_bytes_per_sample(AV_SAMPLE_FMT_FLT)  * _nChannels);
+    if (decodedSamples == 0) return;
+
+    // only keep the samples between startTime and endTime
+    int64_t first = max(_startSample - _position, (int64_t)0);
+    int64_t last = min(_endSample - _position, (int64_t)decodedSamples);
+    _position += decodedSamples;
+    if (last <= first) return;
+
+    const float* buffer = _buffer + first * _nChannels;
+    int nsamples = int(last - first);
 
     // acquire necessary data
     bool ok = _audio.acquire(nsamples);
@@ -441,15 +573,15 @@ void AudioLoader::copyFFmpegOutput() {
 
     if (_nChannels == 1) {
         for (int i=0; i<nsamples; i++) {
-          audio[i].left() = _buffer[i];
+          audio[i].left() = buffer[i];
           //audio[i].left() = scale(_buffer[i]);
         }
     }
     else { // _nChannels == 2
       // The output format is always AV_SAMPLE_FMT_FLT, which is interleaved
       for (int i=0; i<nsamples; i++) {
-        audio[i].left() = _buffer[2*i];
-        audio[i].right() = _buffer[2*i+1];
+        audio[i].left() = buffer[2*i];
+        audio[i].right() = buffer[2*i+1];
         //audio[i].left() = scale(_buffer[2*i]);
         //audio[i].right() = scale(_buffer[2*i+1]);
       }
@@ -492,6 +624,8 @@ const char* AudioLoader::category = "Input/output";
 const char* AudioLoader::description = DOC("This algorithm loads the single audio stream contained in a given audio or video file. Supported formats are all those supported by the FFmpeg library including wav, aiff, flac, ogg and mp3.\n"
 "\n"
 "This algorithm will throw an exception if it was not properly configured which is normally due to not specifying a valid filename. Invalid names comprise those with extensions different than the supported  formats and non existent files. If using this algorithm on Windows, you must ensure that the filename is encoded as UTF-8\n\n"
+"A slice of the file can be loaded by setting the 'startTime' and 'endTime' parameters: the algorithm then seeks to the start of the slice instead of decoding the file from its beginning, and stops decoding at its end. Seeking lands on a keyframe at least 0.5s before 'startTime', the samples before it are dropped according to the timestamps of the decoded frames, so that the slice holds the same samples as when decoding the whole file. Formats whose timestamps after seeking are only estimates (mp3, raw AAC), and files whose decoded frames have no timestamp, are decoded from the beginning instead. The MD5 checksum cannot be computed when loading a slice.\n"
+"\n"
 "Note: ogg files are decoded in reverse phase, due to be using ffmpeg library.\n"
 "\n"
 "References:\n"
@@ -523,7 +657,9 @@ void AudioLoader::createInnerNetwork() {
 void AudioLoader::configure() {
     _loader->configure(INHERIT("filename"),
                        INHERIT("computeMD5"),
-                       INHERIT("audioStream"));
+                       INHERIT("audioStream"),
+                       INHERIT("startTime"),
+                       INHERIT("endTime"));
 }
 
 void AudioLoader::compute() {
@@ -568,3 +704,101 @@ void AudioLoader::reset() {
 
 } // namespace standard
 } // namespace essentia
+
+
+namespace essentia {
+
+// Opens the file and returns its demuxer, the index of the selected audio
+// stream among all the streams of the file being stored in streamIdx. The
+// caller names the function throwing the errors
+static AVFormatContext* openAudioStream(const string& filename, int audioStream,
+                                        const char* caller, int& streamIdx) {
+  av_log_set_level(AV_LOG_QUIET);
+  av_register_all();
+
+  AVFormatContext* demuxCtx = 0;
+  int errnum;
+  if ((errnum = avformat_open_input(&demuxCtx, filename.c_str(), NULL, NULL)) != 0) {
+    char errorstr[128];
+    string error = "Unknown error";
+    if (av_strerror(errnum, errorstr, 128) == 0) error = errorstr;
+    ostringstream msg;
+    msg << caller << ": Could not open file \"" << filename << "\", error = " << error;
+    throw EssentiaException(msg);
+  }
+
+  if ((errnum = avformat_find_stream_info(demuxCtx, NULL)) < 0) {
+    char errorstr[128];
+    string error = "Unknown error";
+    if (av_strerror(errnum, errorstr, 128) == 0) error = errorstr;
+    avformat_close_input(&demuxCtx);
+    throw EssentiaException(caller, ": Could not find stream information, error = ", error);
+  }
+
+  // select the stream in the same way as AudioLoader does
+  vector<int> streams;
+  for (int i=0; i<(int)demuxCtx->nb_streams; i++) {
+    if (demuxCtx->streams[i]->codec->codec_type == AVMEDIA_TYPE_AUDIO) {
+      streams.push_back(i);
+    }
+  }
+
+  if (audioStream >= (int)streams.size()) {
+    avformat_close_input(&demuxCtx);
+    ostringstream msg;
+    msg << caller << ": found " << streams.size() << " audio streams in the file, cannot read stream " << audioStream;
+    throw EssentiaException(msg);
+  }
+  streamIdx = streams[audioStream];
+
+  return demuxCtx;
+}
+
+string audioMD5(const string& filename, int audioStream) {
+  int streamIdx;
+  AVFormatContext* demuxCtx = openAudioStream(filename, audioStream, "audioMD5", streamIdx);
+
+  AVMD5* md5 = av_md5_alloc();
+  if (!md5) {
+    avformat_close_input(&demuxCtx);
+    throw EssentiaException("audioMD5: Error allocating the MD5 context");
+  }
+  av_md5_init(md5);
+
+  // only demux, the checksum is computed over the packets as they are stored
+  // in the file
+  AVPacket packet;
+  av_init_packet(&packet);
+  while (av_read_frame(demuxCtx, &packet) == 0) {
+    if (packet.stream_index == streamIdx) {
+      av_md5_update(md5, packet.data, packet.size);
+    }
+    av_free_packet(&packet);
+  }
+
+  uint8_t checksum[16];
+  av_md5_final(md5, checksum);
+  av_freep(&md5);
+  avformat_close_input(&demuxCtx);
+
+  return streaming::uint8_t_to_hex(checksum, 16);
+}
+
+double audioDuration(const string& filename, int audioStream) {
+  int streamIdx;
+  AVFormatContext* demuxCtx = openAudioStream(filename, audioStream, "audioDuration", streamIdx);
+
+  AVStream* stream = demuxCtx->streams[streamIdx];
+  double duration = -1;
+  if (stream->duration != AV_NOPTS_VALUE && stream->duration > 0) {
+    duration = stream->duration * av_q2d(stream->time_base);
+  }
+  else if (demuxCtx->duration != AV_NOPTS_VALUE && demuxCtx->duration > 0) {
+    duration = demuxCtx->duration / (double)AV_TIME_BASE;
+  }
+
+  avformat_close_input(&demuxCtx);
+  return duration;
+}
+
+} // namespace essentia
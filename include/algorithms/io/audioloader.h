@@ -67,9 +67,28 @@ class AudioLoader : public Algorithm {
   int _selectedStream;
   bool _configured;
 
+  // range of samples to load, in the sampling rate of the file, and position
+  // in the file of the next decoded sample (-1 after seeking, until the
+  // timestamp of the first decoded frame is known, or until the file has been
+  // rewound if that frame has none)
+  Real _startTime;
+  Real _endTime;
+  int64_t _startSample;
+  int64_t _endSample;
+  int64_t _position;
+  bool _rewind;
+
+  // how long before startTime to seek [s], the samples decoded there being
+  // dropped: more than the frames needed by the decoders to output complete
+  // samples again after a seek
+  static const Real seekPreroll;
+
 
   void openAudioFile(const std::string& filename);
   void closeAudioFile();
+  void seekToStart();
+  void rewind();
+  AlgorithmStatus endOfStream();
 
   void pushChannelsSampleRateInfo(int nChannels, Real sampleRate);
   void pushCodecInfo(std::string codec, int bit_rate);
@@ -115,6 +134,8 @@ class AudioLoader : public Algorithm {
     declareParameter("filename", "the name of the file from which to read", "", Parameter::STRING);
     declareParameter("computeMD5", "compute the MD5 checksum", "{true,false}", false);
     declareParameter("audioStream", "audio stream index to be loaded. Other streams are not taken into account (e.g. if stream 0 is video and 1 is audio use index 0 to access it.)", "[0,inf)", 0);
+    declareParameter("startTime", "the start time of the slice to be loaded, reached by seeking in the file [s]", "[0,inf)", 0.0);
+    declareParameter("endTime", "the end time of the slice to be loaded, the file is not decoded any further [s]", "[0,inf)", 1e6);
   }
 
   void configure();
@@ -176,6 +197,8 @@ class AudioLoader : public Algorithm {
     declareParameter("filename", "the name of the file from which to read", "", Parameter::STRING);
     declareParameter("computeMD5", "compute the MD5 checksum", "{true,false}", false);
     declareParameter("audioStream", "audio stream index to be loaded. Other streams are no taken into account (e.g. if stream 0 is video and 1 is audio use index 0 to access it.)", "[0,inf)", 0);
+    declareParameter("startTime", "the start time of the slice to be loaded, reached by seeking in the file [s]", "[0,inf)", 0.0);
+    declareParameter("endTime", "the end time of the slice to be loaded, the file is not decoded any further [s]", "[0,inf)", 1e6);
   }
 
   void configure();
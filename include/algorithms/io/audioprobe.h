@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_AUDIOPROBE_H
+#define ESSENTIA_AUDIOPROBE_H
+
+#include <string>
+
+namespace essentia {
+
+// Information read from an audio file without decoding it, such as what is
+// needed before deciding whether and how to load it with AudioLoader
+
+/**
+ * Computes the MD5 checksum of the raw undecoded audio payload of a file,
+ * which is the same as the "md5" output of AudioLoader with computeMD5
+ * enabled, but only demuxes the file instead of also decoding it.
+ *
+ * As this checksum does not depend on the metadata nor on the name of the
+ * file, it can be used to recognize an audio file which has been moved,
+ * renamed or retagged.
+ *
+ * @param filename the name of the file to read
+ * @param audioStream index of the audio stream among the audio streams of the
+ *        file, as the "audioStream" parameter of AudioLoader
+ * @returns the checksum as 32 hexadecimal characters
+ */
+std::string audioMD5(const std::string& filename, int audioStream = 0);
+
+/**
+ * Returns the duration of an audio stream of a file, as stored in its header
+ * (or estimated from its bit rate by FFmpeg if the container does not say),
+ * without reading the audio packets.
+ *
+ * @param filename the name of the file to read
+ * @param audioStream index of the audio stream among the audio streams of the
+ *        file, as the "audioStream" parameter of AudioLoader
+ * @returns the duration in seconds, or a negative value if it is unknown
+ */
+double audioDuration(const std::string& filename, int audioStream = 0);
+
+} // namespace essentia
+
+#endif // ESSENTIA_AUDIOPROBE_H
@@ -30,8 +30,15 @@ const char* MonoLoader::category = essentia::standard::MonoLoader::category;
 const char* MonoLoader::description = essentia::standard::MonoLoader::description;
 
 
+// how much audio to load before and after a slice [s], so that the resampling
+// filter sees the same samples around the slice as when the whole file is
+// loaded
+static const Real resampleMargin = 0.1;
+
+
 MonoLoader::MonoLoader() : AlgorithmComposite(),
-                           _audioLoader(0), _mixer(0), _resample(0), _configured(false) {
+                           _audioLoader(0), _mixer(0), _resample(0), _trimmer(0),
+                           _configured(false) {
 
   declareOutput(_audio, "audio", "the mono audio signal");
 
@@ -40,17 +47,19 @@ MonoLoader::MonoLoader() : AlgorithmComposite(),
   _audioLoader = factory.create("AudioLoader");
   _mixer       = factory.create("MonoMixer");
   _resample    = factory.create("Resample");
+  _trimmer     = factory.create("Trimmer");
 
   _audioLoader->output("audio")           >>  _mixer->input("audio");
   _audioLoader->output("numberChannels")  >>  _mixer->input("numberChannels");
   _mixer->output("audio")                 >>  _resample->input("signal");
+  _resample->output("signal")             >>  _trimmer->input("signal");
 
   _audioLoader->output("md5")        >> NOWHERE;
   _audioLoader->output("bit_rate")   >> NOWHERE;
   _audioLoader->output("codec")      >> NOWHERE;
   _audioLoader->output("sampleRate") >> NOWHERE;
 
-  attach(_resample->output("signal"), _audio);
+  attach(_trimmer->output("signal"), _audio);
 }
 
 void MonoLoader::configure() {
@@ -58,9 +67,25 @@ void MonoLoader::configure() {
   // if no file has been specified, do not do anything
   if (!filename.isConfigured()) return;
 
+  // A slice is loaded from a whole number of seconds before startTime, which
+  // is a whole number of samples at both sampling rates, so that the resampled
+  // samples are the ones that resampling the whole file would give, and then
+  // trimmed after the resampling. The indices are computed as by a Trimmer on
+  // the whole file, in the output sampling rate.
+  Real sampleRate = parameter("sampleRate").toReal();
+  Real startTime = parameter("startTime").toReal();
+  Real endTime = parameter("endTime").toReal();
+  if (startTime > endTime) {
+    throw EssentiaException("MonoLoader: startTime cannot be larger than endTime.");
+  }
+  Real loadStartTime = max(floor(startTime - resampleMargin), (Real)0.);
+  long long loadStart = (long long)(loadStartTime * sampleRate + 0.5);
+
   _audioLoader->configure("filename", filename,
                           "computeMD5", false,
-                          INHERIT("audioStream"));
+                          INHERIT("audioStream"),
+                          "startTime", loadStartTime,
+                          "endTime", endTime + resampleMargin);
 
   int inputSampleRate = (int)lastTokenProduced<Real>(_audioLoader->output("sampleRate"));
 
@@ -74,6 +99,13 @@ void MonoLoader::configure() {
 
   _mixer->configure("type", parameter("downmix"));
 
+  // the middle of the samples, so that the Trimmer rounds to them
+  long long start = (long long)(startTime * sampleRate) - loadStart;
+  long long end = (long long)(endTime * sampleRate) - loadStart;
+  _trimmer->configure("sampleRate", sampleRate,
+                      "startTime", (start + 0.5) / sampleRate,
+                      "endTime", loadStart > 0 ? (end + 0.5) / sampleRate : endTime);
+
 }
 
 } // namespace streaming
@@ -88,6 +120,8 @@ const char* MonoLoader::name = "MonoLoader";
 const char* MonoLoader::category = "Input/output";
 const char* MonoLoader::description = DOC("This algorithm loads the raw audio data from an audio file and downmixes it to mono. Audio is resampled in case the given sampling rate does not match the sampling rate of the input signal.\n"
 "\n"
+"A slice of the file can be loaded with the 'startTime' and 'endTime' parameters, in which case AudioLoader seeks to it and only decodes this part of the file (plus a margin for the resampling). The slice holds the same samples as when trimming the whole file, once resampled, with Trimmer.\n"
+"\n"
 "This algorithm uses AudioLoader and thus inherits all of its input requirements and exceptions.");
 
 
@@ -107,7 +141,9 @@ void MonoLoader::configure() {
   _loader->configure(INHERIT("filename"),
                      INHERIT("sampleRate"),
                      INHERIT("downmix"),
-                     INHERIT("audioStream"));
+                     INHERIT("audioStream"),
+                     INHERIT("startTime"),
+                     INHERIT("endTime"));
 }
 
 void MonoLoader::compute() {
@@ -32,6 +32,7 @@ class MonoLoader : public AlgorithmComposite {
   Algorithm* _audioLoader;
   Algorithm* _mixer;
   Algorithm* _resample;
+  Algorithm* _trimmer;
 
   SourceProxy<AudioSample> _audio;
   bool _configured;
@@ -43,6 +44,7 @@ class MonoLoader : public AlgorithmComposite {
     delete _audioLoader;
     delete _mixer;
     delete _resample;
+    delete _trimmer;
   }
 
   void declareParameters() {
@@ -50,6 +52,8 @@ class MonoLoader : public AlgorithmComposite {
     declareParameter("sampleRate", "the desired output sampling rate [Hz]", "(0,inf)", 44100.);
     declareParameter("downmix", "the mixing type for stereo files", "{left,right,mix}", "mix");
     declareParameter("audioStream", "audio stream index to be loaded. Other streams are no taken into account (e.g. if stream 0 is video and 1 is audio use index 0 to access it.)", "[0,inf)", 0);
+    declareParameter("startTime", "the start time of the slice to be loaded [s]", "[0,inf)", 0.0);
+    declareParameter("endTime", "the end time of the slice to be loaded [s]", "[0,inf)", 1e6);
 
   }
 
@@ -103,6 +107,8 @@ class MonoLoader : public Algorithm {
     declareParameter("sampleRate", "the desired output sampling rate [Hz]", "(0,inf)", 44100.);
     declareParameter("downmix", "the mixing type for stereo files", "{left,right,mix}", "mix");
     declareParameter("audioStream", "audio stream index to be loaded. Other streams are no taken into account (e.g. if stream 0 is video and 1 is audio use index 0 to access it.)", "[0,inf)", 0);
+    declareParameter("startTime", "the start time of the slice to be loaded [s]", "[0,inf)", 0.0);
+    declareParameter("endTime", "the end time of the slice to be loaded [s]", "[0,inf)", 1e6);
 
   }
 
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#include "beattrackerlive.h"
+#include "essentiamath.h"
+
+using namespace std;
+
+namespace essentia {
+namespace standard {
+
+const char* BeatTrackerLive::name = "BeatTrackerLive";
+const char* BeatTrackerLive::category = "Rhythm";
+const char* BeatTrackerLive::description = DOC("This algorithm estimates the tempo and the beat phase of an audio stream in a causal way, frame by frame, so that it can follow a live input. Each call consumes one audio frame (one hop of the stream) and outputs the current tempo estimate, the position of the frame inside the beat period and a confidence value.\n"
+"\n"
+"A mel-frequency spectral flux onset detection function (OnsetDetection with the 'melflux' method) is computed on each frame, and thresholded by subtracting its causal moving average over the last 0.2 seconds. Its autocorrelation is accumulated with an exponential decay given by the 'tempoMemory' parameter, and the beat period is selected by a bank of comb filters weighted by a tempo preference curve centered on 120 BPM, as in TempoTapDegara [1]. The beat phase is the offset maximizing the energy of the onset detection function on the last beats, biased towards the continuation of the previous estimate.\n"
+"\n"
+"All the memory is allocated in configure(), and the latency of the estimates is one frame. Until the history of the onset detection function covers two periods of the slowest tempo (about 3 seconds with the default parameters), the outputs are zero.\n"
+"\n"
+"Quality: experimental (not evaluated; the offline TempoTapDegara and RhythmExtractor2013 are more accurate when the whole signal is available).\n"
+"\n"
+"References:\n"
+"  [1] M. E. P. Davies and M. D. Plumbley, \"Context-dependent beat tracking of\n"
+"  musical audio,\" IEEE Transactions on Audio, Speech, and Language\n"
+"  Processing, vol. 15, no. 3, pp. 1009–1020, 2007.\n"
+"  [2] A. M. Stark, M. E. P. Davies and M. D. Plumbley, \"Real-time beat-synchronous\n"
+"  analysis of musical audio,\" in Proceedings of the 12th International\n"
+"  Conference on Digital Audio Effects (DAFx-09), 2009.");
+
+
+void BeatTrackerLive::configure() {
+  Real sampleRate = parameter("sampleRate").toReal();
+  int frameSize = parameter("frameSize").toInt();
+  int hopSize = parameter("hopSize").toInt();
+  Real minTempo = parameter("minTempo").toInt();
+  Real maxTempo = parameter("maxTempo").toInt();
+
+  if (maxTempo < minTempo + 20) {
+    throw EssentiaException("BeatTrackerLive: maxTempo should be larger than minTempo + 20");
+  }
+
+  _sampleRateODF = sampleRate / hopSize;
+  _minLag = max(1, int(floor(60. * _sampleRateODF / maxTempo)));
+  _maxLag = int(ceil(60. * _sampleRateODF / minTempo));
+  _smoothingSize = max(1, int(round(0.2 * _sampleRateODF)));
+  _decay = exp(-1. / (parameter("tempoMemory").toReal() * _sampleRateODF));
+
+  // Tempo preference weights (Rayleigh distribution) with a peak at 120 BPM,
+  // the same as in TempoTapDegara
+  Real rayparam2 = pow(round(60 * _sampleRateODF / 120), 2);
+  _tempoWeights.resize(_maxLag - _minLag + 1);
+  for (int i=0; i<(int)_tempoWeights.size(); ++i) {
+    int tau = _minLag + i;
+    _tempoWeights[i] = tau / rayparam2 * exp(-0.5 * tau*tau / rayparam2);
+  }
+  normalizeSum(_tempoWeights);
+
+  // the widest comb filter looks at the lags around _numberCombs periods
+  _acf.resize(_numberCombs * (_maxLag + 1));
+  _odf.resize(_acf.size());
+  _raw.resize(_smoothingSize);
+  _scores.resize(_tempoWeights.size());
+
+  _windowing->configure("type", "hann", "size", frameSize);
+  _spectrum->configure("size", frameSize);
+  _onsetDetection->configure("method", "melflux", "sampleRate", sampleRate);
+
+  reset();
+}
+
+void BeatTrackerLive::reset() {
+  fill(_raw.begin(), _raw.end(), Real(0));
+  fill(_odf.begin(), _odf.end(), Real(0));
+  fill(_acf.begin(), _acf.end(), Real(0));
+  _position = 0;
+  _numberFrames = 0;
+  _period = 0;
+  _beatOffset = 0;
+  _onsetDetection->reset();
+}
+
+// value of the thresholded onset detection function delay frames ago
+Real BeatTrackerLive::onsetDetection(int delay) const {
+  int size = (int)_odf.size();
+  return _odf[(_position - delay + size) % size];
+}
+
+void BeatTrackerLive::compute() {
+  const vector<Real>& frame = _frame.get();
+  Real& bpm = _bpm.get();
+  Real& phase = _phase.get();
+  Real& confidence = _confidence.get();
+
+  if (frame.empty()) {
+    throw EssentiaException("BeatTrackerLive: cannot compute on an empty frame");
+  }
+
+  Real detection;
+  _windowing->input("frame").set(frame);
+  _windowing->output("frame").set(_windowedFrame);
+  _windowing->compute();
+  _spectrum->input("frame").set(_windowedFrame);
+  _spectrum->output("spectrum").set(_spectrumFrame);
+  _spectrum->compute();
+  // melflux does not use the phase
+  _onsetDetection->input("spectrum").set(_spectrumFrame);
+  _onsetDetection->input("phase").set(_emptyPhase);
+  _onsetDetection->output("onsetDetection").set(detection);
+  _onsetDetection->compute();
+
+  // adaptive threshold: subtract the causal moving average and half-wave
+  // rectify, to keep only the significant peaks
+  _raw[_numberFrames % _smoothingSize] = detection;
+  Real mean = 0;
+  for (int i=0; i<_smoothingSize; ++i) mean += _raw[i];
+  mean /= min((long long)_smoothingSize, _numberFrames + 1);
+
+  _position = (_position + 1) % (int)_odf.size();
+  _odf[_position] = max(detection - mean, Real(0));
+  _numberFrames++;
+
+  // accumulate the autocorrelation, older frames fading out with a time
+  // constant of tempoMemory
+  Real current = _odf[_position];
+  for (int lag=0; lag<(int)_acf.size(); ++lag) {
+    _acf[lag] = _decay * _acf[lag] + current * onsetDetection(lag);
+  }
+
+  if (_numberFrames < 2 * _maxLag) {
+    bpm = 0;
+    phase = 0;
+    confidence = 0;
+    return;
+  }
+
+  Real period = estimatePeriod(confidence);
+  if (period <= 0) {
+    bpm = 0;
+    phase = 0;
+    return;
+  }
+
+  Real offset = estimateBeatOffset(period);
+  bpm = 60. * _sampleRateODF / period;
+  phase = offset / period;
+}
+
+// Returns the beat period in frames of the onset detection function, or 0 if
+// there is no periodicity at all (eg: silence)
+Real BeatTrackerLive::estimatePeriod(Real& confidence) {
+  // comb filterbank: the k-th comb filter of the bank sums the autocorrelation
+  // around k times the candidate period, with a width growing with k
+  int best = 0;
+  Real total = 0;
+  for (int i=0; i<(int)_scores.size(); ++i) {
+    int lag = _minLag + i;
+    Real score = 0;
+    for (int k=1; k<=_numberCombs; ++k) {
+      Real comb = 0;
+      for (int j=k*lag-k+1; j<=k*lag+k-1; ++j) comb += _acf[j];
+      score += comb / (2*k - 1);
+    }
+    _scores[i] = score * _tempoWeights[i];
+    total += _scores[i];
+    if (_scores[i] > _scores[best]) best = i;
+  }
+
+  Real maximum = _scores[best];
+  if (maximum <= 0) {
+    confidence = 0;
+    return 0;
+  }
+  confidence = 1 - total / (_scores.size() * maximum);
+
+  // refine the period with a parabolic interpolation around the peak
+  Real period = _minLag + best;
+  if (best > 0 && best < (int)_scores.size() - 1) {
+    Real left = _scores[best-1];
+    Real right = _scores[best+1];
+    Real denominator = left - 2*maximum + right;
+    if (denominator < 0) {
+      period += 0.5 * (left - right) / denominator;
+    }
+  }
+  return period;
+}
+
+// Returns the number of frames elapsed since the last beat
+Real BeatTrackerLive::estimateBeatOffset(Real period) {
+  int numberOffsets = int(round(period));
+
+  // the previous offset, one frame older now, in case the period did not
+  // change too much
+  Real predicted = -1;
+  if (_period > 0 && fabs(_period - period) < 0.1 * period) {
+    predicted = fmod(_beatOffset + 1, period);
+  }
+  Real sigma = period / 8;
+
+  int best = 0;
+  Real bestEnergy = -1;
+  for (int offset=0; offset<numberOffsets; ++offset) {
+    // the last beats, the oldest ones weighing less
+    Real energy = 0;
+    Real weight = 1;
+    for (int k=0; k<_numberCombs; ++k) {
+      energy += weight * onsetDetection(offset + int(round(k*period)));
+      weight *= 0.75;
+    }
+
+    if (predicted >= 0) {
+      Real distance = fabs(offset - predicted);
+      distance = min(distance, period - distance);
+      energy *= 0.5 + 0.5 * exp(-0.5 * distance*distance / (sigma*sigma));
+    }
+
+    if (energy > bestEnergy) {
+      bestEnergy = energy;
+      best = offset;
+    }
+  }
+
+  _period = period;
+  _beatOffset = best;
+  return fmod(Real(best), period);
+}
+
+} // namespace standard
+} // namespace essentia
+
+
+namespace essentia {
+namespace streaming {
+
+const char* BeatTrackerLive::name = standard::BeatTrackerLive::name;
+const char* BeatTrackerLive::category = standard::BeatTrackerLive::category;
+const char* BeatTrackerLive::description = standard::BeatTrackerLive::description;
+
+BeatTrackerLive::BeatTrackerLive() : Algorithm() {
+  declareInput(_signal, 1024, 512, "signal", "the input audio signal, eg: the output of a RingBufferInput");
+  declareOutput(_bpm, 1, "bpm", "the current tempo estimate, one per hop [bpm]");
+  declareOutput(_phase, 1, "phase", "the position of the current frame inside the beat period, one per hop, in [0,1) (0 on a beat)");
+  declareOutput(_confidence, 1, "confidence", "the confidence of the tempo estimate, one per hop, in [0,1]");
+
+  _tracker = standard::AlgorithmFactory::create("BeatTrackerLive");
+}
+
+BeatTrackerLive::~BeatTrackerLive() {
+  delete _tracker;
+}
+
+void BeatTrackerLive::configure() {
+  int frameSize = parameter("frameSize").toInt();
+  int hopSize = parameter("hopSize").toInt();
+
+  if (hopSize > frameSize) {
+    throw EssentiaException("BeatTrackerLive: hopSize should not be larger than frameSize");
+  }
+
+  _tracker->configure(_params);
+
+  // frames overlap inside the input buffer, no need for a FrameCutter
+  _signal.setAcquireSize(frameSize);
+  _signal.setReleaseSize(hopSize);
+}
+
+AlgorithmStatus BeatTrackerLive::process() {
+  AlgorithmStatus status = acquireData();
+  if (status != OK) {
+    return status;
+  }
+
+  _tracker->input("frame").set(_signal.tokens());
+  _tracker->output("bpm").set(_bpm.firstToken());
+  _tracker->output("phase").set(_phase.firstToken());
+  _tracker->output("confidence").set(_confidence.firstToken());
+  _tracker->compute();
+
+  releaseData();
+  return OK;
+}
+
+void BeatTrackerLive::reset() {
+  Algorithm::reset();
+  _tracker->reset();
+}
+
+} // namespace streaming
+} // namespace essentia
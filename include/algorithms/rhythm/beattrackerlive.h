@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_BEATTRACKERLIVE_H
+#define ESSENTIA_BEATTRACKERLIVE_H
+
+#include "algorithmfactory.h"
+
+namespace essentia {
+namespace standard {
+
+class BeatTrackerLive : public Algorithm {
+
+ protected:
+  Input<std::vector<Real> > _frame;
+  Output<Real> _bpm;
+  Output<Real> _phase;
+  Output<Real> _confidence;
+
+  Algorithm* _windowing;
+  Algorithm* _spectrum;
+  Algorithm* _onsetDetection;
+
+ public:
+  BeatTrackerLive() {
+    declareInput(_frame, "frame", "the input audio frame, one per hop");
+    declareOutput(_bpm, "bpm", "the current tempo estimate [bpm]");
+    declareOutput(_phase, "phase", "the position of the current frame inside the beat period, in [0,1) (0 on a beat)");
+    declareOutput(_confidence, "confidence", "the confidence of the tempo estimate, in [0,1]");
+
+    _windowing = AlgorithmFactory::create("Windowing");
+    _spectrum = AlgorithmFactory::create("Spectrum");
+    _onsetDetection = AlgorithmFactory::create("OnsetDetection");
+  }
+
+  ~BeatTrackerLive() {
+    if (_windowing) delete _windowing;
+    if (_spectrum) delete _spectrum;
+    if (_onsetDetection) delete _onsetDetection;
+  }
+
+  void declareParameters() {
+    declareParameter("sampleRate", "the sampling rate of the audio signal [Hz]", "(0,inf)", 44100.);
+    declareParameter("frameSize", "the size of the input frames [samples]", "[64,inf)", 1024);
+    declareParameter("hopSize", "the hop size between two consecutive frames [samples]", "[1,inf)", 512);
+    declareParameter("maxTempo", "fastest tempo allowed to be detected [bpm]", "[60,250]", 208);
+    declareParameter("minTempo", "slowest tempo allowed to be detected [bpm]", "[40,180]", 40);
+    declareParameter("tempoMemory", "the time constant over which the periodicity of the onset detection function is accumulated [s]", "(0,inf)", 6.);
+  }
+
+  void reset();
+  void configure();
+  void compute();
+
+  static const char* name;
+  static const char* category;
+  static const char* description;
+
+ private:
+  static const int _numberCombs = 4;
+
+  Real _sampleRateODF;
+  int _minLag;
+  int _maxLag;
+  int _smoothingSize;
+  Real _decay;
+  std::vector<Real> _tempoWeights;
+
+  // ring buffers of the raw and thresholded onset detection function, the
+  // latter holds enough history for the comb filters of the slowest tempo
+  std::vector<Real> _raw;
+  std::vector<Real> _odf;
+  int _position;
+  long long _numberFrames;
+
+  // exponentially decaying autocorrelation of the onset detection function
+  std::vector<Real> _acf;
+  std::vector<Real> _scores;
+  Real _period;
+  Real _beatOffset;
+
+  std::vector<Real> _windowedFrame;
+  std::vector<Real> _spectrumFrame;
+  std::vector<Real> _emptyPhase;
+
+  Real onsetDetection(int delay) const;
+  Real estimatePeriod(Real& confidence);
+  Real estimateBeatOffset(Real period);
+};
+
+} // namespace standard
+} // namespace essentia
+
+
+#include "streamingalgorithm.h"
+
+namespace essentia {
+namespace streaming {
+
+class BeatTrackerLive : public Algorithm {
+
+ protected:
+  Sink<Real> _signal;
+  Source<Real> _bpm;
+  Source<Real> _phase;
+  Source<Real> _confidence;
+
+  standard::Algorithm* _tracker;
+
+ public:
+  BeatTrackerLive();
+  ~BeatTrackerLive();
+
+  void declareParameters() {
+    declareParameter("sampleRate", "the sampling rate of the audio signal [Hz]", "(0,inf)", 44100.);
+    declareParameter("frameSize", "the size of the input frames [samples]", "[64,inf)", 1024);
+    declareParameter("hopSize", "the hop size between two consecutive frames [samples]", "[1,inf)", 512);
+    declareParameter("maxTempo", "fastest tempo allowed to be detected [bpm]", "[60,250]", 208);
+    declareParameter("minTempo", "slowest tempo allowed to be detected [bpm]", "[40,180]", 40);
+    declareParameter("tempoMemory", "the time constant over which the periodicity of the onset detection function is accumulated [s]", "(0,inf)", 6.);
+  }
+
+  void configure();
+  AlgorithmStatus process();
+  void reset();
+
+  static const char* name;
+  static const char* category;
+  static const char* description;
+};
+
+} // namespace streaming
+} // namespace essentia
+
+#endif // ESSENTIA_BEATTRACKERLIVE_H
@@ -20,6 +20,8 @@
 #include "beattrackermultifeature.h"
 #include "poolstorage.h"
 #include "algorithmfactory.h"
+#include <exception>
+#include <thread>
 
 using namespace std;
 
@@ -32,10 +34,11 @@ const char* BeatTrackerMultiFeature::description = essentia::standard::BeatTrack
 
 
 BeatTrackerMultiFeature::BeatTrackerMultiFeature() : AlgorithmComposite(),
-    _frameCutter1(0), _windowing1(0), _fft1(0), _cart2polar1(0), _onsetRms1(0),
-    _onsetComplex1(0), _ticksRms1(0), _ticksComplex1(0), _onsetMelFlux1(0),
-    _ticksMelFlux1(0), _onsetBeatEmphasis3(0), _ticksBeatEmphasis3(0),
-    _onsetInfogain4(0), _ticksInfogain4(0), _scale(0), _configured(false) {
+    _frameCutter1(0), _windowing1(0), _fft1(0), _cart2polar1(0), _onsets1(0),
+    _frameCutter3(0), _windowing3(0),
+    _fft3(0), _cart2polar3(0), _onsetBeatEmphasis3(0),
+    _onsetInfogain4(0), _ticksRms1(0), _ticksComplex1(0), _ticksMelFlux1(0),
+    _ticksBeatEmphasis3(0), _ticksInfogain4(0), _scale(0), _configured(false) {
 
   declareInput(_signal, 1024, "signal", "input signal");
   declareOutput(_ticks, 0, "ticks", "the estimated tick locations [s]");
@@ -54,18 +57,18 @@ void BeatTrackerMultiFeature::createInnerNetwork() {
   _windowing1           = factory.create("Windowing");
   _fft1                 = factory.create("FFT");
   _cart2polar1          = factory.create("CartesianToPolar");
-  _onsetRms1            = factory.create("OnsetDetection");
-  _onsetComplex1        = factory.create("OnsetDetection");
-  _onsetMelFlux1        = factory.create("OnsetDetection");
-  _ticksRms1            = factory.create("TempoTapDegara");
-  _ticksComplex1        = factory.create("TempoTapDegara");
-  _ticksMelFlux1        = factory.create("TempoTapDegara");
-
-  _onsetBeatEmphasis3   = factory.create("OnsetDetectionGlobal");
-  _ticksBeatEmphasis3   = factory.create("TempoTapDegara");
-
-  _onsetInfogain4       = factory.create("OnsetDetectionGlobal");
-  _ticksInfogain4       = factory.create("TempoTapDegara");
+  _onsets1              = factory.create("MultiOnsetDetection");
+  _frameCutter3         = factory.create("FrameCutter");
+  _windowing3           = factory.create("Windowing");
+  _fft3                 = factory.create("FFT");
+  _cart2polar3          = factory.create("CartesianToPolar");
+  _onsetBeatEmphasis3   = factory.create("SpectralOnsetDetectionGlobal");
+  _onsetInfogain4       = factory.create("SpectralOnsetDetectionGlobal");
+  _ticksRms1            = standard::AlgorithmFactory::create("TempoTapDegara");
+  _ticksComplex1        = standard::AlgorithmFactory::create("TempoTapDegara");
+  _ticksMelFlux1        = standard::AlgorithmFactory::create("TempoTapDegara");
+  _ticksBeatEmphasis3   = standard::AlgorithmFactory::create("TempoTapDegara");
+  _ticksInfogain4       = standard::AlgorithmFactory::create("TempoTapDegara");
 
   _tempoTapMaxAgreement = standard::AlgorithmFactory::create("TempoTapMaxAgreement");
 
@@ -81,29 +84,25 @@ void BeatTrackerMultiFeature::createInnerNetwork() {
   _frameCutter1->output("frame")             >>   _windowing1->input("frame");
   _windowing1->output("frame")               >>   _fft1->input("frame");
   _fft1->output("fft")                       >>   _cart2polar1->input("complex");
-  _cart2polar1->output("magnitude")          >>   _onsetComplex1->input("spectrum");
-  _cart2polar1->output("phase")              >>   _onsetComplex1->input("phase");
-  _cart2polar1->output("magnitude")          >>   _onsetRms1->input("spectrum");
-  _cart2polar1->output("phase")              >>   _onsetRms1->input("phase");
-  _cart2polar1->output("magnitude")          >>   _onsetMelFlux1->input("spectrum");
-  _cart2polar1->output("phase")              >>   _onsetMelFlux1->input("phase");
-
-  _onsetComplex1->output("onsetDetection")   >>   _ticksComplex1->input("onsetDetections");
-  _ticksComplex1->output("ticks")            >>   PC(_pool, "internal.ticksComplex");
-  _onsetRms1->output("onsetDetection")       >>   _ticksRms1->input("onsetDetections");
-  _ticksRms1->output("ticks")                >>   PC(_pool, "internal.ticksRms");
-  _onsetMelFlux1->output("onsetDetection")   >>   _ticksMelFlux1->input("onsetDetections");
-  _ticksMelFlux1->output("ticks")            >>   PC(_pool, "internal.ticksMelFlux");
-
-  //_signal                                           >>   _onsetBeatEmphasis3->input("signal");
-  _scale->output("signal")                         >>  _onsetBeatEmphasis3->input("signal");
-  _onsetBeatEmphasis3->output("onsetDetections")   >>  _ticksBeatEmphasis3->input("onsetDetections");
-  _ticksBeatEmphasis3->output("ticks")             >>  PC(_pool, "internal.ticksBeatEmphasis");
-
-  //_signal                                           >> _onsetInfogain4->input("signal");
-  _scale->output("signal")  >> _onsetInfogain4->input("signal");
-  _onsetInfogain4->output("onsetDetections")        >> _ticksInfogain4->input("onsetDetections");
-  _ticksInfogain4->output("ticks")                  >> PC(_pool, "internal.ticksInfogain");
+  _cart2polar1->output("magnitude")          >>   _onsets1->input("spectrum");
+  _cart2polar1->output("phase")              >>   _onsets1->input("phase");
+
+  // one value per method for each frame, split in computeTickCandidates()
+  _onsets1->output("onsetDetections")        >>   PC(_pool, "internal.onsets1");
+
+  // 'beat_emphasis' and 'infogain' detection functions share the same
+  // spectral analysis, and only keep what they need from each frame as the
+  // signal comes in, so that the signal never needs to be stored
+  _scale->output("signal")                   >>   _frameCutter3->input("signal");
+  _frameCutter3->output("frame")             >>   _windowing3->input("frame");
+  _windowing3->output("frame")               >>   _fft3->input("frame");
+  _fft3->output("fft")                       >>   _cart2polar3->input("complex");
+  _cart2polar3->output("magnitude")          >>   _onsetBeatEmphasis3->input("spectrum");
+  _cart2polar3->output("phase")              >>   _onsetBeatEmphasis3->input("phase");
+  _cart2polar3->output("magnitude")          >>   _onsetInfogain4->input("spectrum");
+  _cart2polar3->output("phase")              >>   _onsetInfogain4->input("phase");
+  _onsetBeatEmphasis3->output("onsetDetections") >> PC(_pool, "internal.onsetBeatEmphasis");
+  _onsetInfogain4->output("onsetDetections") >>   PC(_pool, "internal.onsetInfogain");
 
   _network = new scheduler::Network(_scale);
 }
@@ -112,6 +111,11 @@ void BeatTrackerMultiFeature::clearAlgos() {
   if (!_configured) return;
 
   delete _network;
+  delete _ticksRms1;
+  delete _ticksComplex1;
+  delete _ticksMelFlux1;
+  delete _ticksBeatEmphasis3;
+  delete _ticksInfogain4;
   delete _tempoTapMaxAgreement;
 }
 
@@ -155,9 +159,8 @@ void BeatTrackerMultiFeature::configure() {
 
   _windowing1->configure("size", frameSize1, "type", "hann");
   _fft1->configure("size", frameSize1);
-  _onsetComplex1->configure("method", "complex");
-  _onsetRms1->configure("method", "rms");
-  _onsetMelFlux1->configure("method", "melflux");
+  const char* methods1[] = { "complex", "rms", "melflux" };
+  _onsets1->configure("methods", arrayToVector<string>(methods1));
   _ticksComplex1->configure("sampleRateODF", _sampleRate/hopSize1,
                             "resample", "x2",
                             "minTempo", minTempo,
@@ -177,6 +180,17 @@ void BeatTrackerMultiFeature::configure() {
   // NB: better than 2048/1024 plus x2 resampling according to evaluation (JZapata)
   // 2048/512 works better than 1024/512 for 'beat_emphasis' OSD according to
   // evaluation results (DBogdanov)
+
+  // frames are cut and windowed as OnsetDetectionGlobal does it
+  _frameCutter3->configure("frameSize", frameSize3,
+                           "hopSize", hopSize3,
+                           "silentFrames", "keep",
+                           "startFromZero", true);
+  _windowing3->configure("size", frameSize3,
+                         "zeroPadding", 0,
+                         "type", "hann");
+  _fft3->configure("size", frameSize3);
+
   _onsetBeatEmphasis3->configure("method", "beat_emphasis",
                                   "sampleRate", _sampleRate,
                                   "frameSize", frameSize3,
@@ -186,8 +200,10 @@ void BeatTrackerMultiFeature::configure() {
                                   "minTempo", minTempo,
                                   "maxTempo", maxTempo);
 
-  int frameSize4 = 2048;
-  int hopSize4 = 512;
+  // shares the spectra of 'beat_emphasis', so frameSize4 and hopSize4 have
+  // to be the same as frameSize3 and hopSize3
+  int frameSize4 = frameSize3;
+  int hopSize4 = hopSize3;
   // NB: 2048/512 performs better than 1024/512 accoding to evaluation (JZapata)
   _onsetInfogain4->configure("method", "infogain",
                              "sampleRate", _sampleRate,
@@ -208,25 +224,7 @@ AlgorithmStatus BeatTrackerMultiFeature::process() {
   vector<Real> ticks;
   Real confidence;
 
-  tickCandidates.resize(5);
-
-  // ticks candidates might be empty for very short signals, but
-  // it is ok to feed empty tick vetors to TempoTapMaxAgreement
-  if (_pool.contains<vector<Real> >("internal.ticksComplex")) {
-    tickCandidates[0] = _pool.value<vector<Real> >("internal.ticksComplex");
-  }
-  if (_pool.contains<vector<Real> >("internal.ticksRms")) {
-    tickCandidates[1] = _pool.value<vector<Real> >("internal.ticksRms");
-  }
-  if (_pool.contains<vector<Real> >("internal.ticksMelFlux")) {
-    tickCandidates[2] = _pool.value<vector<Real> >("internal.ticksMelFlux");
-  }
-  if (_pool.contains<vector<Real> >("internal.ticksBeatEmphasis")) {
-    tickCandidates[3] = _pool.value<vector<Real> >("internal.ticksBeatEmphasis");
-  }
-  if (_pool.contains<vector<Real> >("internal.ticksInfogain")) {
-    tickCandidates[4] = _pool.value<vector<Real> >("internal.ticksInfogain");
-  }
+  computeTickCandidates(tickCandidates);
 
   _tempoTapMaxAgreement->input("tickCandidates").set(tickCandidates);
   _tempoTapMaxAgreement->output("ticks").set(ticks);
@@ -241,8 +239,103 @@ AlgorithmStatus BeatTrackerMultiFeature::process() {
 }
 
 
+// Computes the ticks of one detection branch. Exceptions are kept so that
+// they can be rethrown from the calling thread.
+static void computeTicks(standard::Algorithm* tempoTap,
+                         const vector<Real>* input,
+                         vector<Real>* ticks,
+                         exception_ptr* error) {
+  try {
+    tempoTap->input("onsetDetections").set(*input);
+    tempoTap->output("ticks").set(*ticks);
+    tempoTap->compute();
+  }
+  catch (...) {
+    *error = current_exception();
+  }
+}
+
+// joins the threads it is given when going out of scope, so that they are
+// also joined when starting one of them throws
+class ThreadJoiner {
+ public:
+  explicit ThreadJoiner(vector<thread>& threads) : _threads(threads) {}
+  ~ThreadJoiner() {
+    for (int i=0; i<(int)_threads.size(); ++i) {
+      if (_threads[i].joinable()) _threads[i].join();
+    }
+  }
+
+ private:
+  vector<thread>& _threads;
+};
+
+void BeatTrackerMultiFeature::computeTickCandidates(vector<vector<Real> >& tickCandidates) {
+  const int numberBranches = 5;
+  static const vector<Real> empty;
+
+  // onset detection functions might be missing for very short signals, in
+  // which case the branch yields no ticks, and it is ok to feed empty tick
+  // vectors to TempoTapMaxAgreement
+  standard::Algorithm* tempoTaps[numberBranches] = { _ticksComplex1,
+                                                     _ticksRms1,
+                                                     _ticksMelFlux1,
+                                                     _ticksBeatEmphasis3,
+                                                     _ticksInfogain4 };
+  const vector<Real>* inputs[numberBranches];
+
+  // the complex, rms and melflux detection functions are computed together,
+  // each frame holding one value per method
+  const int numberMethods1 = 3;
+  vector<Real> onsets1[numberMethods1];
+  if (_pool.contains<vector<vector<Real> > >("internal.onsets1")) {
+    const vector<vector<Real> >& frames = _pool.value<vector<vector<Real> > >("internal.onsets1");
+    for (int i=0; i<numberMethods1; ++i) {
+      onsets1[i].resize(frames.size());
+      for (int t=0; t<(int)frames.size(); ++t) onsets1[i][t] = frames[t][i];
+    }
+  }
+  for (int i=0; i<numberMethods1; ++i) inputs[i] = &onsets1[i];
+
+  const char* descriptors[] = { "internal.onsetBeatEmphasis",
+                                "internal.onsetInfogain" };
+  for (int i=numberMethods1; i<numberBranches; ++i) {
+    const char* descriptor = descriptors[i - numberMethods1];
+    inputs[i] = _pool.contains<vector<Real> >(descriptor) ?
+                &_pool.value<vector<Real> >(descriptor) : &empty;
+  }
+
+  // each branch owns its algorithms and only reads from the pool, so they can
+  // safely run in parallel; the results do not depend on the scheduling
+  tickCandidates.clear();
+  tickCandidates.resize(numberBranches);
+  vector<exception_ptr> errors(numberBranches);
+  vector<thread> threads;
+  threads.reserve(numberBranches-1);
+
+  {
+    ThreadJoiner joiner(threads);
+    for (int i=1; i<numberBranches; ++i) {
+      threads.push_back(thread(computeTicks, tempoTaps[i], inputs[i],
+                               &tickCandidates[i], &errors[i]));
+    }
+    // the calling thread takes care of the first branch itself
+    computeTicks(tempoTaps[0], inputs[0], &tickCandidates[0], &errors[0]);
+  }
+
+  for (int i=0; i<numberBranches; ++i) {
+    if (errors[i]) rethrow_exception(errors[i]);
+  }
+}
+
+
 void BeatTrackerMultiFeature::reset() {
   AlgorithmComposite::reset();
+  _ticksRms1->reset();
+  _ticksComplex1->reset();
+  _ticksMelFlux1->reset();
+  _ticksBeatEmphasis3->reset();
+  _ticksInfogain4->reset();
   _tempoTapMaxAgreement->reset();
 }
 
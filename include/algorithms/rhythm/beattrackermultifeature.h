@@ -42,18 +42,25 @@ class BeatTrackerMultiFeature : public AlgorithmComposite {
   Algorithm* _windowing1;
   Algorithm* _fft1;
   Algorithm* _cart2polar1;
-  Algorithm* _onsetRms1;
-  Algorithm* _onsetComplex1;
-  Algorithm* _ticksRms1;
-  Algorithm* _ticksComplex1;
-  Algorithm* _onsetMelFlux1;
-  Algorithm* _ticksMelFlux1;
-
+  // 'complex', 'rms' and 'melflux' detection functions, computed together
+  Algorithm* _onsets1;
+  // 'beat_emphasis' and 'infogain' use the same 2048/512 frames, their
+  // spectra are computed once for both
+  Algorithm* _frameCutter3;
+  Algorithm* _windowing3;
+  Algorithm* _fft3;
+  Algorithm* _cart2polar3;
   Algorithm* _onsetBeatEmphasis3;
-  Algorithm* _ticksBeatEmphasis3;
-
   Algorithm* _onsetInfogain4;
-  Algorithm* _ticksInfogain4;
+
+  // the beat trackers only run once the whole stream has been seen, their
+  // five branches are independent from each other and are computed
+  // concurrently in process()
+  standard::Algorithm* _ticksRms1;
+  standard::Algorithm* _ticksComplex1;
+  standard::Algorithm* _ticksMelFlux1;
+  standard::Algorithm* _ticksBeatEmphasis3;
+  standard::Algorithm* _ticksInfogain4;
 
   standard::Algorithm* _tempoTapMaxAgreement;
 
@@ -64,6 +71,7 @@ class BeatTrackerMultiFeature : public AlgorithmComposite {
 
   void createInnerNetwork();
   void clearAlgos();
+  void computeTickCandidates(std::vector<std::vector<Real> >& tickCandidates);
   Real _sampleRate;
 
  public:
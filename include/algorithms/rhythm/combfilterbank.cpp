@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#include "combfilterbank.h"
+#include "essentia.h"
+
+using namespace std;
+
+namespace essentia {
+namespace standard {
+
+void CombFilterbank::configure(const vector<Real>& weights, int periodMin, int periodMax,
+                               int numberCombs, int lagOffset, int size) {
+  if (periodMin < 0 || periodMax >= size || periodMax >= (int)weights.size()) {
+    throw EssentiaException("CombFilterbank: the range of periods does not fit in the output or in the weights");
+  }
+
+  _size = size;
+  _periodMin = periodMin;
+  _acfSize = 0;
+  _rowBegin.clear();
+  _columns.clear();
+  _coefficients.clear();
+
+  int numberRows = max(periodMax - periodMin + 1, 0);
+  _rowBegin.reserve(numberRows + 1);
+  _columns.reserve(numberRows * numberCombs * numberCombs);
+  _coefficients.reserve(numberRows * numberCombs * numberCombs);
+
+  for (int period=periodMin; period<=periodMax; ++period) {
+    _rowBegin.push_back((int)_columns.size());
+    for (int comb=1; comb<=numberCombs; ++comb) {
+      int width = 2*comb - 1;
+      int center = (period + lagOffset) * comb - lagOffset;
+      for (int region=1-comb; region<=comb-1; ++region) {
+        int lag = center + region;
+        if (lag < 0) {
+          throw EssentiaException("CombFilterbank: the combs of period ", period, " reach negative lags");
+        }
+        _columns.push_back(lag);
+        _coefficients.push_back(weights[period] / width);
+        _acfSize = max(_acfSize, lag + 1);
+      }
+    }
+  }
+  _rowBegin.push_back((int)_columns.size());
+}
+
+void CombFilterbank::compute(const vector<Real>& acf, vector<Real>& output) const {
+  if ((int)acf.size() < _acfSize) {
+    throw EssentiaException("CombFilterbank: the autocorrelation is shorter than the widest comb (", _acfSize, " lags)");
+  }
+
+  output.assign(_size, (Real) 0.);
+
+  const int numberRows = (int)_rowBegin.size() - 1;
+  for (int row=0; row<numberRows; ++row) {
+    Real sum = 0;
+    for (int i=_rowBegin[row]; i<_rowBegin[row+1]; ++i) {
+      sum += _coefficients[i] * acf[_columns[i]];
+    }
+    output[_periodMin + row] = sum;
+  }
+}
+
+} // namespace standard
+} // namespace essentia
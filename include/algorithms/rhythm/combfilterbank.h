@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_COMBFILTERBANK_H
+#define ESSENTIA_COMBFILTERBANK_H
+
+#include <vector>
+#include "types.h"
+
+namespace essentia {
+namespace standard {
+
+/**
+ * Comb filterbank reflecting the periodicities found in an autocorrelation
+ * function on several metrical levels, as in the beat period estimation by
+ * Davies and Plumbley used by TempoTapDegara and by the beat emphasis
+ * function of OnsetDetectionGlobal.
+ *
+ * The output for a period p sums, for each comb c = 1..numberCombs, the
+ * 2c-1 autocorrelation values around the lag (p + lagOffset) * c - lagOffset,
+ * each comb element having a width proportional to c to account for the poor
+ * resolution of the autocorrelation at short lags, and its height normalized
+ * by its width. The result is weighted by a tempo preference curve.
+ *
+ * All the weights are precomputed in configure() as a sparse matrix in
+ * compressed row format (one row per period, the elements of a row being in
+ * the order in which they were summed by the original nested loops), so that
+ * filtering an autocorrelation is a single sparse matrix-vector product,
+ * without any division nor allocation.
+ */
+class CombFilterbank {
+ public:
+  CombFilterbank() : _size(0), _periodMin(0), _acfSize(0) {}
+
+  /**
+   * @param weights tempo preference weight of each period
+   * @param periodMin first period to compute
+   * @param periodMax last period to compute, included
+   * @param numberCombs number of metrical levels
+   * @param lagOffset offset between a period and its lag in the
+   *        autocorrelation, see above
+   * @param size size of the output, the periods outside of
+   *        [periodMin, periodMax] being 0
+   */
+  void configure(const std::vector<Real>& weights, int periodMin, int periodMax,
+                 int numberCombs, int lagOffset, int size);
+
+  void compute(const std::vector<Real>& acf, std::vector<Real>& output) const;
+
+ private:
+  int _size;
+  int _periodMin;
+  int _acfSize;  // smallest autocorrelation covering all the combs
+  std::vector<int> _rowBegin;
+  std::vector<int> _columns;
+  std::vector<Real> _coefficients;
+};
+
+} // namespace standard
+} // namespace essentia
+
+#endif // ESSENTIA_COMBFILTERBANK_H
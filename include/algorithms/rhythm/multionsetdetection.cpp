@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#include "multionsetdetection.h"
+#include <complex>
+#include "essentiamath.h"
+
+using namespace std;
+
+namespace essentia {
+namespace standard {
+
+const char* MultiOnsetDetection::name = "MultiOnsetDetection";
+const char* MultiOnsetDetection::category = "Rhythm";
+const char* MultiOnsetDetection::description = DOC("This algorithm computes several of the onset detection functions of the OnsetDetection algorithm at once, on the same spectrum. It outputs one value per method for each frame, in the order given by the \"methods\" parameter, which are the same as the outputs of one OnsetDetection algorithm configured with each of these methods.\n"
+"\n"
+"The previous frames needed by the 'complex', 'complex_phase', 'flux' and 'melflux' methods are only stored once, and all the methods working on the bins of the spectrum ('hfc', 'complex', 'complex_phase', 'flux' and 'rms') are computed in a single pass over the spectrum, so that it is faster than several OnsetDetection algorithms connected to the same spectrum (eg: the 'complex', 'rms' and 'melflux' functions of BeatTrackerMultiFeature, or the 'hfc' and 'complex' ones of OnsetRate).\n"
+"\n"
+"If the size of the spectrum changes, the previous frames are reset to zero. The 'phase' input is only required by the 'complex' and 'complex_phase' methods, in which case it must have the same size as the spectrum, otherwise an exception is thrown. An exception is also thrown on an empty spectrum, and if an unknown method is given.");
+
+// Same as essentia::fmod(phase, -2*M_PI) as used by OnsetDetection, which
+// is floor-based and returns values in (-2*pi, 0]. Away from the multiples
+// of 2*pi the quotient is known without computing the division, and the
+// remaining subtraction is the same, so the result is identical.
+static inline double wrapPhase(double phase) {
+  const double period = 2 * M_PI;
+  const double margin = 1e-6;
+  if (phase > margin && phase < period - margin) return phase - period;
+  if (phase > -period + margin && phase < -margin) return phase;
+  if (phase > period + margin && phase < 2*period - margin) return phase - 2*period;
+  return essentia::fmod(phase, -period);
+}
+
+void MultiOnsetDetection::configure() {
+  _sampleRate = parameter("sampleRate").toReal();
+  vector<string> methods = parameter("methods").toVectorString();
+
+  if (methods.empty()) {
+    throw EssentiaException("MultiOnsetDetection: at least one method is needed");
+  }
+
+  _methods.clear();
+  _useComplex = false;
+  _useComplexPhase = false;
+  _useMelBands = false;
+  for (int i=0; i<(int)methods.size(); ++i) {
+    string method = toLower(methods[i]);
+    if (method == "hfc") _methods.push_back(HFC);
+    else if (method == "complex") _methods.push_back(COMPLEX);
+    else if (method == "complex_phase") _methods.push_back(COMPLEX_PHASE);
+    else if (method == "flux") _methods.push_back(FLUX);
+    else if (method == "melflux") _methods.push_back(MELFLUX);
+    else if (method == "rms") _methods.push_back(RMS);
+    else {
+      throw EssentiaException("MultiOnsetDetection: unknown onset detection method: ", methods[i]);
+    }
+    if (method == "complex") _useComplex = true;
+    if (method == "complex_phase") _useComplexPhase = true;
+    if (method == "melflux") _useMelBands = true;
+  }
+
+  _melBands->configure("sampleRate", _sampleRate,
+                       "numberBands", 40,
+                       "lowFrequencyBound", 0.0,
+                       "highFrequencyBound", 4000.0);
+
+  reset();
+}
+
+void MultiOnsetDetection::compute() {
+  const vector<Real>& spectrum = _spectrum.get();
+  const vector<Real>& phase = _phase.get();
+  vector<Real>& onsetDetections = _onsetDetections.get();
+
+  if (spectrum.empty()) {
+    throw EssentiaException("MultiOnsetDetection: cannot compute the onset detection functions of an empty spectrum");
+  }
+  bool usePhase = _useComplex || _useComplexPhase;
+  if (usePhase && spectrum.size() != phase.size()) {
+    throw EssentiaException("MultiOnsetDetection: Spectrum and phase cannot be of different size");
+  }
+
+  int size = (int) spectrum.size();
+  if ((int) _spectrum_1.size() != size) {
+    _spectrum_1.assign(size, Real(0.0));
+    _phase_1.assign(size, Real(0.0));
+    _phase_2.assign(size, Real(0.0));
+  }
+
+  // Coefficient to convert bins into frequency, as in HFC
+  Real bin2hz = 0.;
+  if (size > 1) {
+    bin2hz = (_sampleRate/2.0) / (Real)(size - 1);
+  }
+
+  // All the bin-wise functions in a single pass. Each of them is accumulated
+  // in the same order as in OnsetDetection, which gives the same values.
+  Real hfc = 0;
+  Real energy = 0;
+  Real flux = 0;
+  Real complexDomain = 0;
+  Real complexPhase = 0;
+
+  for (int i=0; i<size; ++i) {
+    // 'hfc': Brossier's high frequency content
+    hfc += (Real)i * bin2hz * spectrum[i];
+    // 'rms'
+    energy += spectrum[i] * spectrum[i];
+    // 'flux': L1 norm of the difference with the previous spectrum
+    flux += abs(spectrum[i] - _spectrum_1[i]);
+
+    // Complex-domain detection function for non-percussive onsets (Bello, [1]
+    // in OnsetDetection)
+    if (_useComplex) {
+      Real targetPhase = 2*_phase_1[i] - _phase_2[i];
+      targetPhase = wrapPhase(targetPhase + M_PI) + M_PI;
+      Real distance = abs(_spectrum_1[i] - polar(spectrum[i], phase[i]-targetPhase));
+      complexDomain += distance;
+    }
+
+    // Complex-domain detection function ignoring the magnitude difference
+    // (Brossier, [2] in OnsetDetection)
+    if (_useComplexPhase) {
+      Real targetPhase = 2*_phase_1[i] + _phase_2[i];
+      Real distance = 2.0 * spectrum[i] * sin((phase[i]-targetPhase)*0.5);
+      complexPhase += distance * distance;
+    }
+  }
+
+  // 'melflux': half-rectified L1 flux of the log-magnitude Mel-frequency
+  // spectrum (see OnsetDetection)
+  Real melFlux = 0;
+  if (_useMelBands) {
+    _melBands->input("spectrum").set(spectrum);
+    _melBands->output("bands").set(_melBandsFrame);
+    _melBands->compute();
+
+    for (int i=0; i<(int)_melBandsFrame.size(); ++i) {
+      _melBandsFrame[i] = amp2db(_melBandsFrame[i]);
+    }
+    if (_melBands_1.size() != _melBandsFrame.size()) {
+      _melBands_1.assign(_melBandsFrame.size(), Real(0.0));
+    }
+    for (int i=0; i<(int)_melBandsFrame.size(); ++i) {
+      Real diff = _melBandsFrame[i] - _melBands_1[i];
+      if (diff < 0) continue;
+      melFlux += diff;
+    }
+    _melBands_1.swap(_melBandsFrame);
+  }
+
+  Real rms = sqrt(energy) / size;
+  Real rmsFlux = rms - _rmsOld;
+  if (rmsFlux < 0) { // half-rectify
+    rmsFlux = 0;
+  }
+  _rmsOld = rms;
+
+  onsetDetections.resize(_methods.size());
+  for (int j=0; j<(int)_methods.size(); ++j) {
+    switch (_methods[j]) {
+      case HFC: onsetDetections[j] = hfc; break;
+      case COMPLEX: onsetDetections[j] = complexDomain; break;
+      case COMPLEX_PHASE: onsetDetections[j] = complexPhase; break;
+      case FLUX: onsetDetections[j] = flux; break;
+      // a hack to remove the click in the first frame, as in OnsetDetection
+      case MELFLUX: onsetDetections[j] = _firstFrame ? 0 : melFlux; break;
+      case RMS: onsetDetections[j] = _firstFrame ? 0 : rmsFlux; break;
+    }
+  }
+  _firstFrame = false;
+
+  // keep the current frame for the next one, without reallocating
+  if (usePhase) {
+    _phase_2.swap(_phase_1);
+    _phase_1.assign(phase.begin(), phase.end());
+  }
+  _spectrum_1.assign(spectrum.begin(), spectrum.end());
+}
+
+void MultiOnsetDetection::reset() {
+  _phase_1.clear();
+  _phase_2.clear();
+  _spectrum_1.clear();
+  _melBands_1.clear();
+  _melBands->reset();
+  _rmsOld = 0;
+  _firstFrame = true;
+}
+
+} // namespace standard
+} // namespace essentia
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_MULTIONSETDETECTION_H
+#define ESSENTIA_MULTIONSETDETECTION_H
+
+#include "algorithmfactory.h"
+
+namespace essentia {
+namespace standard {
+
+class MultiOnsetDetection : public Algorithm {
+
+ private:
+  Input<std::vector<Real> > _spectrum;
+  Input<std::vector<Real> > _phase;
+  Output<std::vector<Real> > _onsetDetections;
+
+  Algorithm* _melBands;
+
+  enum Method { HFC, COMPLEX, COMPLEX_PHASE, FLUX, MELFLUX, RMS };
+  std::vector<Method> _methods;
+  bool _useComplex;
+  bool _useComplexPhase;
+  bool _useMelBands;
+  Real _sampleRate;
+
+  // previous frames, shared by all the methods
+  std::vector<Real> _phase_1;
+  std::vector<Real> _phase_2;
+  std::vector<Real> _spectrum_1;
+  std::vector<Real> _melBands_1;
+  std::vector<Real> _melBandsFrame;
+  Real _rmsOld;
+  bool _firstFrame;
+
+ public:
+  MultiOnsetDetection() {
+    declareInput(_spectrum, "spectrum", "the input spectrum");
+    declareInput(_phase, "phase", "the phase vector corresponding to this spectrum (used only by the \"complex\" and \"complex_phase\" methods)");
+    declareOutput(_onsetDetections, "onsetDetections", "the values of the detection functions in the current frame, in the order of the \"methods\" parameter");
+
+    _melBands = AlgorithmFactory::create("MelBands");
+  }
+
+  ~MultiOnsetDetection() {
+    if (_melBands) delete _melBands;
+  }
+
+  void declareParameters() {
+    const char* methods[] = { "hfc", "complex" };
+    declareParameter("methods", "the methods used for onset detection, among {hfc,complex,complex_phase,flux,melflux,rms} (see OnsetDetection)", "", arrayToVector<std::string>(methods));
+    declareParameter("sampleRate", "the sampling rate of the audio signal [Hz]", "(0,inf)", 44100.0);
+  }
+
+  void reset();
+  void configure();
+  void compute();
+
+  static const char* name;
+  static const char* category;
+  static const char* description;
+};
+
+} // namespace standard
+} // namespace essentia
+
+#include "streamingalgorithmwrapper.h"
+
+namespace essentia {
+namespace streaming {
+
+class MultiOnsetDetection : public StreamingAlgorithmWrapper {
+
+ protected:
+  Sink<std::vector<Real> > _phase;
+  Sink<std::vector<Real> > _spectrum;
+  Source<std::vector<Real> > _onsetDetections;
+
+ public:
+  MultiOnsetDetection() {
+    declareAlgorithm("MultiOnsetDetection");
+    declareInput(_spectrum, TOKEN, "spectrum");
+    declareInput(_phase, TOKEN, "phase");
+    declareOutput(_onsetDetections, TOKEN, "onsetDetections");
+  }
+};
+
+} // namespace streaming
+} // namespace essentia
+
+#endif // ESSENTIA_MULTIONSETDETECTION_H
@@ -121,7 +121,8 @@ void OnsetDetection::compute() {
       onsetDetection += distance * distance;
     }
 
-    _phase_2 = _phase_1;
+    // shift the history without copying it twice
+    _phase_2.swap(_phase_1);
     _phase_1 = phase;
     return;
   }
@@ -151,7 +152,8 @@ void OnsetDetection::compute() {
       onsetDetection += distance;
     }
 
-    _phase_2 = _phase_1;
+    // shift the history without copying it twice
+    _phase_2.swap(_phase_1);
     _phase_1 = phase;
     _spectrum_1 = spectrum;
     return;
@@ -187,7 +189,7 @@ void OnsetDetection::compute() {
           initialized with zero vector while we feed it with log-magnitudes instead of magnitudes.
 
     */
-    vector <Real> melbands;
+    vector<Real>& melbands = _melbands;
     _melBands->input("spectrum").set(spectrum);
     _melBands->output("bands").set(melbands);
     _melBands->compute();
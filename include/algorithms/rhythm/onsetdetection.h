@@ -70,6 +70,7 @@ class OnsetDetection : public Algorithm {
   std::vector<Real> _phase_1;
   std::vector<Real> _phase_2;
   std::vector<Real> _spectrum_1;
+  std::vector<Real> _melbands;
   Real _rmsOld;
   bool _firstFrame;
 };
@@ -73,6 +73,7 @@ void OnsetDetectionGlobal::configure() {
 
     // reversed triangle weighting
     _weights.clear();
+    _rweights.clear();
     for (int i=0; i < _histogramSize; i++) {
       Real weight = 1 - i * 0.9/_histogramSize;
       _weights.push_back(weight);                   // 1, 0.82, 0.64, 0.46, 0.28
@@ -123,167 +124,214 @@ void OnsetDetectionGlobal::configure() {
       int tau = i+1;
       _weights[i] = tau / rayparam2 * exp(-0.5 * tau*tau / rayparam2);
     }
+
+    // To accout for poor resolution of ACF at short lags, each comb element has
+    // width proportional to its relationship to the underlying periodicity, and
+    // its height is normalized by its width.
+
+    // 0-th element in autocorrelation vector corresponds to the period of 1.
+    // Min value for the 'region' variable is -3 => compute starting from the
+    // 3-rd index, which corresponds to the period of 4, until period of 120
+    // ODF samples (as in matlab code) or 110 (as in the paper). Generalization:
+    // not clear why max period is 120 or 110, should be (512 - 3) / 4 = 127
+    int numberCombs = 4;
+    int periodMin = 4 - 1;
+    int periodMax = (_maxPeriodODF-(numberCombs-1)) / numberCombs - 1;
+    // period index i corresponds to the ACF lag of i*comb, periodMax itself
+    // is not included
+    _combFilterbank.configure(_weights, periodMin, periodMax-1, numberCombs, 0, _maxPeriodODF);
   }
 }
 
 void OnsetDetectionGlobal::compute() {
   const vector<Real>& signal = _signal.get();
+  vector<Real>& onsetDetections = _onsetDetections.get();
+  onsetDetections.clear();
   if (signal.empty()) {
-    vector<Real>& onsetDetections = _onsetDetections.get();
-    onsetDetections.clear();
     return;
   }
 
   _frameCutter->input("signal").set(signal);
   _frameCutter->output("frame").set(_frame);
 
-  _windowing->input("frame").set(_frame);
+  startFrames();
+  while (true) {
+    // get a frame
+    _frameCutter->compute();
+
+    if (!_frame.size()) {
+      break;
+    }
+    processFrame(_frame, onsetDetections);
+  }
+  finishFrames(onsetDetections);
+}
+
+void OnsetDetectionGlobal::startFrames() {
   _windowing->output("frame").set(_frameWindowed);
+  _numberFrames = 0;
 
   if (_method=="infogain") {
-    computeInfoGain();
+    // circular buffer of the last _bufferSize spectra, stored contiguously,
+    // the oldest one starting at index _oldest
+    _history.assign(_bufferSize * _numberFFTBins, 0);
+    _oldest = 0;
+    _histogramOld.assign(_numberFFTBins, 0);
+    _histogramNew.assign(_numberFFTBins, 0);
+
+    _spectrum->input("frame").set(_frameWindowed);
+    _spectrum->output("spectrum").set(_spectrumFrame);
   }
   else if (_method=="beat_emphasis") {
-    computeBeatEmphasis();
+    _fft->input("frame").set(_frameWindowed);
+    _fft->output("fft").set(_frameFFT);
+
+    _cartesian2polar->input("complex").set(_frameFFT);
+    _cartesian2polar->output("magnitude").set(_spectrumFrame);
+    _cartesian2polar->output("phase").set(_phaseFrame);
+
+    fill(_phase_1.begin(), _phase_1.end(), Real(0.0));
+    fill(_phase_2.begin(), _phase_2.end(), Real(0.0));
+    fill(_spectrum_1.begin(), _spectrum_1.end(), Real(0.0));
+
+    _onsetERB.assign(_numberERBBands, vector<Real>());
+    _tempFFT.assign(_numberFFTBins, 0.);  // detection function in FFT bins
+    _tempERB.assign(_numberERBBands, 0.); // detection function in ERP bands
+
+    // NB: a hack to make use of ERBBands algorithm and not reimplement the
+    // computation of gammatone filterbank weights again. As long as ERBBands
+    // computes weighted magnitudes in each ERB band instead of energy, we can
+    // feed it onset detection values instead of spectrum.
+    _erbbands->input("spectrum").set(_tempFFT);
+    _erbbands->output("bands").set(_tempERB);
   }
 }
 
-void OnsetDetectionGlobal::computeInfoGain() {
-  vector<Real>& onsetDetections = _onsetDetections.get();
-
-  vector<vector<Real> > buffer(_bufferSize, vector<Real> (_numberFFTBins, 0));
-  vector<Real> histogramOld(_numberFFTBins, 0);
-  vector<Real> histogramNew(_numberFFTBins, 0);
+void OnsetDetectionGlobal::processFrame(const vector<Real>& frame,
+                                        vector<Real>& onsetDetections) {
+  _windowing->input("frame").set(frame);
+  _windowing->compute();
 
-  vector<Real> spectrum;
-  _spectrum->input("frame").set(_frameWindowed);
-  _spectrum->output("spectrum").set(spectrum);
+  if (_method=="infogain") {
+    _spectrum->compute();
+  }
+  else if (_method=="beat_emphasis") {
+    _fft->compute();
+    _cartesian2polar->compute();
+  }
+  processSpectrum(_spectrumFrame, _phaseFrame, onsetDetections);
+}
 
-  while (true) {
-    // get a frame
-    _frameCutter->compute();
+void OnsetDetectionGlobal::processSpectrum(const vector<Real>& spectrum,
+                                           const vector<Real>& phase,
+                                           vector<Real>& onsetDetections) {
+  if (_method=="infogain") {
+    processFrameInfoGain(spectrum, onsetDetections);
+  }
+  else if (_method=="beat_emphasis") {
+    processFrameBeatEmphasis(spectrum, phase);
+  }
+  _numberFrames += 1;
+}
 
-    if (!_frame.size()) {
-      break;
-    }
-    _windowing->compute();
-    _spectrum->compute();
+void OnsetDetectionGlobal::finishFrames(vector<Real>& onsetDetections) {
+  // original infogain algorithm includes smoothing Hanning filter (length = 20
+  // frames): df2 = filtfilt(hanning(20)/sum(hanning(20)),1,df)
+  // we omit smoothing, as it should be done on the post-processing stage
+  if (_method=="beat_emphasis") {
+    computeBeatEmphasis(onsetDetections);
+  }
+}
 
-    // update buffer; take only bins we are interested in
-    buffer.erase(buffer.begin());
-    buffer.push_back(vector<Real>(spectrum.begin() + _minFrequencyBin,
-                        spectrum.begin() + _maxFrequencyBin));
+void OnsetDetectionGlobal::processFrameInfoGain(const vector<Real>& spectrum,
+                                                vector<Real>& onsetDetections) {
+  if ((int)spectrum.size() < _maxFrequencyBin) {
+    throw EssentiaException("OnsetDetectionGlobal: the spectrum is smaller than expected for the configured frameSize");
+  }
 
-    // compute weighted sum of magnitudes for each bin
+  // update buffer: overwrite the oldest frame; take only bins we are
+  // interested in
+  copy(spectrum.begin() + _minFrequencyBin, spectrum.begin() + _maxFrequencyBin,
+       _history.begin() + _oldest * _numberFFTBins);
+  _oldest = (_oldest + 1) % _bufferSize;
+
+  // compute weighted sum of magnitudes for each bin. Frames are accumulated
+  // in the same order for each bin as before, the inner loops over bins are
+  // contiguous and get vectorized
+  fill(_histogramOld.begin(), _histogramOld.end(), (Real) 0.);
+  fill(_histogramNew.begin(), _histogramNew.end(), (Real) 0.);
+  for (int i=0; i<_histogramSize; i++) {
+    // previous frames
+    const Real* frameOld = &_history[((_oldest + i) % _bufferSize) * _numberFFTBins];
+    Real weightOld = _rweights[i];
     for (int b=0; b<_numberFFTBins; b++) {
-      // initialize bin
-      histogramOld[b] = 0;
-      histogramNew[b] = 0;
-      for (int i=0; i<_histogramSize; i++) {
-        // previous frames
-        histogramOld[b] += buffer[i][b] * _rweights[i];
-        // posterior frames
-        histogramNew[b] += buffer[_histogramSize + 1 + i][b] * _weights[i];
-      }
+      _histogramOld[b] += frameOld[b] * weightOld;
     }
-
-    // Reassign bins with zero magnitude in histogramOld to 1 to avoid division
-    // by zero (TODO why to 1?). Reassign bins with zero magnitude in
-    // histogramNew to a very little value to avoid log(0)
-    /*
-      original code by Matthew Davies:
-      ind = find(hist1 == 0);
-      hist1(ind) = 1;
-      if hist1 == 0,  hist1 = 1; end
-      if hist2 == 0,  hist2 = eps; end
-    */
-
-    Real detection = 0.;
-    for (int b=0; b<_numberFFTBins; b++)  {
-      if (histogramOld[b] == 0) {
-        histogramOld[b] = 1;
-      }
-      if (histogramNew[b] == 0) {
-        histogramNew[b] = numeric_limits<Real>::epsilon();
-      }
-      // Use information gain as a distance between histogrammed bins in
-      // previous and posterior frames. Consider only positive changes.
-      detection += max(log2(histogramNew[b] / histogramOld[b]), Real(0));
+    // posterior frames
+    const Real* frameNew = &_history[((_oldest + _histogramSize + 1 + i) % _bufferSize) * _numberFFTBins];
+    Real weightNew = _weights[i];
+    for (int b=0; b<_numberFFTBins; b++) {
+      _histogramNew[b] += frameNew[b] * weightNew;
     }
-    onsetDetections.push_back(detection);
   }
 
-  // original algorithm includes smoothing Hanning filter (length = 20 frames)
-  // df2 = filtfilt(hanning(20)/sum(hanning(20)),1,df)
-  // we omit smoothing, as it should be done on the post-processing stage
+  // Reassign bins with zero magnitude in histogramOld to 1 to avoid division
+  // by zero (TODO why to 1?). Reassign bins with zero magnitude in
+  // histogramNew to a very little value to avoid log(0)
+  /*
+    original code by Matthew Davies:
+    ind = find(hist1 == 0);
+    hist1(ind) = 1;
+    if hist1 == 0,  hist1 = 1; end
+    if hist2 == 0,  hist2 = eps; end
+  */
+
+  Real detection = 0.;
+  for (int b=0; b<_numberFFTBins; b++)  {
+    Real valueOld = _histogramOld[b] == 0 ? 1 : _histogramOld[b];
+    Real valueNew = _histogramNew[b] == 0 ? numeric_limits<Real>::epsilon() : _histogramNew[b];
+    // Use information gain as a distance between histogrammed bins in
+    // previous and posterior frames. Consider only positive changes, ie:
+    // the log is only needed when the ratio is larger than 1.
+    if (valueNew > valueOld) {
+      detection += log2(valueNew / valueOld);
+    }
+  }
+  onsetDetections.push_back(detection);
 }
 
 
-void OnsetDetectionGlobal::computeBeatEmphasis() {
-  vector<Real>& onsetDetections = _onsetDetections.get();
-  onsetDetections.clear();
-
-  vector<complex<Real> > frameFFT;
-  _fft->input("frame").set(_frameWindowed);
-  _fft->output("fft").set(frameFFT);
-
-  vector<Real> spectrum;
-  vector<Real> phase;
-  _cartesian2polar->input("complex").set(frameFFT);
-  _cartesian2polar->output("magnitude").set(spectrum);
-  _cartesian2polar->output("phase").set(phase);
-
-
-  fill(_phase_1.begin(), _phase_1.end(), Real(0.0));
-  fill(_phase_2.begin(), _phase_2.end(), Real(0.0));
-  fill(_spectrum_1.begin(), _spectrum_1.end(), Real(0.0));
-
-  vector<vector<Real> > onsetERB(_numberERBBands);
-  vector<Real> tempFFT (_numberFFTBins, 0.);  // detection function in FFT bins
-  vector<Real> tempERB (_numberERBBands, 0.); // detection function in ERP bands
-
-  // NB: a hack to make use of ERBBands algorithm and not reimplement the
-  // computation of gammatone filterbank weights again. As long as ERBBands
-  // computes weighted magnitudes in each ERB band instead of energy, we can
-  // feed it onset detection values instead of spectrum.
-  _erbbands->input("spectrum").set(tempFFT);
-  _erbbands->output("bands").set(tempERB);
-
-  size_t numberFrames=0;
-
-  while (true) {
-    // get a frame
-    _frameCutter->compute();
+void OnsetDetectionGlobal::processFrameBeatEmphasis(const vector<Real>& spectrum,
+                                                    const vector<Real>& phase) {
+  if ((int)spectrum.size() != _numberFFTBins || (int)phase.size() != _numberFFTBins) {
+    throw EssentiaException("OnsetDetectionGlobal: the spectrum and phase do not have the size expected for the configured frameSize");
+  }
 
-    if (!_frame.size()) {
-      break;
-    }
+  // Compute complex spectral difference. Optimized, see details in the
+  // OnsetDetection algo
+  for (int i=0; i<_numberFFTBins; ++i) {
+    Real targetPhase = 2*_phase_1[i] + _phase_2[i];
+    targetPhase = fmod(targetPhase + M_PI, -2 * M_PI) + M_PI;
+    _tempFFT[i] = norm(_spectrum_1[i] - polar(spectrum[i], phase[i]-targetPhase));
+  }
 
-    _windowing->compute();
-    _fft->compute();
-    _cartesian2polar->compute();
+  // Group detection functions for spectral bins into larger ERB sub-bands using
+  // a Gammatone filterbank to improve the likelihood of finding meaningful
+  // periodicity in spectral bands.
+  _erbbands->compute();
+  for (int b=0; b<_numberERBBands; ++b) {
+    _onsetERB[b].push_back(_tempERB[b]);
+  }
 
-    // Compute complex spectral difference. Optimized, see details in the
-    // OnsetDetection algo
-    for (int i=0; i<_numberFFTBins; ++i) {
-      Real targetPhase = 2*_phase_1[i] + _phase_2[i];
-      targetPhase = fmod(targetPhase + M_PI, -2 * M_PI) + M_PI;
-      tempFFT[i] = norm(_spectrum_1[i] - polar(spectrum[i], phase[i]-targetPhase));
-    }
+  _phase_2 = _phase_1;
+  _phase_1 = phase;
+  _spectrum_1 = spectrum;
+}
 
-    // Group detection functions for spectral bins into larger ERB sub-bands using
-    // a Gammatone filterbank to improve the likelihood of finding meaningful
-    // periodicity in spectral bands.
-    _erbbands->compute();
-    for (int b=0; b<_numberERBBands; ++b) {
-      onsetERB[b].push_back(tempERB[b]);
-    }
 
-    _phase_2 = _phase_1;
-    _phase_1 = phase;
-    _spectrum_1 = spectrum;
-    numberFrames += 1;
-  }
+void OnsetDetectionGlobal::computeBeatEmphasis(vector<Real>& onsetDetections) {
+  vector<vector<Real> >& onsetERB = _onsetERB;
+  size_t numberFrames = _numberFrames;
 
   // Post-processing found in M.Davies' matlab code, but not mentioned in the
   // paper, and skipped in this implementation:
@@ -371,39 +419,13 @@ void OnsetDetectionGlobal::computeBeatEmphasis() {
     // Consider only periods up to _maxPeriodODF ODF samples
     tempACF.resize(_maxPeriodODF);
 
-    // Weighten by tempo preference curve
-    vector<Real> tempACFWeighted;
-    tempACFWeighted.resize(_maxPeriodODF);
-
     // Apply comb-filtering to reflect periodicities on different metric levels
     // (integer multiples) and apply tempo preference curve.
-    int numberCombs = 4;
-
-    // To accout for poor resolution of ACF at short lags, each comb element has
-    // width proportional to its relationship to the underlying periodicity, and
-    // its height is normalized by its width.
-
-    // 0-th element in autocorrelation vector corresponds to the period of 1.
-    // Min value for the 'region' variable is -3 => compute starting from the
-    // 3-rd index, which corresponds to the period of 4, until period of 120
-    // ODF samples (as in matlab code) or 110 (as in the paper). Generalization:
-    // not clear why max period is 120 or 110, should be (512 - 3) / 4 = 127
-    int periodMin = 4 - 1;
-    int periodMax = (_maxPeriodODF-(numberCombs-1)) / numberCombs - 1;
-
-    for (int comb=1; comb<=numberCombs; ++comb) {
-      int width = 2*comb - 1;
-      for (int region=1-comb; region<=comb-1; ++region) {
-        for (int period=periodMin; period<periodMax; ++period) {
-          tempACFWeighted[period] +=
-              _weights[period] * tempACF[period*comb + region] / width;
-        }
-      }
-    }
+    _combFilterbank.compute(tempACF, _acfWeighted);
 
     // We are not interested in the period estimation, but in general salience of
     // the existing periodicity
-    weightsERB[b] = tempACFWeighted[argmax(tempACFWeighted)];
+    weightsERB[b] = _acfWeighted[argmax(_acfWeighted)];
   }
   normalize(weightsERB);
 
@@ -415,11 +437,12 @@ void OnsetDetectionGlobal::computeBeatEmphasis() {
   Real threshold = sorted[int(floor(_numberERBBands * 0.6))];
 
   // Compute weighted sub of ODFs for ERB bands for each audio frame
-  onsetDetections.resize(numberFrames);
+  size_t offset = onsetDetections.size();
+  onsetDetections.resize(offset + numberFrames);
   for (size_t i=0; i<numberFrames; ++i) {
     for (int b=0; b<_numberERBBands; ++b) {
       if (weightsERB[b] >= threshold) {
-        onsetDetections[i] += onsetERB[b][i] * weightsERB[b];
+        onsetDetections[offset + i] += onsetERB[b][i] * weightsERB[b];
       }
     }
   }
@@ -449,56 +472,136 @@ void OnsetDetectionGlobal::reset() {
 } // namespace essentia
 
 
-#include "poolstorage.h"
 #include "algorithmfactory.h"
 
 namespace essentia {
 namespace streaming {
 
 const char* OnsetDetectionGlobal::name = standard::OnsetDetectionGlobal::name;
+const char* OnsetDetectionGlobal::category = standard::OnsetDetectionGlobal::category;
 const char* OnsetDetectionGlobal::description = standard::OnsetDetectionGlobal::description;
 
-OnsetDetectionGlobal::OnsetDetectionGlobal() : AlgorithmComposite() {
+OnsetDetectionGlobal::OnsetDetectionGlobal() : Algorithm() {
 
-  _onsetDetectionGlobal = standard::AlgorithmFactory::create("OnsetDetectionGlobal");
-  _poolStorage = new PoolStorage<Real>(&_pool, "internal.signal");
+  _onsetDetectionGlobal = static_cast<standard::OnsetDetectionGlobal*>(
+      standard::AlgorithmFactory::create("OnsetDetectionGlobal"));
 
-  declareInput(_signal, 1, "signal", "the input signal");
+  declareInput(_signal, _preferredSize, "signal", "the input signal");
   declareOutput(_onsetDetections, 0, "onsetDetections", "the frame-wise values of the detection function");
-  // Need to set the buffer type to multiple frames as all the onsets
-  // are output all at once
-  //_onsetDetections.setBufferType(BufferUsage::forMultipleFrames); // too small
-  
-  // estimation for required buffer size: 1sec = 44100 samples ~ 87 frames
-  // we want to cover recordings up to 60 min = 3600secs = 310078 frames
-   _onsetDetections.setBufferInfo(BufferInfo(327680, 163840)); // too large?
-
-  _signal >> _poolStorage->input("data"); // attach input proxy
+
+  // detection values are all known at the end of the stream only, they are
+  // output in several chunks if they do not fit in the buffer at once
+  _onsetDetections.setBufferType(BufferUsage::forMultipleFrames);
 }
 
 OnsetDetectionGlobal::~OnsetDetectionGlobal() {
   delete _onsetDetectionGlobal;
-  delete _poolStorage;
+}
+
+void OnsetDetectionGlobal::configure() {
+  standard::Algorithm* onsetDetectionGlobal = _onsetDetectionGlobal;
+  onsetDetectionGlobal->configure(INHERIT("method"),
+                                  INHERIT("sampleRate"),
+                                  INHERIT("frameSize"),
+                                  INHERIT("hopSize"));
+  _frameSize = parameter("frameSize").toInt();
+  _hopSize = parameter("hopSize").toInt();
+  reset();
 }
 
 void OnsetDetectionGlobal::reset() {
-  AlgorithmComposite::reset();
+  Algorithm::reset();
   _onsetDetectionGlobal->reset();
+  _onsetDetectionGlobal->startFrames();
+
+  _buffer.clear();
+  _skip = 0;
+  _detections.clear();
+  _produced = 0;
+  _endOfSignal = false;
+
+  _signal.setAcquireSize(_preferredSize);
+  _signal.setReleaseSize(_preferredSize);
+  _onsetDetections.setAcquireSize(0);
+  _onsetDetections.setReleaseSize(0);
+}
+
+// Cuts all the frames which are complete in the samples acquired so far, in
+// the same way as FrameCutter does with startFromZero=true
+void OnsetDetectionGlobal::consume() {
+  const vector<Real>& signal = _signal.tokens();
+
+  int skipped = min(_skip, (int)signal.size());
+  _skip -= skipped;
+  _buffer.insert(_buffer.end(), signal.begin() + skipped, signal.end());
+
+  // a frame ending exactly at the end of the samples might be the last one
+  // of the stream, it is only cut once we know more samples are following
+  size_t start = 0;
+  while (start + _frameSize < _buffer.size()) {
+    _frame.assign(_buffer.begin() + start, _buffer.begin() + start + _frameSize);
+    _onsetDetectionGlobal->processFrame(_frame, _detections);
+    start += _hopSize;
+  }
+
+  if (start > _buffer.size()) {
+    _skip = start - _buffer.size();
+    start = _buffer.size();
+  }
+  _buffer.erase(_buffer.begin(), _buffer.begin() + start);
 }
 
 AlgorithmStatus OnsetDetectionGlobal::process() {
-  if (!shouldStop()) return PASS;
+  if (!_endOfSignal) {
+    AlgorithmStatus status = acquireData();
 
-  vector<Real> detections;
-  //const vector<Real>& signal = _pool.value<vector<Real> >("internal.signal");
+    if (status == OK) {
+      consume();
+      releaseData();
+      return OK;
+    }
 
-  _onsetDetectionGlobal->input("signal").set(_pool.value<vector<Real> >("internal.signal"));
-  _onsetDetectionGlobal->output("onsetDetections").set(detections);
-  _onsetDetectionGlobal->compute();
+    if (!shouldStop()) return status;
 
-  for (size_t i=0; i<detections.size(); ++i) {
-    _onsetDetections.push(detections[i]);
+    // end of the stream: consume the remaining samples and cut the last
+    // frame, zero-padded
+    int available = _signal.available();
+    if (available > 0) {
+      _signal.setAcquireSize(available);
+      _signal.setReleaseSize(available);
+      if (acquireData() != OK) {
+        throw EssentiaException("OnsetDetectionGlobal: could not acquire the last samples of the stream");
+      }
+      consume();
+      releaseData();
+    }
+    if (!_buffer.empty()) {
+      _frame.assign(_buffer.begin(), _buffer.end());
+      _frame.resize(_frameSize, 0);
+      _onsetDetectionGlobal->processFrame(_frame, _detections);
+      _buffer.clear();
+    }
+    _onsetDetectionGlobal->finishFrames(_detections);
+
+    _endOfSignal = true;
+    _signal.setAcquireSize(0);
+    _signal.setReleaseSize(0);
   }
+
+  // output as many detection values as the buffer can take, we get called
+  // again once they have been consumed
+  while (_produced < _detections.size()) {
+    int howmuch = min((int)(_detections.size() - _produced),
+                      _onsetDetections.bufferInfo().maxContiguousElements);
+    _onsetDetections.setAcquireSize(howmuch);
+    _onsetDetections.setReleaseSize(howmuch);
+    if (acquireData() != OK) return NO_OUTPUT;
+
+    fastcopy(&_onsetDetections.firstToken(), &_detections[_produced], howmuch);
+    releaseData();
+    _produced += howmuch;
+  }
+
   return FINISHED;
 }
 
@@ -20,7 +20,9 @@
 #ifndef ESSENTIA_ONSETDETECTIONGLOBAL_H
 #define ESSENTIA_ONSETDETECTIONGLOBAL_H
 
+#include <complex>
 #include "algorithmfactory.h"
+#include "combfilterbank.h"
 
 namespace essentia {
 namespace standard {
@@ -57,11 +59,32 @@ class OnsetDetectionGlobal : public Algorithm {
   int _numberERBBands;
   static const int _smoothingWindowHalfSize=8;
   int _maxPeriodODF;
+  CombFilterbank _combFilterbank;
+  std::vector<Real> _acfWeighted;
 
   std::vector<Real> _phase_1;
   std::vector<Real> _phase_2;
   std::vector<Real> _spectrum_1;
 
+  // state of the frame-wise computation
+  std::vector<Real> _spectrumFrame;
+  std::vector<Real> _phaseFrame;
+  std::vector<std::complex<Real> > _frameFFT;
+  std::vector<Real> _history;  // infogain: circular buffer of spectra
+  int _oldest;                 // infogain: index of the oldest spectrum
+  std::vector<Real> _histogramOld;
+  std::vector<Real> _histogramNew;
+  std::vector<Real> _tempFFT;
+  std::vector<Real> _tempERB;
+  std::vector<std::vector<Real> > _onsetERB;  // beat emphasis: per-band ODFs
+  size_t _numberFrames;
+
+  void processFrameInfoGain(const std::vector<Real>& spectrum,
+                            std::vector<Real>& onsetDetections);
+  void processFrameBeatEmphasis(const std::vector<Real>& spectrum,
+                                const std::vector<Real>& phase);
+  void computeBeatEmphasis(std::vector<Real>& onsetDetections);
+
 
  public:
   OnsetDetectionGlobal() {
@@ -100,8 +123,22 @@ class OnsetDetectionGlobal : public Algorithm {
   void configure();
   void compute();
 
-  void computeInfoGain();
-  void computeBeatEmphasis();
+  // Frame-wise computation, which does not need the whole signal at once:
+  // call startFrames(), then processFrame() with each frame of the signal,
+  // cut as with FrameCutter (startFromZero=true), and finally finishFrames().
+  // Detection values are appended to onsetDetections as soon as they are
+  // known, which for 'beat_emphasis' only happens in finishFrames().
+  void startFrames();
+  void processFrame(const std::vector<Real>& frame, std::vector<Real>& onsetDetections);
+  void finishFrames(std::vector<Real>& onsetDetections);
+
+  // Same as processFrame(), for a frame which has already been windowed
+  // (hann, normalized) and converted to magnitude and phase spectra, so that
+  // several detection functions can share the same spectral analysis. The
+  // phase is only used by 'beat_emphasis'.
+  void processSpectrum(const std::vector<Real>& spectrum,
+                       const std::vector<Real>& phase,
+                       std::vector<Real>& onsetDetections);
 
   static const char* name;
   static const char* category;
@@ -111,22 +148,37 @@ class OnsetDetectionGlobal : public Algorithm {
 } // namespace standard
 } // namespace essentia
 
-#include "streamingalgorithmcomposite.h"
-#include "pool.h"
+#include "streamingalgorithm.h"
 
 namespace essentia {
 namespace streaming {
 
-class OnsetDetectionGlobal : public AlgorithmComposite {
+/**
+ * The streaming version cuts the frames itself as the signal comes in and
+ * only keeps what the detection function needs from them, instead of storing
+ * the whole signal: the detection values for 'infogain', and the ERB band
+ * detection functions for 'beat_emphasis', whose weighting is computed over
+ * the entire signal. Detection values are output at the end of the stream.
+ */
+class OnsetDetectionGlobal : public Algorithm {
 
  protected:
-  SinkProxy<Real> _signal;
+  Sink<Real> _signal;
   Source<Real> _onsetDetections;
 
-  Pool _pool;
-  Algorithm* _poolStorage;
-  standard::Algorithm * _onsetDetectionGlobal;
+  standard::OnsetDetectionGlobal* _onsetDetectionGlobal;
+
+  static const int _preferredSize = 4096;
+  int _frameSize;
+  int _hopSize;
+  std::vector<Real> _buffer; // samples from the start of the next frame on
+  int _skip;                 // samples to skip before the next frame starts
+  std::vector<Real> _frame;
+  std::vector<Real> _detections;
+  size_t _produced;
+  bool _endOfSignal;
 
+  void consume();
 
  public:
   OnsetDetectionGlobal();
@@ -139,18 +191,7 @@ class OnsetDetectionGlobal : public AlgorithmComposite {
     declareParameter("hopSize", "the hop size for computing onset detection function", "(0,inf)", 512);
   }
 
-  void configure() {
-    _onsetDetectionGlobal->configure(INHERIT("method"),
-                                     INHERIT("sampleRate"),
-                                     INHERIT("frameSize"),
-                                     INHERIT("hopSize"));
-  }
-
-  void declareProcessOrder() {
-    declareProcessStep(SingleShot(_poolStorage));
-    declareProcessStep(SingleShot(this));
-  }
-
+  void configure();
   AlgorithmStatus process();
   void reset();
 
@@ -53,11 +53,9 @@ void OnsetRate::configure() {
   _fft->configure("size", _frameSize + _zeroPadding);
 
   // Onsets
-  _onsetHfc->configure("method", "hfc",
-                  "sampleRate", _sampleRate);
-
-  _onsetComplex->configure("method", "complex",
-                      "sampleRate", _sampleRate);
+  const char* methods[] = { "hfc", "complex" };
+  _onsetDetections->configure("methods", arrayToVector<string>(methods),
+                              "sampleRate", _sampleRate);
 
   _onsets->configure("frameRate", _frameRate);
 }
@@ -89,15 +87,10 @@ void OnsetRate::compute() {
   _cartesian2polar->output("magnitude").set(frameSpectrum);
   _cartesian2polar->output("phase").set(framePhase);
 
-  Real frameHFC;
-  _onsetHfc->input("spectrum").set(frameSpectrum);
-  _onsetHfc->input("phase").set(framePhase);
-  _onsetHfc->output("onsetDetection").set(frameHFC);
-
-  Real frameComplex;
-  _onsetComplex->input("spectrum").set(frameSpectrum);
-  _onsetComplex->input("phase").set(framePhase);
-  _onsetComplex->output("onsetDetection").set(frameComplex);
+  vector<Real> frameDetections;
+  _onsetDetections->input("spectrum").set(frameSpectrum);
+  _onsetDetections->input("phase").set(framePhase);
+  _onsetDetections->output("onsetDetections").set(frameDetections);
 
   vector<Real> hfc;
   vector<Real> complexdomain;
@@ -119,14 +112,11 @@ void OnsetRate::compute() {
     // calculate magnitude/phase
     _cartesian2polar->compute();
 
-    // calculate hfc onset
-    _onsetHfc->compute();
+    // calculate hfc and complex onsets
+    _onsetDetections->compute();
 
-    // calculate complex onset
-    _onsetComplex->compute();
-
-    hfc.push_back(frameHFC);
-    complexdomain.push_back(frameComplex);
+    hfc.push_back(frameDetections[0]);
+    complexdomain.push_back(frameDetections[1]);
   }
 
   // Time onsets
@@ -160,8 +150,7 @@ OnsetRate::~OnsetRate() {
     delete _cartesian2polar;
 
     // Onsets
-    delete _onsetHfc;
-    delete _onsetComplex;
+    delete _onsetDetections;
     delete _onsets;
 }
 
@@ -182,8 +171,7 @@ OnsetRate::OnsetRate() : AlgorithmComposite() {
   _windowing    = factory.create("Windowing");
   _fft          = factory.create("FFT");
   _cart2polar   = factory.create("CartesianToPolar");
-  _onsetHfc     = factory.create("OnsetDetection");
-  _onsetComplex = factory.create("OnsetDetection");
+  _onsetDetections = factory.create("MultiOnsetDetection");
 
   _onsets = standard::AlgorithmFactory::create("Onsets");
 
@@ -201,14 +189,11 @@ OnsetRate::OnsetRate() : AlgorithmComposite() {
   _windowing->output("frame")       >>  _fft->input("frame");
   _fft->output("fft")               >>  _cart2polar->input("complex");
 
-  _cart2polar->output("magnitude")  >>  _onsetHfc->input("spectrum");
-  _cart2polar->output("phase")      >>  _onsetHfc->input("phase");
-
-  _cart2polar->output("magnitude")  >>  _onsetComplex->input("spectrum");
-  _cart2polar->output("phase")      >>  _onsetComplex->input("phase");
+  _cart2polar->output("magnitude")  >>  _onsetDetections->input("spectrum");
+  _cart2polar->output("phase")      >>  _onsetDetections->input("phase");
 
-  _onsetHfc->output("onsetDetection")      >>  PC(_pool, "internal.hfc");
-  _onsetComplex->output("onsetDetection")  >>  PC(_pool, "internal.complexdomain");
+  // hfc and complex values of each frame
+  _onsetDetections->output("onsetDetections")  >>  PC(_pool, "internal.detections");
 
   _network = new scheduler::Network(_frameCutter);
 }
@@ -240,11 +225,9 @@ void OnsetRate::configure() {
   _fft->configure("size", _frameSize + _zeroPadding);
 
   // Onsets
-  _onsetHfc->configure("method", "hfc",
-                       "sampleRate", _sampleRate);
-
-  _onsetComplex->configure("method", "complex",
-                           "sampleRate", _sampleRate);
+  const char* methods[] = { "hfc", "complex" };
+  _onsetDetections->configure("methods", arrayToVector<string>(methods),
+                              "sampleRate", _sampleRate);
 
   _onsets->configure("frameRate", _frameRate);
 }
@@ -252,16 +235,15 @@ void OnsetRate::configure() {
 AlgorithmStatus OnsetRate::process() {
   if (!shouldStop()) return PASS;
 
-  const vector<Real>& hfc = _pool.value<vector<Real> >("internal.hfc");
-  const vector<Real>& complexdomain = _pool.value<vector<Real> >("internal.complexdomain");
+  const vector<vector<Real> >& frameDetections = _pool.value<vector<vector<Real> > >("internal.detections");
   // Time onsets
   TNT::Array2D<Real> detections;
   vector<Real> onsetTimes;
-  detections = TNT::Array2D<Real>(2, hfc.size());
+  detections = TNT::Array2D<Real>(2, frameDetections.size());
 
-  for (int j=0; j<int(hfc.size()); j++) {
-    detections[0][j] = hfc[j];
-    detections[1][j] = complexdomain[j];
+  for (int j=0; j<int(frameDetections.size()); j++) {
+    detections[0][j] = frameDetections[j][0];
+    detections[1][j] = frameDetections[j][1];
   }
 
   vector<Real> weights(2);
@@ -277,7 +259,7 @@ AlgorithmStatus OnsetRate::process() {
   // the size of the signal is taken as the size of the dectection function
   // multiplied by the hopsize. This is not 100% accurate but it approximates
   // ok
-  _onsetRate.push(Real(onsetTimes.size()) / Real(hfc.size()*_hopSize / _sampleRate));
+  _onsetRate.push(Real(onsetTimes.size()) / Real(frameDetections.size()*_hopSize / _sampleRate));
 
   return FINISHED;
 }
@@ -48,8 +48,7 @@ class OnsetRate : public Algorithm {
   Algorithm* _cartesian2polar;
 
   // Onsets
-  Algorithm* _onsetHfc;
-  Algorithm* _onsetComplex;
+  Algorithm* _onsetDetections;
   Algorithm* _onsets;
 
 public:
@@ -67,8 +66,7 @@ public:
     _cartesian2polar = AlgorithmFactory::create("CartesianToPolar");
 
     // Onsets
-    _onsetHfc = AlgorithmFactory::create("OnsetDetection");
-    _onsetComplex = AlgorithmFactory::create("OnsetDetection");
+    _onsetDetections = AlgorithmFactory::create("MultiOnsetDetection");
     _onsets = AlgorithmFactory::create("Onsets");
   }
 
@@ -82,7 +80,7 @@ public:
   void reset() {
     _frameCutter->reset();
     _onsets->reset();
-    _onsetComplex->reset();
+    _onsetDetections->reset();
   }
 
   static const char* name;
@@ -113,8 +111,7 @@ class OnsetRate : public AlgorithmComposite {
   Algorithm* _windowing;
   Algorithm* _fft;
   Algorithm* _cart2polar;
-  Algorithm* _onsetHfc;
-  Algorithm* _onsetComplex;
+  Algorithm* _onsetDetections;
   standard::Algorithm* _onsets;
 
   scheduler::Network* _network;
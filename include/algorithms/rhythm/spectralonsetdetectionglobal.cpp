@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#include "spectralonsetdetectionglobal.h"
+#include "algorithmfactory.h"
+
+using namespace std;
+
+namespace essentia {
+namespace streaming {
+
+const char* SpectralOnsetDetectionGlobal::name = "SpectralOnsetDetectionGlobal";
+const char* SpectralOnsetDetectionGlobal::category = "Rhythm";
+const char* SpectralOnsetDetectionGlobal::description = DOC("This algorithm computes the same onset detection functions as OnsetDetectionGlobal, from the magnitude and phase spectra of the frames instead of from the signal. The frames should be cut with startFromZero=true and windowed with a normalized hann window, as OnsetDetectionGlobal does, and the frameSize and hopSize parameters should be those used to cut them. This allows several detection functions to share the same spectral analysis of the signal.\n"
+"Detection values are output at the end of the stream, as the 'beat_emphasis' method needs the entire signal to compute them.\n"
+"\n"
+"Please refer to OnsetDetectionGlobal for the description of the methods.");
+
+SpectralOnsetDetectionGlobal::SpectralOnsetDetectionGlobal() : Algorithm() {
+
+  _onsetDetectionGlobal = static_cast<standard::OnsetDetectionGlobal*>(
+      standard::AlgorithmFactory::create("OnsetDetectionGlobal"));
+
+  declareInput(_spectrum, 1, "spectrum", "the magnitude spectrum of the windowed frame");
+  declareInput(_phase, 1, "phase", "the phase spectrum of the windowed frame");
+  declareOutput(_onsetDetections, 0, "onsetDetections", "the frame-wise values of the detection function");
+
+  // detection values are all known at the end of the stream only, they are
+  // output in several chunks if they do not fit in the buffer at once
+  _onsetDetections.setBufferType(BufferUsage::forMultipleFrames);
+}
+
+SpectralOnsetDetectionGlobal::~SpectralOnsetDetectionGlobal() {
+  delete _onsetDetectionGlobal;
+}
+
+void SpectralOnsetDetectionGlobal::configure() {
+  standard::Algorithm* onsetDetectionGlobal = _onsetDetectionGlobal;
+  onsetDetectionGlobal->configure(INHERIT("method"),
+                                  INHERIT("sampleRate"),
+                                  INHERIT("frameSize"),
+                                  INHERIT("hopSize"));
+  reset();
+}
+
+void SpectralOnsetDetectionGlobal::reset() {
+  Algorithm::reset();
+  _onsetDetectionGlobal->reset();
+  _onsetDetectionGlobal->startFrames();
+
+  _detections.clear();
+  _produced = 0;
+  _endOfStream = false;
+
+  _spectrum.setAcquireSize(1);
+  _spectrum.setReleaseSize(1);
+  _phase.setAcquireSize(1);
+  _phase.setReleaseSize(1);
+  _onsetDetections.setAcquireSize(0);
+  _onsetDetections.setReleaseSize(0);
+}
+
+AlgorithmStatus SpectralOnsetDetectionGlobal::process() {
+  if (!_endOfStream) {
+    AlgorithmStatus status = acquireData();
+
+    if (status == OK) {
+      _onsetDetectionGlobal->processSpectrum(_spectrum.firstToken(),
+                                             _phase.firstToken(),
+                                             _detections);
+      releaseData();
+      return OK;
+    }
+
+    if (!shouldStop()) return status;
+
+    // end of the stream: all the frames have been processed
+    _onsetDetectionGlobal->finishFrames(_detections);
+
+    _endOfStream = true;
+    _spectrum.setAcquireSize(0);
+    _spectrum.setReleaseSize(0);
+    _phase.setAcquireSize(0);
+    _phase.setReleaseSize(0);
+  }
+
+  // output as many detection values as the buffer can take, we get called
+  // again once they have been consumed
+  while (_produced < _detections.size()) {
+    int howmuch = min((int)(_detections.size() - _produced),
+                      _onsetDetections.bufferInfo().maxContiguousElements);
+    _onsetDetections.setAcquireSize(howmuch);
+    _onsetDetections.setReleaseSize(howmuch);
+    if (acquireData() != OK) return NO_OUTPUT;
+
+    fastcopy(&_onsetDetections.firstToken(), &_detections[_produced], howmuch);
+    releaseData();
+    _produced += howmuch;
+  }
+
+  return FINISHED;
+}
+
+} // namespace streaming
+} // namespace essentia
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_SPECTRALONSETDETECTIONGLOBAL_H
+#define ESSENTIA_SPECTRALONSETDETECTIONGLOBAL_H
+
+#include "streamingalgorithm.h"
+#include "onsetdetectionglobal.h"
+
+namespace essentia {
+namespace streaming {
+
+/**
+ * Same as the streaming OnsetDetectionGlobal, but taking the magnitude and
+ * phase spectra of the frames instead of the signal, so that several
+ * detection functions using the same frame and hop sizes can share a single
+ * FrameCutter -> Windowing -> FFT -> CartesianToPolar chain.
+ */
+class SpectralOnsetDetectionGlobal : public Algorithm {
+
+ protected:
+  Sink<std::vector<Real> > _spectrum;
+  Sink<std::vector<Real> > _phase;
+  Source<Real> _onsetDetections;
+
+  standard::OnsetDetectionGlobal* _onsetDetectionGlobal;
+
+  std::vector<Real> _detections;
+  size_t _produced;
+  bool _endOfStream;
+
+ public:
+  SpectralOnsetDetectionGlobal();
+  ~SpectralOnsetDetectionGlobal();
+
+  void declareParameters() {
+    declareParameter("method", "the method used for onset detection", "{infogain,beat_emphasis}", "infogain");
+    declareParameter("sampleRate", "the sampling rate of the audio signal [Hz]", "(0,inf)", 44100.0);
+    declareParameter("frameSize", "the frame size used to compute the input spectra", "(0,inf)", 2048);
+    declareParameter("hopSize", "the hop size used to compute the input spectra", "(0,inf)", 512);
+  }
+
+  void configure();
+  AlgorithmStatus process();
+  void reset();
+
+  static const char* name;
+  static const char* category;
+  static const char* description;
+};
+
+} // namespace streaming
+} // namespace essentia
+
+#endif // ESSENTIA_SPECTRALONSETDETECTIONGLOBAL_H
@@ -18,8 +18,10 @@
  */
 
 #include "tempotapdegara.h"
+#include "combfilterbank.h"
 #include "essentiamath.h"
 #include <limits>
+#include <map>
 
 using namespace std;
 
@@ -39,6 +41,118 @@ const char* TempoTapDegara::description = DOC("This algorithm estimates beat pos
 "  [3] Stark, A. M., Davies, M. E., & Plumbley, M. D. (2009, September). Real-time beatsynchronous analysis of musical audio. In 12th International Conference on Digital Audio Effects (DAFx-09), Como, Italy.");
 
 
+// Tables which only depend on the configuration of TempoTapDegara. They are
+// immutable once created, and shared by all the instances configured in the
+// same way (eg: the five TempoTapDegara of a BeatTrackerMultiFeature, in all
+// the threads of a batch analysis), so that configure() and compute() do not
+// need to build them again. The cache keeps one set of tables per
+// configuration for the whole process (about 150 KB with the default
+// settings, 1.2 MB with x3 resampling).
+class TempoTapDegara::Tables {
+ public:
+  struct Key {
+    Real sampleRateODF;  // before resampling
+    int resample;
+    Real frameDurationODF;
+    Real sigmaIBI;
+    Real alpha;
+
+    bool operator<(const Key& other) const {
+      if (sampleRateODF != other.sampleRateODF) return sampleRateODF < other.sampleRateODF;
+      if (resample != other.resample) return resample < other.resample;
+      if (frameDurationODF != other.frameDurationODF) return frameDurationODF < other.frameDurationODF;
+      if (sigmaIBI != other.sigmaIBI) return sigmaIBI < other.sigmaIBI;
+      return alpha < other.alpha;
+    }
+  };
+
+  static shared_ptr<const Tables> get(const Key& key);
+
+  explicit Tables(const Key& key);
+
+  // number of HMM states needed for beat periods up to periodMax [s]
+  static int numberStates(Real periodMax, Real sigmaIBI, Real resolutionODF);
+
+  Real sampleRateODF;
+  int frameSizeODF;
+  int hopSizeODF;
+
+  // tempo preference curve, indexed by beat period (0-th index corresponds to
+  // a period of 1 ODF sample)
+  vector<Real> tempoWeights;
+  CombFilterbank combFilterbank;
+
+  // transition matrix for Viterbi, of which only the non-zero band
+  // [viterbiBegin[i], viterbiEnd[i]) of each line i is stored, starting at
+  // viterbiOffset[i]
+  vector<Real> viterbiTransitions;
+  vector<int> viterbiOffset;
+  vector<int> viterbiBegin;
+  vector<int> viterbiEnd;
+
+  // HMM transition log-probabilities for each beat period index, for the
+  // states needed by the longest period. From a state, the only possible
+  // transitions are to the beat state (state 0) and to the next state, so the
+  // matrix of each period is stored as two lines of numberStatesMax values
+  int numberStatesMax;
+  vector<Real> beatTransitions;  // [period*numberStatesMax + state] -> 0
+  vector<Real> nextTransitions;  // [period*numberStatesMax + state] -> state+1
+  // the transitions to the beat state are only possible from the states in
+  // [beatTransitionsBegin[period], beatTransitionsEnd[period])
+  vector<int> beatTransitionsBegin;
+  vector<int> beatTransitionsEnd;
+
+ private:
+  void createTempoPreferenceCurve();
+  void createViterbiTransitionMatrix();
+  void createHMMTransitionMatrices(const Key& key);
+};
+
+
+shared_ptr<const TempoTapDegara::Tables> TempoTapDegara::Tables::get(const Key& key) {
+  static ForcedMutex tablesMutex;
+  static map<Key, shared_ptr<const Tables> > sharedTables;
+
+  ForcedMutexLocker lock(tablesMutex);
+  shared_ptr<const Tables>& tables = sharedTables[key];
+  if (!tables) {
+    tables = make_shared<const Tables>(key);
+  }
+  return tables;
+}
+
+TempoTapDegara::Tables::Tables(const Key& key) {
+  sampleRateODF = key.sampleRateODF * key.resample;
+
+  // ------- M. Davies --------
+  // Use hopsize of 1.5 secs, frame size of 6 secs to cut ODF frames. We want
+  // to estimate some period for each frame, therefore, the maximum period we
+  // can find is limited to the hopsize and corresponds to 40 BPM. Having a
+  // frame size 4 times larger, we can take into account the periodicities on
+  // integer multiples, using for this purpose up to 4 comb filters in the bank.
+  frameSizeODF = int(round(key.frameDurationODF * sampleRateODF));
+  hopSizeODF = frameSizeODF / _numberCombs;
+
+  createTempoPreferenceCurve();
+
+  // 0-th element in autocorrelation vector will corresponds to the period of 1.
+  // Min value for the 'region' variable is -3 => we will compute starting from i
+  // the 3-rd index, which corresponds to the period of 4, until period of 127 =
+  // (512-3) / 4 = 127 ODF samples (or until 120 as in matlab code).
+  int periodMinIndex = _numberCombs - 1;
+  int periodMaxIndex =  (frameSizeODF-(_numberCombs-1)) / _numberCombs - 1;
+
+  // period index i corresponds to the ACF lag of (i+1)*comb-1
+  combFilterbank.configure(tempoWeights, periodMinIndex, periodMaxIndex,
+                           _numberCombs, 1, hopSizeODF);
+
+  createViterbiTransitionMatrix();
+
+  // ------- N. Degara --------
+  createHMMTransitionMatrices(key);
+}
+
+
 
 void TempoTapDegara::configure() {
   _frameDurationODF = 5.944308390022676;
@@ -61,36 +175,24 @@ void TempoTapDegara::configure() {
   else if (parameter("resample") == "x2") _resample = 2;
   else if (parameter("resample") == "x3") _resample = 3;
   else if (parameter("resample") == "x4") _resample = 4;
-  _sampleRateODF = parameter("sampleRateODF").toReal() * _resample;
 
-  // ------- M. Davies --------
-  // Use hopsize of 1.5 secs, frame size of 6 secs to cut ODF frames. We want
-  // to estimate some period for each frame, therefore, the maximum period we
-  // can find is limited to the hopsize and corresponds to 40 BPM. Having a
-  // frame size 4 times larger, we can take into account the periodicities on
-  // integer multiples, using for this purpose up to 4 comb filters in the bank.
+  Tables::Key key = { (Real) parameter("sampleRateODF").toReal(), _resample,
+                      _frameDurationODF, _sigma_ibi, _alpha };
+  _tables = Tables::get(key);
+  _sampleRateODF = _tables->sampleRateODF;
+  _hopSizeODF = _tables->hopSizeODF;
   _hopDurationODF = _frameDurationODF / _numberCombs;
-  int frameSizeODF = int(round(_frameDurationODF * _sampleRateODF));
-  _hopSizeODF = frameSizeODF / _numberCombs;
 
-  _frameCutter->configure("frameSize", frameSizeODF,
+  _frameCutter->configure("frameSize", _tables->frameSizeODF,
                           "hopSize", _hopSizeODF,
                           "startFromZero", true);
 
   // Smoothing window size of 0.2s: 0.1s advance + 0.1s delay
   _smoothingWindowHalfSize = floor(0.1 * _sampleRateODF);
   _movingAverage->configure("size", _smoothingWindowHalfSize * 2 + 1);
+  _movingAverage->reset();
   _autocorrelation->configure("normalization", "unbiased");
 
-  createTempoPreferenceCurve();
-
-  // 0-th element in autocorrelation vector will corresponds to the period of 1.
-  // Min value for the 'region' variable is -3 => we will compute starting from i
-  // the 3-rd index, which corresponds to the period of 4, until period of 127 =
-  // (512-3) / 4 = 127 ODF samples (or until 120 as in matlab code).
-  _periodMinIndex = _numberCombs - 1;
-  _periodMaxIndex =  (frameSizeODF-(_numberCombs-1)) / _numberCombs - 1;
-
   // user-defined min/max periods
   _periodMaxUserIndex = (int)ceil(60. / minTempo * _sampleRateODF) - 1;
   _periodMinUserIndex = (int)floor(60. / maxTempo * _sampleRateODF) - 1;
@@ -103,8 +205,6 @@ void TempoTapDegara::configure() {
   // instead of using 6 secs:
   //frameSizeODF = pow(2, ceil(log2(_numberCombs * _periodMaxIndexInSamples * _sampleRateODF)));
 
-  createViterbiTransitionMatrix();
-
   // ------- N. Degara --------
   _resolutionODF = 1. / _sampleRateODF;
 }
@@ -178,45 +278,19 @@ void TempoTapDegara::computeBeatsDegara(vector <Real>& detections,
   // Minimum tempo (i.e., maximum period) to be considered
   Real periodMax = beatPeriods[argmax(beatPeriods)];
   // The number of states of the HMM is determined bt the largest time between
-  // beats allowed (periodMax + 3 standard deviations). Compute a list of
-  // inter-beat time intervals corresponding to each state (ignore zero period):
-  vector<Real> ibi;
-  Real ibiMax = periodMax + 3 *_sigma_ibi;
-
-  ibi.reserve(ceil(ibiMax / _resolutionODF));
-  for (Real t=_resolutionODF; t<=ibiMax; t+=_resolutionODF) {
-    ibi.push_back(t);
-  }
-  _numberStates = (int) ibi.size();
-
-  // Compute transition matrix from the inter-beat-interval distribution
-  // according to the tempo estimates. Transition matrix is unique for each beat
-  // period.
-  map<Real, vector<vector<Real> > > transitionMatrix;
-  vector<Real> gaussian;
-  vector<Real> ibiPDF(_numberStates);
-
-  gaussianPDF(gaussian, _sigma_ibi, _resolutionODF, 0.01 / _resample);
-  // Scale down to avoid computational errors,
-  // * _resolutionODF, as in matlab code, works worse
+  // beats allowed (periodMax + 3 standard deviations).
+  _numberStates = Tables::numberStates(periodMax, _sigma_ibi, _resolutionODF);
 
+  // The transition matrix computed from the inter-beat-interval distribution
+  // is unique for each beat period, and is precomputed for all the periods in
+  // the tables: find the period index of each tempo estimate
+  vector<int> beatPeriodIndices(beatPeriods.size());
   for (size_t i=0; i<beatPeriods.size(); ++i) {
-    // no need to recompute if we have seen this beat period before
-    if (transitionMatrix.count(beatPeriods[i])==0) {
-      // Shift gaussian vector to be centered at beatPeriods[i] secs which is
-      // equivalent to round(beatPeriods[i] / _resolutionODF) samples.
-      int shift = (int) gaussian.size()/2 - round(beatPeriods[i]/_resolutionODF - 1);
-      for (int j=0; j<_numberStates; ++j) {
-        int j_new = j + shift;
-        ibiPDF[j] = j_new < 0 || j_new >= (int) gaussian.size() ? 0 : gaussian[j_new];
-      }
-      computeHMMTransitionMatrix(ibiPDF, transitionMatrix[beatPeriods[i]]);
-    }
+    beatPeriodIndices[i] = (int) round(beatPeriods[i] * _sampleRateODF) - 1;
   }
 
-  // Compute observation likelihoods for each HMM state
-  vector<vector<Real> > biy;   // _numberStates x _numberFramesODF
-  biy.reserve(_numberStates);
+  // Compute observation likelihoods for each HMM state: the beat state
+  // (state 0) and all the other states, which share the same likelihood
 
   // treat ODF as probability, normalize to 0.99 to avoid numerical problems
   _numberFrames = detections.size();
@@ -230,12 +304,10 @@ void TempoTapDegara::computeBeatsDegara(vector <Real>& detections,
     noBeatProbability[i] = (1-_alpha) * log(noBeatProbability[i]);
   }
 
-  biy.push_back(beatProbability);
-  biy.insert(biy.end(), _numberStates-1, noBeatProbability);
-
   // Decoding
   vector<int> stateSequence;
-  decodeBeats(transitionMatrix, beatPeriods, beatEndPositions, biy, stateSequence);
+  decodeBeats(beatPeriodIndices, beatEndPositions,
+              beatProbability, noBeatProbability, stateSequence);
   for (size_t i=0; i<stateSequence.size(); ++i) {
     if (stateSequence[i] == 0) { // beat detected
       ticks.push_back(i * _resolutionODF);
@@ -243,52 +315,60 @@ void TempoTapDegara::computeBeatsDegara(vector <Real>& detections,
   }
 }
 
-void TempoTapDegara::decodeBeats(map<Real,
-                                 vector<vector<Real> > >& transitionMatrix,
-                                 const vector<Real>& beatPeriods,
+void TempoTapDegara::decodeBeats(const vector<int>& beatPeriodIndices,
                                  const vector<Real>& beatEndPositions,
-                                 const vector<vector<Real> >& biy,
+                                 const vector<Real>& beatProbability,
+                                 const vector<Real>& noBeatProbability,
                                  vector<int>& sequenceStates) {
   // Transition probability matrix at the begining of the track
   size_t currentIndex = 0;
 
-  // Best transition information for backtracking
-  vector<vector<int> > stateBacktracking(_numberStates, vector<int>(_numberFrames));
+  // Best transition information for backtracking. Only the transitions to
+  // state 0 need to be stored, any other state can only be reached from the
+  // previous one
+  vector<int> beatBacktracking(_numberFrames);
 
-  // HMM cost for each state for the current time
+  // HMM cost for each state at the previous time, and at the current time
   vector<Real> cost(_numberStates, numeric_limits<Real>::max());
   cost[0] = 0;
-  vector<Real> costOld = cost;
-  vector<Real> diff(_numberStates);
+  vector<Real> costNew(_numberStates);
 
   // Dynamic programming
   for (size_t t=0; t<_numberFrames; ++t) {
-    // Evaluate transitions from any state to state event (state 0)
-
-    // Look for the minimum cost
-    for (int i=0; i<_numberStates; ++i) {
-      diff[i] = costOld[i] - transitionMatrix[beatPeriods[currentIndex]][i][0];
+    int period = beatPeriodIndices[currentIndex];
+    const Real* beatTransitions = &_tables->beatTransitions[period * _tables->numberStatesMax];
+    const Real* nextTransitions = &_tables->nextTransitions[period * _tables->numberStatesMax];
+
+    // Evaluate transitions from any state to state event (state 0), and look
+    // for the minimum cost. These transitions are impossible (-inf) outside
+    // of a narrow band of states around the beat period, the cost of going
+    // through them is +inf: only the band needs to be searched, and if there
+    // is no finite cost in it, the first state is the best one as for a
+    // search over all the states.
+    int bestState = 0;
+    Real bestPath = numeric_limits<Real>::infinity();
+    int end = min(_tables->beatTransitionsEnd[period], _numberStates);
+    for (int i=_tables->beatTransitionsBegin[period]; i<end; ++i) {
+      Real diff = cost[i] - beatTransitions[i];
+      if (diff < bestPath) {
+        bestPath = diff;
+        bestState = i;
+      }
     }
-    int bestState = argmin(diff);
-    Real bestPath = diff[bestState];
 
     if (bestPath==numeric_limits<Real>::max()) {
       bestState = -1;
     }
 
     // Save best transtions information for backtracking
-    stateBacktracking[0][t] = bestState;
+    beatBacktracking[t] = bestState;
     // Update cost; the only possible transition is from state to state+1
-    cost[0] = - biy[0][t] + bestPath;
+    costNew[0] = - beatProbability[t] + bestPath;
+    Real noBeat = noBeatProbability[t];
     for (int state=1; state<_numberStates; ++state) {
-      cost[state] = costOld[state-1]
-                    - transitionMatrix[beatPeriods[currentIndex]][state-1][state]
-                    - biy[state][t];
-      stateBacktracking[state][t] = state-1;
+      costNew[state] = cost[state-1] - nextTransitions[state-1] - noBeat;
     }
-
-    // Update cost at t-1
-    costOld = cost;
+    cost.swap(costNew);
 
     // Find the transition matrix corresponding to next frame
     if (t+1 < _numberFrames) {
@@ -308,7 +388,8 @@ void TempoTapDegara::decodeBeats(map<Real,
   sequenceStates.back() = finalState;
   if (_numberFrames >= 2) {
     for (size_t t=_numberFrames-2; ; --t) {
-      sequenceStates[t] = stateBacktracking[sequenceStates[t+1]][t+1];
+      int state = sequenceStates[t+1];
+      sequenceStates[t] = state == 0 ? beatBacktracking[t+1] : state-1;
       if (t==0) {
         break;
       }
@@ -316,58 +397,99 @@ void TempoTapDegara::decodeBeats(map<Real,
   }
 }
 
-void TempoTapDegara::computeHMMTransitionMatrix(const vector<Real>& ibiPDF,
-                                vector<vector<Real> >& transitions) {
-
-  // Fill in with zeros
-  transitions.clear();
-  transitions.resize(_numberStates);
-  for (int i=0; i<_numberStates; ++i) {
-    transitions[i].resize(_numberStates);
+int TempoTapDegara::Tables::numberStates(Real periodMax, Real sigmaIBI, Real resolutionODF) {
+  // inter-beat time intervals corresponding to each state (ignore zero period)
+  Real ibiMax = periodMax + 3 * sigmaIBI;
+  int states = 0;
+  for (Real t=resolutionODF; t<=ibiMax; t+=resolutionODF) {
+    states++;
   }
+  return states;
+}
+
+
+void TempoTapDegara::Tables::createHMMTransitionMatrices(const Key& key) {
+  // Estimated beat periods go up to hopSizeODF ODF samples
+  Real resolutionODF = 1. / sampleRateODF;
+  Real periodMax = (Real) hopSizeODF / sampleRateODF;
+  numberStatesMax = numberStates(periodMax, key.sigmaIBI, resolutionODF);
 
-  // Estimate transition probabilities
-  transitions[0][0] = ibiPDF[0];
-  transitions[0][1] = 1 - transitions[0][0];
-  for (int i=1; i<_numberStates; ++i) {
-    vector<Real> temp(i, 0.);
-    for (int k=0; k<i; ++k) {
-      temp[k] = log(transitions[k][k+1]);
+  beatTransitions.assign(hopSizeODF * numberStatesMax, (Real) 0.);
+  nextTransitions.assign(hopSizeODF * numberStatesMax, (Real) 0.);
+  beatTransitionsBegin.assign(hopSizeODF, 0);
+  beatTransitionsEnd.assign(hopSizeODF, 0);
+
+  vector<Real> gaussian;
+  vector<Real> ibiPDF(numberStatesMax);
+
+  gaussianPDF(gaussian, key.sigmaIBI, resolutionODF, 0.01 / key.resample);
+  // Scale down to avoid computational errors,
+  // * resolutionODF, as in matlab code, works worse
+
+  for (int period=0; period<hopSizeODF; ++period) {
+    // Shift gaussian vector to be centered at the beat period in secs, which
+    // is equivalent to round(beatPeriod / resolutionODF) samples.
+    Real beatPeriod = ((Real) period + 1) / sampleRateODF;
+    int shift = (int) gaussian.size()/2 - round(beatPeriod/resolutionODF - 1);
+    for (int j=0; j<numberStatesMax; ++j) {
+      int j_new = j + shift;
+      ibiPDF[j] = j_new < 0 || j_new >= (int) gaussian.size() ? 0 : gaussian[j_new];
     }
-    transitions[i][0] = exp(log(ibiPDF[i]) - sum(temp));
-
-    // Matlab: check for numerical problems (probabilities should be within [0,1])
-    if (transitions[i][0] < 0 || transitions[i][0] > 1) {
-      E_WARNING("Numerical problems in TempoTapDegara::computeHMMTransitionMatrix");
-      // TODO should be Essentia exception instead?
-      // truncate to 1 to avoid further NaNs in log computation
-      if (transitions[i][0] < 0) {
-        transitions[i][0] = 0;
+
+    // Estimate transition probabilities. The transitions from a state only
+    // depend on the previous states, so a matrix computed for more states is
+    // also valid for a smaller number of states. The log of the transition
+    // probabilities to the next states is accumulated on the way.
+    Real* toBeat = &beatTransitions[period * numberStatesMax];
+    Real* toNext = &nextTransitions[period * numberStatesMax];
+    toBeat[0] = ibiPDF[0];
+    toNext[0] = 1 - toBeat[0];
+    Real logNext = 0;
+    for (int i=1; i<numberStatesMax; ++i) {
+      logNext += log(toNext[i-1]);
+      toBeat[i] = exp(log(ibiPDF[i]) - logNext);
+
+      // Matlab: check for numerical problems (probabilities should be within [0,1])
+      if (toBeat[i] < 0 || toBeat[i] > 1) {
+        E_WARNING("Numerical problems in TempoTapDegara transition matrix");
+        // TODO should be Essentia exception instead?
+        // truncate to 1 to avoid further NaNs in log computation
+        if (toBeat[i] < 0) {
+          toBeat[i] = 0;
+        }
+        else {
+          toBeat[i] = 1;
+        }
       }
-      else {
-        transitions[i][0] = 1;
+      if (i+1 < numberStatesMax) {
+        toNext[i] = 1 - toBeat[i];
       }
     }
-    if (i+1 < _numberStates) {
-      transitions[i][i+1] = 1 - transitions[i][0];
-    }
-  }
 
-  // NB: work in log space to avoid numerical issues
-  for (int i=0; i<_numberStates; ++i) {
-    for (int j=0; j<_numberStates; ++j) {
-      transitions[i][j] = log(transitions[i][j]) * _alpha;
+    // NB: work in log space to avoid numerical issues
+    for (int i=0; i<numberStatesMax; ++i) {
+      toBeat[i] = log(toBeat[i]) * key.alpha;
+      toNext[i] = log(toNext[i]) * key.alpha;
     }
+
+    const Real impossible = -numeric_limits<Real>::infinity();
+    int begin = 0;
+    int end = numberStatesMax;
+    while (begin < end && toBeat[begin] == impossible) ++begin;
+    while (end > begin && toBeat[end-1] == impossible) --end;
+    beatTransitionsBegin[period] = begin;
+    beatTransitionsEnd[period] = end;
   }
 }
 
 
-void TempoTapDegara::computeBeatPeriodsDavies(vector<Real> detections,
+void TempoTapDegara::computeBeatPeriodsDavies(const vector<Real>& detections,
                               vector<Real>& beatPeriods,
                               vector<Real>& beatEndPositions) {
   // Implementation of the beat period detection algorithm by M. Davies.
 
-  adaptiveThreshold(detections, _smoothingWindowHalfSize);
+  _thresholdedDetections = detections;
+  adaptiveThreshold(_thresholdedDetections, _smoothingWindowHalfSize);
 
   // Tempo estimation:
   // - Split detection function into overlapping frames.
@@ -380,7 +502,7 @@ void TempoTapDegara::computeBeatPeriodsDavies(vector<Real> detections,
   vector<Real> frameACF;
   vector<Real> frameACFNormalized(_hopSizeODF);
 
-  _frameCutter->input("signal").set(detections);
+  _frameCutter->input("signal").set(_thresholdedDetections);
   _frameCutter->output("frame").set(frame);
   _autocorrelation->input("array").set(frame);
   _autocorrelation->output("autoCorrelation").set(frameACF);
@@ -395,16 +517,7 @@ void TempoTapDegara::computeBeatPeriodsDavies(vector<Real> detections,
     // To accout for poor resolution of ACF at short lags, each comb element has
     // width proportional to its relationship to the underlying periodicity, and
     // its height is normalized by its width.
-    fill(frameACFNormalized.begin(), frameACFNormalized.end(), (Real)0.0);
-    for (int comb=1; comb<=_numberCombs; ++comb) {
-      int width = 2*comb - 1;
-      for (int region=1-comb; region<=comb-1; ++region) {
-        for (int period=_periodMinIndex; period<=_periodMaxIndex; ++period) {
-          frameACFNormalized[period] +=
-              _tempoWeights[period] * frameACF[(period+1)*comb-1 + region] / width;
-        }
-      }
-    }
+    _tables->combFilterbank.compute(frameACF, frameACFNormalized);
     // Apply adaptive threshold. It is not mentioned in the paper, but is taken
     // from matlab code by M.Davies (including the smoothing size). The
     // implemented smoothing does not exactly match the one in matlab code,
@@ -427,17 +540,20 @@ void TempoTapDegara::computeBeatPeriodsDavies(vector<Real> detections,
   _frameCutter->reset();  // TODO reset here for consequent signal inputs, or should the user do it always?
 
   _numberFramesODF = observations.size();
-  // Add noise
+  // Add noise. Use a generator local to this computation with a fixed seed
+  // instead of the global rand(), so that the result is reproducible and does
+  // not depend on other instances running before or concurrently.
+  MTRand mtrand(_noiseSeed);
   for (size_t t=0; t<_numberFramesODF; ++t) {
     for (int i=0; i<_hopSizeODF; ++i) {
-      observations[t][i] += 0.0001 * observationsMax * (Real) rand() / RAND_MAX;
+      observations[t][i] += 0.0001 * observationsMax * (Real) mtrand.rand();
     }
   }
 
   // find Viterbi path (ODF-frame-wise list of indices of the estimated periods;
   // zero index corresponds to beat period of 1 ODF frame hopsize)
   vector <Real> path;
-  findViterbiPath(_tempoWeights, _transitionsViterbi, observations, path);
+  findViterbiPath(observations, path);
 
   beatPeriods.reserve(_numberFramesODF);
   beatEndPositions.reserve(_numberFramesODF);
@@ -449,10 +565,8 @@ void TempoTapDegara::computeBeatPeriodsDavies(vector<Real> detections,
 }
 
 
-void TempoTapDegara::findViterbiPath(const vector<Real>& prior,
-                     const vector<vector<Real> > transitionMatrix,
-                     const vector<vector <Real> >& observations,
-                     vector<Real>& path) {
+void TempoTapDegara::findViterbiPath(const vector<vector <Real> >& observations,
+                                     vector<Real>& path) const {
   // Find the most-probable (Viterbi) path through the HMM state trellis.
 
   // Inputs:
@@ -466,62 +580,84 @@ void TempoTapDegara::findViterbiPath(const vector<Real>& prior,
   // delta(j,t) = prob. of the best sequence of length t-1 and then going to state j, and O(1:t)
   // psi(j,t) = the best predecessor state, given that we ended up in state j at t
 
-  int numberPeriods = prior.size();
+  // The transition matrix is a narrow band around its diagonal, so only the
+  // non-zero band of each line is visited. Probabilities are normalized at
+  // each frame, which prevents underflow without going to the log domain, and
+  // keeps the results identical to a full search over all the states: when
+  // the best predecessor has a null probability, a full search would return
+  // the first state, and so do we.
+  // Only the last frame of delta is needed, psi is stored as a flat matrix.
+
+  path.clear();
+  size_t numberFramesODF = observations.size();
+  if (numberFramesODF == 0) return;
 
-  vector<vector<Real> > delta; // = zeros(numberFramesODF,numberPeriods);
-  vector<vector<Real> > psi;   // = zeros(numberFramesODF,numberPeriods);
+  const vector<Real>& prior = _tables->tempoWeights;
+  int numberPeriods = prior.size();
 
-  vector<Real> deltaNew;
-  deltaNew.resize(numberPeriods);
+  vector<Real> delta(numberPeriods);
+  vector<Real> deltaNew(numberPeriods);
+  vector<int> psi(numberFramesODF * numberPeriods);
 
   // weighten likelihoods of periods in the first frame by the prior
   for (int i=0; i<numberPeriods; ++i) {
-    deltaNew[i] = prior[i] * observations[0][i];
+    delta[i] = prior[i] * observations[0][i];
   }
-  normalizeSum(deltaNew);
-  delta.push_back(deltaNew);
+  normalizeSum(delta);
+  // psi for the first frame is a vector of zeros (arbitrary, since there is no
+  // predecessor to the first frame)
 
-  vector<Real> psiNew;
-  // a vector of zeros (arbitrary, since there is no predecessor to the first frame)
-  psiNew.resize(numberPeriods);
-  psi.push_back(psiNew);
-
-  vector<Real> tmp;
-  tmp.resize(numberPeriods);
-
-  for (size_t t=1; t<_numberFramesODF; ++t) {
+  for (size_t t=1; t<numberFramesODF; ++t) {
+    int* psiNew = &psi[t*numberPeriods];
     for (int j=0; j<numberPeriods; ++j) {
-      for (int i=0; i<numberPeriods; ++i) {
-        // weighten delta for a previous frame by vector from the transitionMatrix
-        tmp[i] = delta.back()[i] * transitionMatrix[j][i];
+      // weighten delta for a previous frame by vector from the transitionMatrix
+      int begin = _tables->viterbiBegin[j];
+      const Real* transitions = &_tables->viterbiTransitions[_tables->viterbiOffset[j]];
+      int iMax = 0;
+      Real deltaMax = 0;
+      for (int i=begin; i<_tables->viterbiEnd[j]; ++i) {
+        Real value = delta[i] * transitions[i-begin];
+        if (value > deltaMax) {
+          deltaMax = value;
+          iMax = i;
+        }
       }
-      int iMax = argmax(tmp);
-      deltaNew[j] = tmp[iMax] * observations[t][j];
+      deltaNew[j] = deltaMax * observations[t][j];
       psiNew[j] = iMax;
     }
     normalizeSum(deltaNew);
-    delta.push_back(deltaNew);
-    psi.push_back(psiNew);
+    delta.swap(deltaNew);
   }
 
   // track the path backwards in time
-  path.resize(_numberFramesODF);
-  path.back() = argmax(delta.back());
-  if (_numberFramesODF >= 2) {
-    for (size_t t=_numberFramesODF-2;; --t) {
-      path[t] = psi[t+1][path[t+1]];
-      if (t==0) { // size_t can't be negative, break on zero
-        break;
-      }
+  path.resize(numberFramesODF);
+  path.back() = argmax(delta);
+  for (size_t t=numberFramesODF-1; t>0; --t) {
+    path[t-1] = psi[t*numberPeriods + (int)path[t]];
+  }
+}
+
+
+void TempoTapDegara::viterbiModel(vector<Real>& prior,
+                                  vector<vector<Real> >& transitions) const {
+  prior = _tables->tempoWeights;
+
+  int numberPeriods = prior.size();
+  transitions.assign(numberPeriods, vector<Real>(numberPeriods, (Real) 0.));
+  for (int i=0; i<numberPeriods; ++i) {
+    int begin = _tables->viterbiBegin[i];
+    const Real* band = &_tables->viterbiTransitions[_tables->viterbiOffset[i]];
+    for (int j=begin; j<_tables->viterbiEnd[i]; ++j) {
+      transitions[i][j] = band[j-begin];
     }
   }
 }
 
 
-void TempoTapDegara::createViterbiTransitionMatrix() {
-  // Prepare a transition matrix for Viterbi algorithm: it is a _hopSizeODF x
-  // _hopSizeODF matrix, where each column i consists of a gaussian centered
-  // at i, with stddev=8 by default (i.e., when _hopSizeODF=128), and leave
+void TempoTapDegara::Tables::createViterbiTransitionMatrix() {
+  // Prepare a transition matrix for Viterbi algorithm: it is a hopSizeODF x
+  // hopSizeODF matrix, where each column i consists of a gaussian centered
+  // at i, with stddev=8 by default (i.e., when hopSizeODF=128), and leave
   // columns before 28th and after 108th zeroed, as well as the lines before
   // 28th and after 108th. Paper: informal tests revealed that stddev parameter
   // can vary by a factor of 2 without altering the overall performance of beat
@@ -529,12 +665,9 @@ void TempoTapDegara::createViterbiTransitionMatrix() {
 
   // Generalize values to any ODF sample rate.
 
-  _transitionsViterbi.resize(_hopSizeODF);
-  for (int i=0; i<_hopSizeODF; ++i) {
-    _transitionsViterbi[i].resize(_hopSizeODF);
-  }
+  vector<Real> transitions(hopSizeODF * hopSizeODF, (Real) 0.);
 
-  Real scale = _sampleRateODF / (44100./512);
+  Real scale = sampleRateODF / (44100./512);
 
   // each sequent column contains a gaussian shifted by 1 line
   vector<Real> gaussian;
@@ -548,10 +681,28 @@ void TempoTapDegara::createViterbiTransitionMatrix() {
     // gaussian with mean=i, std=8*scale;
     for (int j=i-gaussianMean; j<=i+gaussianMean; ++j) {
       if (j>=minIndex && j <= maxIndex) {
-        _transitionsViterbi[i][j] = gaussian[j - (i-gaussianMean)];
+        transitions[i*hopSizeODF + j] = gaussian[j - (i-gaussianMean)];
       }
     }
   }
+
+  // only keep the non-zero band of each line, lines out of [minIndex, maxIndex]
+  // get an empty band
+  viterbiOffset.assign(hopSizeODF, 0);
+  viterbiBegin.assign(hopSizeODF, 0);
+  viterbiEnd.assign(hopSizeODF, 0);
+  viterbiTransitions.clear();
+  for (int i=0; i<hopSizeODF; ++i) {
+    const Real* line = &transitions[i*hopSizeODF];
+    int begin = 0;
+    int end = hopSizeODF;
+    while (begin < end && line[begin] == 0) ++begin;
+    while (end > begin && line[end-1] == 0) --end;
+    viterbiOffset[i] = (int) viterbiTransitions.size();
+    viterbiBegin[i] = begin;
+    viterbiEnd[i] = end;
+    viterbiTransitions.insert(viterbiTransitions.end(), line + begin, line + end);
+  }
 }
 
 
@@ -580,20 +731,19 @@ void TempoTapDegara::gaussianPDF(vector<Real>& gaussian, Real gaussianStd, Real
 }
 
 
-void TempoTapDegara::createTempoPreferenceCurve() {
+void TempoTapDegara::Tables::createTempoPreferenceCurve() {
   // Tempo preference weights (Rayleigh distribution) with a peak at 120 BPM,
   // equal to pow(43, 2) with the default ODF sample rate (44100./512).
   // Maximum period of ODF to consider (period of 512 ODF samples with the
   // default settings) correspond to 512 * 512. / 44100. = ~6 secs
-  Real rayparam2 = pow(round(60 * _sampleRateODF / 120), 2);
-  int _maxPeriod = _hopSizeODF;
-  _tempoWeights.resize(_maxPeriod);
-  for (int i=0; i<_maxPeriod; ++i) {
+  Real rayparam2 = pow(round(60 * sampleRateODF / 120), 2);
+  int maxPeriod = hopSizeODF;
+  tempoWeights.resize(maxPeriod);
+  for (int i=0; i<maxPeriod; ++i) {
     int tau = i+1;
-    _tempoWeights[i] = tau / rayparam2 * exp(-0.5 * tau*tau / rayparam2);
+    tempoWeights[i] = tau / rayparam2 * exp(-0.5 * tau*tau / rayparam2);
   }
-  normalizeSum(_tempoWeights);
-  _movingAverage->reset();
+  normalizeSum(tempoWeights);
 }
 
 
@@ -21,6 +21,8 @@
 #define ESSENTIA_TEMPOTAPDEGARA_H
 
 #include "algorithmfactory.h"
+#include "MersenneTwister.h"
+#include <memory>
 
 namespace essentia {
 namespace standard {
@@ -58,36 +60,44 @@ class TempoTapDegara : public Algorithm {
   void configure();
   void compute();
 
+  // Viterbi decoding of the beat periods done by compute(), on the given
+  // observations (one weighting of the periods per ODF frame), and the
+  // model it decodes with, the transition matrix being expanded to a dense
+  // matrix. They are exposed so that benchmarks/viterbi_benchmark.cpp can
+  // check the decoder against a full search.
+  void findViterbiPath(const std::vector<std::vector<Real> >& observations,
+                       std::vector<Real>& path) const;
+  void viterbiModel(std::vector<Real>& prior,
+                    std::vector<std::vector<Real> >& transitions) const;
+
   static const char* name;
   static const char* category;
   static const char* description;
 
  private:
+  class Tables;
+
   // Davies' beat periods estimation:
   int _smoothingWindowHalfSize;
   static const int _numberCombs = 4;
+  static const int _noiseSeed = 0;
   Real _frameDurationODF;
   Real _sampleRateODF;
   int _hopSizeODF;
   Real _hopDurationODF;
   int _resample;
   size_t _numberFramesODF;
-  int _periodMinIndex;
-  int _periodMaxIndex;
   int _periodMaxUserIndex;
   int _periodMinUserIndex;
-  std::vector<Real> _tempoWeights;
-  std::vector<std::vector<Real> > _transitionsViterbi;  // transition matrix for Viterbi
+  // tempo preference curve, comb filterbank and transition matrices, which
+  // only depend on the configuration and are shared by all the instances
+  // configured in the same way
+  std::shared_ptr<const Tables> _tables;
+  std::vector<Real> _thresholdedDetections;
   Algorithm* _autocorrelation;
   Algorithm* _movingAverage;
   Algorithm* _frameCutter;
-  void createTempoPreferenceCurve();
-  void createViterbiTransitionMatrix();
-  void findViterbiPath(const std::vector<Real>& prior,
-                     const std::vector<std::vector<Real> > transitionMatrix,
-                     const std::vector<std::vector<Real> >& observations,
-                     std::vector<Real>& path);
-  void computeBeatPeriodsDavies(std::vector<Real> detections,
+  void computeBeatPeriodsDavies(const std::vector<Real>& detections,
                                 std::vector<Real>& beatPeriods,
                                 std::vector<Real>& beatEndPositions);
   void adaptiveThreshold(std::vector<Real>& array, int smoothingHalfSize);
@@ -102,15 +112,13 @@ class TempoTapDegara : public Algorithm {
                           const std::vector<Real>& beatPeriods,
                           const std::vector<Real>& beatEndPositions,
                           std::vector<Real>& ticks);
-  void computeHMMTransitionMatrix(const std::vector<Real>& ibiPDF,
-                                  std::vector<std::vector<Real> >& transitions);
-  void decodeBeats(std::map<Real, std::vector<std::vector<Real> > >& transitionMatrix,
-                   const std::vector<Real>& beatPeriods,
+  void decodeBeats(const std::vector<int>& beatPeriodIndices,
                    const std::vector<Real>& beatEndPositions,
-                   const std::vector<std::vector<Real> >& biy,
+                   const std::vector<Real>& beatProbability,
+                   const std::vector<Real>& noBeatProbability,
                    std::vector<int>& sequenceStates);
 
-  void gaussianPDF(std::vector<Real>& gaussian, Real gaussianStd, Real step, Real scale=1.);
+  static void gaussianPDF(std::vector<Real>& gaussian, Real gaussianStd, Real step, Real scale=1.);
 }; // class TempoTapDegara
 
 } // namespace standard
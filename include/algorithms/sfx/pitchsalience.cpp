@@ -61,7 +61,7 @@ void PitchSalience::compute() {
     throw EssentiaException("PitchSalience: spectrum is an empty vector");
   }
 
-  vector<Real> acf;
+  vector<Real>& acf = _acf;
   _autoCorrelation->input("array").set(spectrum);
   _autoCorrelation->output("autoCorrelation").set(acf);
   _autoCorrelation->compute();
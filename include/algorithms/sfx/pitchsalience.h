@@ -35,6 +35,7 @@ class PitchSalience : public Algorithm {
   Output<Real> _pitchSalience;
 
   Algorithm* _autoCorrelation;
+  std::vector<Real> _acf;
 
  public:
   PitchSalience() {
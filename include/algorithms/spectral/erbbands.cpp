@@ -40,10 +40,10 @@ void ERBBands::configure() {
   _maxFrequency = parameter("highFrequencyBound").toReal();
   _minFrequency = parameter("lowFrequencyBound").toReal();
   _width = parameter("width").toReal();
+  _type = parameter("type").toLower();
+
   calculateFilterFrequencies();
   createFilters(parameter("inputSize").toInt());
-
-  _type = parameter("type").toLower();
 }
 
 void ERBBands::calculateFilterFrequencies() {
@@ -59,6 +59,21 @@ void ERBBands::calculateFilterFrequencies() {
 }
 
 void ERBBands::createFilters(int spectrumSize) {
+  Filterbank::Key key;
+  key.shape = "erb";
+  key.spectrumSize = spectrumSize;
+  key.sampleRate = _sampleRate;
+  key.parameters.push_back(_numberBands);
+  key.parameters.push_back(_minFrequency);
+  key.parameters.push_back(_maxFrequency);
+  key.parameters.push_back(_width);
+
+  _filterbank = Filterbank::get(key, [this, spectrumSize](vector<vector<Real> >& weights) {
+    createWeights(spectrumSize, weights);
+  });
+}
+
+void ERBBands::createWeights(int spectrumSize, vector<vector<Real> >& weights) {
   if (spectrumSize < 2) {
     throw EssentiaException("ERBBands: Filter bank cannot be computed from a spectrum with less than 2 bins");
   }
@@ -68,7 +83,7 @@ void ERBBands::createFilters(int spectrumSize) {
   complex<Real> oneJ(0,1);
   Real order = 1;
   Real pi = Real(M_PI);
-  _filterCoefficients = vector<vector<Real> >(filterSize, vector<Real>(spectrumSize, 0.0));
+  weights.assign(filterSize, vector<Real>(spectrumSize, 0.0));
   Real fftSize = (spectrumSize-1)*2;
   for (int i=0; i<spectrumSize; i++) {
  	  ucirc[i] = exp((oneJ*Real(2.0)*pi*Real(i))/fftSize);
@@ -118,7 +133,7 @@ void ERBBands::createFilters(int spectrumSize) {
                 Real(2)* cxExp + Real(2)*(Real(1) + cxExp)/exp(B*T)),Real(4)));
 
     for (int j=0; j<spectrumSize; j++) {
-      _filterCoefficients[i][j] = (pow(T,4)/filterGain) *
+      weights[i][j] = (pow(T,4)/filterGain) *
             abs(ucirc[j]-zeros[0]) * abs(ucirc[j]-zeros[1]) *
             abs(ucirc[j]-zeros[2]) * abs(ucirc[j]-zeros[3]) *
             pow(abs((pole-ucirc[j])*(pole-ucirc[j])),(-GTord));
@@ -131,37 +146,17 @@ void ERBBands::compute() {
   const std::vector<Real>& spectrum = _spectrumInput.get();
   std::vector<Real>& bands = _bandsOutput.get();
 
-  int filterSize = _numberBands;
   int spectrumSize = spectrum.size();
 
-  if (_filterCoefficients.empty() ||
-      int(_filterCoefficients[0].size()) != spectrumSize) {
-    E_INFO("ERBBands: input spectrum size (" << spectrumSize << ") does not correspond to the \"inputSize\" parameter (" << _filterCoefficients[0].size() << "). Recomputing the filter bank.");
+  if (_filterbank->spectrumSize() != spectrumSize) {
+    E_INFO("ERBBands: input spectrum size (" << spectrumSize << ") does not correspond to the \"inputSize\" parameter (" << _filterbank->spectrumSize() << "). Recomputing the filter bank.");
     createFilters(spectrumSize);
   }
 
-  bands.resize(filterSize);
-
-
   // NB: Band magnitudes are returned, while BarkBands and MelBands algorithms
   // return energy. Gerard Roma have found magnitudes work better when
   // working with sound effects.  Band magnitudes option is required for 
   // OnsetDetectionGlobal algorithm.
 
-  if (_type=="magnitude") {
-    for (int i=0; i<filterSize; ++i) {
-      bands[i] = 0;
-      for (int j=0; j<spectrumSize; ++j) {
-        bands[i] += (spectrum[j]) * _filterCoefficients[i][j];
-      }
-    }
-  }
-  else if (_type=="power") {
-    for (int i=0; i<filterSize; ++i) {
-      bands[i] = 0;
-      for (int j=0; j<spectrumSize; ++j) {
-        bands[i] += (spectrum[j] * spectrum[j]) * _filterCoefficients[i][j];
-      }
-    }
-  }
+  _filterbank->compute(spectrum, bands, _type == "power" ? Filterbank::POWER : Filterbank::MAGNITUDE);
 }
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#include "filterbank.h"
+#include "essentia.h"
+#include "threading.h"
+#include <map>
+
+using namespace std;
+
+namespace essentia {
+namespace standard {
+
+// Dot products of a band with the bins of a spectrum. The sum is split into
+// four partial sums, independent from each other, which the compiler can
+// keep in a single vector register, and which do not wait for each other.
+static inline Real dotMagnitude(const Real* bins, const Real* weights, int size) {
+  Real sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  int j = 0;
+  for (; j+4<=size; j+=4) {
+    sum0 += bins[j] * weights[j];
+    sum1 += bins[j+1] * weights[j+1];
+    sum2 += bins[j+2] * weights[j+2];
+    sum3 += bins[j+3] * weights[j+3];
+  }
+  for (; j<size; ++j) sum0 += bins[j] * weights[j];
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
+static inline Real dotPower(const Real* bins, const Real* weights, int size) {
+  Real sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  int j = 0;
+  for (; j+4<=size; j+=4) {
+    sum0 += (bins[j] * bins[j]) * weights[j];
+    sum1 += (bins[j+1] * bins[j+1]) * weights[j+1];
+    sum2 += (bins[j+2] * bins[j+2]) * weights[j+2];
+    sum3 += (bins[j+3] * bins[j+3]) * weights[j+3];
+  }
+  for (; j<size; ++j) sum0 += (bins[j] * bins[j]) * weights[j];
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
+bool Filterbank::Key::operator<(const Key& other) const {
+  if (shape != other.shape) return shape < other.shape;
+  if (spectrumSize != other.spectrumSize) return spectrumSize < other.spectrumSize;
+  if (sampleRate != other.sampleRate) return sampleRate < other.sampleRate;
+  return parameters < other.parameters;
+}
+
+shared_ptr<const Filterbank> Filterbank::get(const Key& key, const Builder& createWeights) {
+  static ForcedMutex filterbanksMutex;
+  static map<Key, shared_ptr<const Filterbank> > sharedFilterbanks;
+
+  ForcedMutexLocker lock(filterbanksMutex);
+  shared_ptr<const Filterbank>& filterbank = sharedFilterbanks[key];
+  if (!filterbank) {
+    vector<vector<Real> > weights;
+    createWeights(weights);
+    filterbank = make_shared<const Filterbank>(weights, key.spectrumSize);
+  }
+  return filterbank;
+}
+
+Filterbank::Filterbank(const vector<vector<Real> >& weights, int spectrumSize) :
+    _spectrumSize(spectrumSize) {
+  int numberBands = (int)weights.size();
+  _begin.resize(numberBands);
+  _offset.resize(numberBands + 1);
+
+  for (int i=0; i<numberBands; ++i) {
+    if ((int)weights[i].size() != spectrumSize) {
+      throw EssentiaException("Filterbank: the weights of band ", i, " do not match the size of the spectrum");
+    }
+
+    // the bins out of [begin, end) have a zero weight, and adding them to the
+    // sum does not change it
+    int begin = 0;
+    int end = spectrumSize;
+    while (begin < end && weights[i][begin] == 0) begin++;
+    while (end > begin && weights[i][end-1] == 0) end--;
+
+    _begin[i] = begin;
+    _offset[i] = (int)_weights.size();
+    _weights.insert(_weights.end(), weights[i].begin() + begin, weights[i].begin() + end);
+  }
+  _offset[numberBands] = (int)_weights.size();
+}
+
+void Filterbank::checkSize(const vector<Real>& spectrum) const {
+  if ((int)spectrum.size() != _spectrumSize) {
+    throw EssentiaException("Filterbank: the size of the spectrum does not match the size of the filterbank (", _spectrumSize, " bins)");
+  }
+}
+
+void Filterbank::compute(const vector<Real>& spectrum, vector<Real>& bands, Type type) const {
+  checkSize(spectrum);
+
+  int numberBands = (int)_begin.size();
+  bands.resize(numberBands);
+
+  for (int i=0; i<numberBands; ++i) {
+    const Real* weights = _weights.data() + _offset[i];
+    const Real* bins = spectrum.data() + _begin[i];
+    int size = _offset[i+1] - _offset[i];
+
+    bands[i] = type == POWER ? dotPower(bins, weights, size) : dotMagnitude(bins, weights, size);
+  }
+}
+
+void Filterbank::compute(const vector<vector<Real> >& spectra,
+                         vector<vector<Real> >& bands, Type type) const {
+  int numberFrames = (int)spectra.size();
+  int numberBands = (int)_begin.size();
+
+  bands.resize(numberFrames);
+  for (int f=0; f<numberFrames; ++f) {
+    checkSize(spectra[f]);
+    bands[f].resize(numberBands);
+  }
+
+  // the frames are processed in blocks small enough to stay in the cache
+  // while all the bands are applied to them
+  const int blockSize = 8;
+  for (int block=0; block<numberFrames; block+=blockSize) {
+    int blockEnd = min(block + blockSize, numberFrames);
+
+    for (int i=0; i<numberBands; ++i) {
+      const Real* weights = _weights.data() + _offset[i];
+      int size = _offset[i+1] - _offset[i];
+
+      for (int f=block; f<blockEnd; ++f) {
+        const Real* bins = spectra[f].data() + _begin[i];
+        bands[f][i] = type == POWER ? dotPower(bins, weights, size) : dotMagnitude(bins, weights, size);
+      }
+    }
+  }
+}
+
+} // namespace standard
+} // namespace essentia
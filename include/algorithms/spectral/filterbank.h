@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_FILTERBANK_H
+#define ESSENTIA_FILTERBANK_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include "types.h"
+
+namespace essentia {
+namespace standard {
+
+/**
+ * Bank of linear filters applied to a spectrum, such as the triangular bands
+ * of MelBands, the rectangular bands of FrequencyBands or the gammatone
+ * filters of ERBBands. Each output band is the weighted sum of the spectrum
+ * bins (or of their squares, for the energy in the band).
+ *
+ * The weights are stored as a sparse matrix: for each band, only the range
+ * of bins between its first and last non-zero weight is kept, so that
+ * filtering a spectrum is a dot product over a contiguous range of bins per
+ * band. The dot products use several partial sums, so the results may differ
+ * from a sequential sum by rounding errors (relative differences of about
+ * 1e-6).
+ *
+ * A filterbank only depends on its configuration, so the ones created through
+ * get() are immutable and shared by all the algorithms configured in the same
+ * way, in all the threads, for the whole process.
+ */
+class Filterbank {
+ public:
+  enum Type {
+    MAGNITUDE,  // sum of the weighted magnitudes
+    POWER       // sum of the weighted squared magnitudes
+  };
+
+  struct Key {
+    std::string shape;              // kind of filters and their options
+    int spectrumSize;
+    Real sampleRate;
+    std::vector<Real> parameters;   // eg: the band frequencies
+
+    bool operator<(const Key& other) const;
+  };
+
+  // fills a dense matrix of weights, one line of spectrumSize bins per band
+  typedef std::function<void (std::vector<std::vector<Real> >& weights)> Builder;
+
+  /**
+   * Returns the filterbank with the given configuration, calling the builder
+   * only if no such filterbank has been created yet. Exceptions thrown by the
+   * builder are propagated, and nothing is cached then.
+   */
+  static std::shared_ptr<const Filterbank> get(const Key& key, const Builder& createWeights);
+
+  Filterbank(const std::vector<std::vector<Real> >& weights, int spectrumSize);
+
+  int numberBands() const { return (int)_begin.size(); }
+  int spectrumSize() const { return _spectrumSize; }
+
+  void compute(const std::vector<Real>& spectrum, std::vector<Real>& bands, Type type) const;
+
+  /**
+   * Filters several spectra at once: each band is applied to all the frames
+   * before moving to the next one, so that its weights are only loaded once.
+   */
+  void compute(const std::vector<std::vector<Real> >& spectra,
+               std::vector<std::vector<Real> >& bands, Type type) const;
+
+ private:
+  int _spectrumSize;
+  // the weights of band i are _weights[_offset[i] .. _offset[i+1]), applied
+  // to the bins starting at _begin[i]
+  std::vector<int> _begin;
+  std::vector<int> _offset;
+  std::vector<Real> _weights;
+
+  void checkSize(const std::vector<Real>& spectrum) const;
+};
+
+} // namespace standard
+} // namespace essentia
+
+#endif // ESSENTIA_FILTERBANK_H
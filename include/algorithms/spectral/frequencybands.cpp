@@ -49,6 +49,7 @@ void FrequencyBands::configure() {
       throw EssentiaException("FrequencyBands: the values in the 'frequencyBands' parameter are not in ascending order or there exists a duplicate value");
     }
   }
+  _filterbank.reset();
 }
 
 void FrequencyBands::compute() {
@@ -59,31 +60,47 @@ void FrequencyBands::compute() {
     throw EssentiaException("FrequencyBands: the size of the input spectrum is not greater than one");
   }
 
-  Real frequencyscale = (_sampleRate / 2.0) / (spectrum.size() - 1);
+  if (!_filterbank || _filterbank->spectrumSize() != int(spectrum.size())) {
+    createFilters(spectrum.size());
+  }
+
+  _filterbank->compute(spectrum, bands, Filterbank::POWER);
+
+  // decision: don't scale the bands in any way...
+  // this way, when summing the energy, we will get consistent *summed* results
+  // for different FFT-sizes, (with zero-overlap)
+}
+
+void FrequencyBands::createFilters(int spectrumSize) {
+  Filterbank::Key key;
+  key.shape = "rectangular";
+  key.spectrumSize = spectrumSize;
+  key.sampleRate = _sampleRate;
+  key.parameters = _bandFrequencies;
+
+  _filterbank = Filterbank::get(key, [this, spectrumSize](std::vector<std::vector<Real> >& weights) {
+    createWeights(spectrumSize, weights);
+  });
+}
+
+void FrequencyBands::createWeights(int spectrumSize, std::vector<std::vector<Real> >& weights) {
+  Real frequencyscale = (_sampleRate / 2.0) / (spectrumSize - 1);
   int nBands = int(_bandFrequencies.size() - 1);
 
-  bands.resize(nBands);
-  std::fill(bands.begin(), bands.end(), (Real) 0.0);
+  weights.assign(nBands, std::vector<Real>(spectrumSize, 0.0));
 
   for (int i=0; i<nBands; i++) {
     int startBin = int(_bandFrequencies[i] / frequencyscale + 0.5);
     int endBin = int(_bandFrequencies[i + 1] / frequencyscale + 0.5);
 
-    if (startBin >= int(spectrum.size())) {
+    if (startBin >= spectrumSize) {
       break;
     }
 
-    if (endBin > int(spectrum.size())) {
-      endBin = spectrum.size();
+    if (endBin > spectrumSize) {
+      endBin = spectrumSize;
     }
 
-    for (int j=startBin; j<endBin; j++) {
-      Real magSquared = spectrum[j] * spectrum[j];
-      bands[i] += magSquared;
-    }
+    std::fill(weights[i].begin() + startBin, weights[i].begin() + endBin, (Real) 1.0);
   }
-
-  // decision: don't scale the bands in any way...
-  // this way, when summing the energy, we will get consistent *summed* results
-  // for different FFT-sizes, (with zero-overlap)
 }
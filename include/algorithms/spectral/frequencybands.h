@@ -22,6 +22,7 @@
 
 #include "algorithm.h"
 #include "essentiautil.h"
+#include "filterbank.h"
 
 namespace essentia {
 namespace standard {
@@ -58,6 +59,10 @@ class FrequencyBands : public Algorithm {
  protected:
   std::vector<Real> _bandFrequencies;
   Real _sampleRate;
+  std::shared_ptr<const Filterbank> _filterbank;
+
+  void createFilters(int spectrumSize);
+  void createWeights(int spectrumSize, std::vector<std::vector<Real> >& weights);
 };
 
 } // namespace standard
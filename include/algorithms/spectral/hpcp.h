@@ -21,19 +21,12 @@
 #define ESSENTIA_HPCP_H
 
 #include "algorithm.h"
+#include "hpcpengine.h"
 
 namespace essentia {
 namespace standard {
 
 class HPCP : public Algorithm {
- public:
-  struct HarmonicPeak {
-    HarmonicPeak(Real semitone, Real harmonicStrength = 0.0)
-      : semitone(semitone), harmonicStrength(harmonicStrength) {}
-
-    Real semitone;
-    Real harmonicStrength;
-  };
 
  protected:
   Input<std::vector<Real> > _frequencies;
@@ -72,34 +65,8 @@ class HPCP : public Algorithm {
   static const Real precision;
 
  protected:
-  void addContribution(Real freq, Real mag_lin, std::vector<Real>& hpcp) const;
-  void addContributionWithWeight(Real freq, Real mag_lin, std::vector<Real>& hpcp, Real harmonicWeight) const;
-  void addContributionWithoutWeight(Real freq, Real mag_lin, std::vector<Real>& hpcp, Real harmonicWeight) const;
-
-  void initHarmonicContributionTable();
-  int _size;
-  Real _windowSize;
-  Real _referenceFrequency;
-  Real _nHarmonics;
-  Real _minFrequency;
-  Real _maxFrequency;
-  Real _splitFrequency;
-  bool _bandPreset;
-
-  enum WeightType {
-    NONE, COSINE, SQUARED_COSINE
-  };
-  WeightType _weightType;
-
-  enum NormalizeType {
-    N_NONE, N_UNIT_MAX, N_UNIT_SUM
-  };
-  NormalizeType _normalized;
-
-  bool _nonLinear;
-  bool _maxShifted;
-
-  std::vector<HarmonicPeak> _harmonicPeaks;
+  HPCPEngine _engine;
+  std::vector<double> _octaves;
 };
 
 } // namespace standard
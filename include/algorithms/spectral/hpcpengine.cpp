@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+
+#include "hpcpengine.h"
+#include "essentiamath.h"
+
+using namespace std;
+
+namespace essentia {
+namespace standard {
+
+const Real HPCPEngine::precision = 0.00001;
+
+// number of entries of the weight table per window size, the error of the
+// linear interpolation of the cosine being below 3e-7
+static const int weightTableResolution = 2048;
+
+void HPCPEngine::configure(const ParameterMap& parameters) {
+  // the ranges declared by HPCP are checked here as well, as MultiHPCP
+  // cannot declare them on its lists of values
+  _size = parameters["size"].toInt();
+
+  if (_size < 12 || _size % 12 != 0) {
+    throw EssentiaException("HPCP: The size parameter is not a positive nonzero multiple of 12.");
+  }
+
+  Real windowSize = parameters["windowSize"].toReal();
+
+  if (!(windowSize > 0 && windowSize <= 12)) {
+    throw EssentiaException("HPCP: The windowSize parameter must be in (0,12]");
+  }
+
+  if (windowSize * _size/12 < 1.0) {
+    throw EssentiaException("HPCP: Your windowSize needs to span at least one hpcp bin (windowSize >= 12/size)");
+  }
+
+  _minFrequency = parameters["minFrequency"].toReal();
+  _maxFrequency = parameters["maxFrequency"].toReal();
+
+  if (!(_minFrequency > 0) || !(_maxFrequency > 0)) {
+    throw EssentiaException("HPCP: The minimum and maximum frequencies must be positive");
+  }
+
+  if ((_maxFrequency - _minFrequency) < 200.0) {
+    throw EssentiaException("HPCP: Minimum and maximum frequencies are too close");
+  }
+
+  _splitFrequency = parameters["bandSplitFrequency"].toReal();
+  _bandPreset = parameters["bandPreset"].toBool();
+
+  if (!(_splitFrequency > 0)) {
+    throw EssentiaException("HPCP: The band split frequency must be positive");
+  }
+
+  if (_bandPreset) {
+    if ((_splitFrequency - _minFrequency) < 200.0) {
+      throw EssentiaException("HPCP: Low band frequency range too small");
+    }
+    if ((_maxFrequency - _splitFrequency) < 200.0) {
+      throw EssentiaException("HPCP: High band frequency range too small");
+    }
+  }
+
+  string weightType = toLower(parameters["weightType"].toString());
+  if      (weightType == "none") _weightType = NONE;
+  else if (weightType == "cosine") _weightType = COSINE;
+  else if (weightType == "squaredcosine") _weightType = SQUARED_COSINE;
+  else throw EssentiaException("Invalid weight type for HPCP: ", weightType);
+
+  _nonLinear = parameters["nonLinear"].toBool();
+  _maxShifted = parameters["maxShifted"].toBool();
+
+  string normalized = toLower(parameters["normalized"].toString());
+  if      (normalized == "none") _normalized = N_NONE;
+  else if (normalized == "unitsum") _normalized = N_UNIT_SUM;
+  else if (normalized == "unitmax") _normalized = N_UNIT_MAX;
+  else throw EssentiaException("Invalid normalization for HPCP: ", normalized);
+
+  if (_nonLinear && _normalized != N_UNIT_MAX) {
+    throw EssentiaException("HPCP: Cannot apply non-linear filter when HPCP vector is not normalized to unit max.");
+  }
+
+  Real referenceFrequency = parameters["referenceFrequency"].toReal();
+  if (!(referenceFrequency > 0)) {
+    throw EssentiaException("HPCP: The reference frequency must be positive");
+  }
+  _referenceOctave = log2((double)referenceFrequency);
+
+  Real resolution = _size / 12; // # of bins / semitone
+  _halfWindow = resolution * windowSize / 2.0;
+  _weightStep = weightTableResolution / (resolution * windowSize);
+  _padding = (int)ceil(_halfWindow) + 1;
+
+  int harmonics = parameters["harmonics"].toInt();
+  if (harmonics < 0) {
+    throw EssentiaException("HPCP: The number of harmonics must be positive or zero");
+  }
+  initHarmonicContributionTable(harmonics);
+  initWeightTable();
+}
+
+
+// Builds a weighting table of harmonic contribution. Higher harmonics
+// contribute less and the fundamental frequency has a full harmonic
+// strength of 1.0.
+void HPCPEngine::initHarmonicContributionTable(int numberHarmonics) {
+  vector<Real> semitones;
+  vector<Real> strengths;
+
+  // Populate the table with the semitonal positions of each of the
+  // harmonics.
+  for (int i = 0; i <= numberHarmonics; i++) {
+    Real semitone = 12.0 * log2(i+1.0);
+    Real octweight = max(1.0 , ( semitone /12.0)*0.5);
+
+    // Get the semitone within the range (0-precision, 12.0-precision]
+    while (semitone >= 12.0-precision) {
+      semitone -= 12.0;
+    }
+
+    // Check to see if the semitone has already been added to the table
+    int j = 0;
+    for (; j<(int)semitones.size(); j++) {
+      if (semitones[j] > semitone-precision && semitones[j] < semitone+precision) break;
+    }
+
+    if (j == (int)semitones.size()) {
+      // no harmonic peak found for this frequency; add it
+      semitones.push_back(semitone);
+      strengths.push_back(1.0 / octweight);
+    }
+    else {
+      // else, add the weight
+      strengths[j] += (1.0 / octweight);
+    }
+  }
+
+  // The contribution of a harmonic goes to its hypothesized fundamental,
+  // which is this many bins below it; the weights are applied to the
+  // squared magnitudes
+  _harmonicOffsets.resize(semitones.size());
+  _harmonicWeights.resize(semitones.size());
+  for (int j=0; j<(int)semitones.size(); j++) {
+    _harmonicOffsets[j] = semitones[j] * _size / 12.0;
+    _harmonicWeights[j] = strengths[j] * strengths[j];
+  }
+}
+
+
+void HPCPEngine::initWeightTable() {
+  // one more entry so that the interpolation at half a window does not
+  // read out of the table
+  _weights.resize(weightTableResolution / 2 + 2);
+  for (int i=0; i<(int)_weights.size(); i++) {
+    Real normalizedDistance = min(Real(i) / weightTableResolution, Real(0.5));
+    Real weight = 0.;
+
+    if (_weightType == COSINE) {
+      weight = cos(M_PI*normalizedDistance);
+    }
+    else if (_weightType == SQUARED_COSINE) {
+      weight = cos(M_PI*normalizedDistance);
+      weight *= weight;
+    }
+    _weights[i] = weight;
+  }
+}
+
+
+void HPCPEngine::computeOctaves(const vector<Real>& frequencies, vector<double>& octaves) {
+  octaves.resize(frequencies.size());
+  for (int i=0; i<(int)frequencies.size(); i++) {
+    octaves[i] = log2((double)frequencies[i]);
+  }
+}
+
+
+// Adds the contribution of a peak, at the given bin in [0, size), as the
+// tonic semitone as well as a harmonic of other pitches, to a padded
+// profile (profile[-_padding] to profile[_size+_padding-1] are valid).
+void HPCPEngine::addContributions(double bin, Real energy, Real* profile) const {
+  for (int h=0; h<(int)_harmonicOffsets.size(); h++) {
+    // bin of the hypothesized fundamental, brought back to [0, size)
+    double center = bin - _harmonicOffsets[h];
+    if (center < 0) center += _size;
+    if (center >= _size) center -= _size;
+
+    Real contribution = energy * _harmonicWeights[h];
+
+    if (_weightType == NONE) {
+      // Original Fujishima algorithm, basically places the contribution in
+      // the bin nearest to the given frequency
+      int nearest = (int)round(center);
+      if (nearest >= _size) nearest -= _size;
+      profile[nearest] += contribution;
+      continue;
+    }
+
+    // apply weight to all bins in the window centered at this frequency
+    int left = (int)ceil(center - _halfWindow);
+    int right = (int)floor(center + _halfWindow);
+    for (int i=left; i<=right; i++) {
+      double position = fabs(center - i) * _weightStep;
+      int index = (int)position;
+      Real fraction = Real(position - index);
+      Real weight = _weights[index] + fraction * (_weights[index+1] - _weights[index]);
+      profile[i] += weight * contribution;
+    }
+  }
+}
+
+
+// Wraps a padded profile into the HPCP
+void HPCPEngine::fold(const vector<Real>& profile, vector<Real>& hpcp) const {
+  hpcp.assign(profile.begin() + _padding, profile.begin() + _padding + _size);
+  for (int i=0; i<_padding; i++) {
+    hpcp[_size - _padding + i] += profile[i];
+    hpcp[i] += profile[_padding + _size + i];
+  }
+}
+
+
+void HPCPEngine::compute(const vector<Real>& frequencies, const vector<double>& octaves,
+                         const vector<Real>& magnitudes, vector<Real>& hpcp) {
+  // Check inputs
+  if (magnitudes.size() != frequencies.size()) {
+    throw EssentiaException("HPCP: Frequency and magnitude input vectors are not of equal size");
+  }
+  if (octaves.size() != frequencies.size()) {
+    throw EssentiaException("HPCP: the octaves do not match the frequencies of the peaks");
+  }
+
+  // Initialize data structures
+  int paddedSize = _size + 2*_padding;
+  _low.assign(paddedSize, (Real)0.0);
+  if (_bandPreset) {
+    _high.assign(paddedSize, (Real)0.0);
+  }
+
+  // Add each contribution of the spectral frequencies to the HPCP
+  for (int i=0; i<(int)frequencies.size(); i++) {
+    Real freq = frequencies[i];
+
+    // Filter out frequencies not between min and max
+    if (!(freq >= _minFrequency && freq <= _maxFrequency)) continue;
+
+    Real* profile = (_bandPreset && freq >= _splitFrequency) ? &_high[_padding] : &_low[_padding];
+
+    // convert frequency in Hz to frequency in pcpBin index, in [0, size)
+    double bin = (octaves[i] - _referenceOctave) * _size;
+    bin -= floor(bin / _size) * _size;
+    if (bin >= _size) bin -= _size;
+
+    addContributions(bin, magnitudes[i] * magnitudes[i], profile);
+  }
+
+  fold(_low, hpcp);
+
+  // Normalize the HPCP vector
+
+  if (_bandPreset) {
+    fold(_high, _highBand);
+
+    if (_normalized == N_UNIT_MAX) {
+      normalize(hpcp);
+      normalize(_highBand);
+    }
+    else if (_normalized == N_UNIT_SUM) {
+      // TODO does it makes sense to apply band preset together with unit sum normalization?
+      E_WARNING("HPCP: applying band preset together with unit sum normalization was not tested.");
+      normalizeSum(hpcp);
+      normalizeSum(_highBand);
+    }
+
+    for (int i=0; i<_size; i++) {
+      hpcp[i] += _highBand[i];
+    }
+  }
+
+  if (_normalized == N_UNIT_MAX) {
+    normalize(hpcp);
+  }
+  else if (_normalized == N_UNIT_SUM) {
+    normalizeSum(hpcp);
+  }
+
+  // Perform the Jordi non-linear post-processing step
+  // This makes small values (below 0.6) even smaller
+  // while boosting further values close to 1.
+  if (_nonLinear) {
+    for (int i=0; i<_size; i++) {
+      hpcp[i] = sin(hpcp[i] * M_PI * 0.5);
+      hpcp[i] *= hpcp[i];
+      if (hpcp[i] < 0.6) {
+        hpcp[i] *= hpcp[i]/0.6 * hpcp[i]/0.6;
+      }
+    }
+  }
+
+  // Shift all of the elements so that the largest HPCP value is at index 0,
+  // only if this option is enabled.
+  if (_maxShifted) {
+    rotate(hpcp.begin(), hpcp.begin() + argmax(hpcp), hpcp.end());
+  }
+}
+
+} // namespace standard
+} // namespace essentia
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+
+#ifndef ESSENTIA_HPCPENGINE_H
+#define ESSENTIA_HPCPENGINE_H
+
+#include <vector>
+#include "parameter.h"
+
+namespace essentia {
+namespace standard {
+
+/**
+ * Computation of the Harmonic Pitch Class Profile of a frame from its
+ * spectral peaks, as done by the HPCP algorithm, shared by HPCP and
+ * MultiHPCP.
+ *
+ * Everything that only depends on the parameters is precomputed in
+ * configure(): the offsets of the harmonics in HPCP bins and their weights,
+ * and the weighting function (cosine or squared cosine) is tabulated over
+ * the window and linearly interpolated, so that compute() does not call
+ * any transcendental function but the logarithm of each peak frequency.
+ * As the peak frequencies are reduced to a single period of the HPCP and
+ * the profile is padded by half a window on each side, the contributions of
+ * a peak are added to consecutive bins without wrapping them one by one.
+ */
+class HPCPEngine {
+ public:
+  HPCPEngine() : _size(0) {}
+
+  /**
+   * Configures the engine with the parameters of the HPCP algorithm (see
+   * HPCP::declareParameters()), throwing the same exceptions as HPCP.
+   */
+  void configure(const ParameterMap& parameters);
+
+  /**
+   * Computes the HPCP of a frame. octaves are the logarithms in base 2 of the
+   * frequencies of the peaks (see computeOctaves()), so that several engines
+   * working on the same peaks compute them only once.
+   */
+  void compute(const std::vector<Real>& frequencies, const std::vector<double>& octaves,
+               const std::vector<Real>& magnitudes, std::vector<Real>& hpcp);
+
+  static void computeOctaves(const std::vector<Real>& frequencies, std::vector<double>& octaves);
+
+  // capacity to reserve for the octaves, so that they do not need to grow on
+  // later frames with the usual numbers of peaks (SpectralPeaks returns at
+  // most 100 by default)
+  static const int reservedPeaks = 512;
+
+  int size() const { return _size; }
+
+  static const Real precision;
+
+ private:
+  void initHarmonicContributionTable(int numberHarmonics);
+  void initWeightTable();
+  void addContributions(double bin, Real energy, Real* profile) const;
+  void fold(const std::vector<Real>& profile, std::vector<Real>& hpcp) const;
+
+  enum WeightType {
+    NONE, COSINE, SQUARED_COSINE
+  };
+
+  enum NormalizeType {
+    N_NONE, N_UNIT_MAX, N_UNIT_SUM
+  };
+
+  int _size;
+  Real _minFrequency;
+  Real _maxFrequency;
+  Real _splitFrequency;
+  bool _bandPreset;
+  WeightType _weightType;
+  NormalizeType _normalized;
+  bool _nonLinear;
+  bool _maxShifted;
+
+  double _referenceOctave;   // log2 of the reference frequency
+  double _halfWindow;        // half of the window size [bins]
+  double _weightStep;        // entries of the weight table per bin
+  int _padding;              // bins on each side of the padded profiles
+
+  // offsets of the harmonics in bins, from the fundamental, and the squares
+  // of their weights
+  std::vector<double> _harmonicOffsets;
+  std::vector<Real> _harmonicWeights;
+
+  // weight as a function of the distance to the peak, from 0 to half a window
+  std::vector<Real> _weights;
+
+  // padded profiles (both bands, or only the low one without band preset)
+  std::vector<Real> _low;
+  std::vector<Real> _high;
+  std::vector<Real> _highBand;
+};
+
+} // namespace standard
+} // namespace essentia
+
+#endif // ESSENTIA_HPCPENGINE_H
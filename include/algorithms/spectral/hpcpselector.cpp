@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+
+#include "hpcpselector.h"
+
+using namespace std;
+
+namespace essentia {
+namespace standard {
+
+const char* HPCPSelector::name = "HPCPSelector";
+const char* HPCPSelector::category = "Tonal";
+const char* HPCPSelector::description = DOC("This algorithm outputs one of the harmonic pitch class profiles computed by MultiHPCP, the one of the configuration with the given index. In streaming mode, it splits the output of MultiHPCP into one stream per configuration, to be connected to the algorithms that expect the output of HPCP.\n"
+"\n"
+"An exception is thrown if the index is not smaller than the number of input profiles.");
+
+void HPCPSelector::configure() {
+  _index = parameter("index").toInt();
+}
+
+void HPCPSelector::compute() {
+  const vector<vector<Real> >& hpcps = _hpcps.get();
+  vector<Real>& hpcp = _hpcp.get();
+
+  if (_index >= (int)hpcps.size()) {
+    throw EssentiaException("HPCPSelector: there are less input HPCPs than the index to select");
+  }
+
+  hpcp = hpcps[_index];
+}
+
+} // namespace standard
+} // namespace essentia
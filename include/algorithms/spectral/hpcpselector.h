@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_HPCPSELECTOR_H
+#define ESSENTIA_HPCPSELECTOR_H
+
+#include "algorithm.h"
+
+namespace essentia {
+namespace standard {
+
+class HPCPSelector : public Algorithm {
+
+ protected:
+  Input<std::vector<std::vector<Real> > > _hpcps;
+  Output<std::vector<Real> > _hpcp;
+
+  int _index;
+
+ public:
+  HPCPSelector() {
+    declareInput(_hpcps, "hpcps", "the harmonic pitch class profiles computed by MultiHPCP");
+    declareOutput(_hpcp, "hpcp", "the selected harmonic pitch class profile");
+  }
+
+  void declareParameters() {
+    declareParameter("index", "the index of the configuration of MultiHPCP to select", "[0,inf)", 0);
+  }
+
+  void configure();
+  void compute();
+
+  static const char* name;
+  static const char* category;
+  static const char* description;
+};
+
+} // namespace standard
+} // namespace essentia
+
+#include "streamingalgorithmwrapper.h"
+
+namespace essentia {
+namespace streaming {
+
+class HPCPSelector : public StreamingAlgorithmWrapper {
+
+ protected:
+  Sink<std::vector<std::vector<Real> > > _hpcps;
+  Source<std::vector<Real> > _hpcp;
+
+ public:
+  HPCPSelector() {
+    declareAlgorithm("HPCPSelector");
+    declareInput(_hpcps, TOKEN, "hpcps");
+    declareOutput(_hpcp, TOKEN, "hpcp");
+  }
+};
+
+} // namespace streaming
+} // namespace essentia
+
+#endif // ESSENTIA_HPCPSELECTOR_H
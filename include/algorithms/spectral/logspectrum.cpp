@@ -53,7 +53,8 @@ void LogSpectrum::configure() {
 
 void LogSpectrum::compute() {
   const vector<Real>& const_spectrum = _spectrum.get();
-  vector<Real> spectrum = const_spectrum;
+  vector<Real>& spectrum = _spectrumCopy;
+  spectrum = const_spectrum;
   vector<Real>& logFreqSpectrum = _logFreqSpectrum.get();
   Real& localTuning = _localTuning.get();
   vector<Real>& meanTuning = _meanTuning.get();
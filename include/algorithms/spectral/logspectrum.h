@@ -73,6 +73,7 @@ class LogSpectrum : public Algorithm {
   std::vector<Real> _kernelValue;
   std::vector<Real> _sinvalues;
   std::vector<Real> _cosvalues;
+  std::vector<Real> _spectrumCopy;
 
   bool logFreqMatrix(Real fs, int frameSize, std::vector<Real> &outmatrix);
   Real cospuls(Real x, Real centre, Real width);
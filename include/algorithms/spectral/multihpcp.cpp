@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+
+#include "multihpcp.h"
+
+using namespace std;
+
+namespace essentia {
+namespace standard {
+
+const char* MultiHPCP::name = "MultiHPCP";
+const char* MultiHPCP::category = "Tonal";
+const char* MultiHPCP::description = DOC("This algorithm computes several Harmonic Pitch Class Profiles with different parameters from the same spectral peaks, eg: the profiles used for the key, for the chords and for the tuning features. It outputs one HPCP per configuration, which is the same as the output of one HPCP algorithm configured with the corresponding parameters.\n"
+"\n"
+"The parameters are the ones of HPCP, each of them being given as a list with one value per configuration. A list with a single value gives the value of all the configurations, and the number of configurations is the size of the longest list: for instance, 'size' = [36, 120] and 'harmonics' = [8] compute a 36-bin and a 120-bin profile, both with 8 harmonics. An exception is thrown if two lists have different sizes greater than one, and in the same cases as HPCP for each configuration.\n"
+"\n"
+"The logarithms of the peak frequencies are only computed once for all the configurations, and as in HPCP the weighting functions are tabulated when the algorithm is configured.");
+
+
+// the value of a parameter for the given configuration, a single value being
+// the one of all the configurations
+template <typename T>
+static T select(const vector<T>& values, int configuration) {
+  return values.size() == 1 ? values[0] : values[configuration];
+}
+
+static void checkSize(const string& name, int size, int& numberConfigurations) {
+  if (size == 0) {
+    throw EssentiaException("MultiHPCP: parameter '", name, "' is empty");
+  }
+  if (size == 1) return;
+  if (numberConfigurations > 1 && size != numberConfigurations) {
+    throw EssentiaException("MultiHPCP: parameter '", name, "' does not have as many values as the other ones");
+  }
+  numberConfigurations = size;
+}
+
+void MultiHPCP::configure() {
+  vector<int> sizes = parameter("size").toVectorInt();
+  vector<Real> referenceFrequencies = parameter("referenceFrequency").toVectorReal();
+  vector<int> harmonics = parameter("harmonics").toVectorInt();
+  vector<bool> bandPresets = parameter("bandPreset").toVectorBool();
+  vector<Real> splitFrequencies = parameter("bandSplitFrequency").toVectorReal();
+  vector<Real> minFrequencies = parameter("minFrequency").toVectorReal();
+  vector<Real> maxFrequencies = parameter("maxFrequency").toVectorReal();
+  vector<string> weightTypes = parameter("weightType").toVectorString();
+  vector<bool> nonLinear = parameter("nonLinear").toVectorBool();
+  vector<Real> windowSizes = parameter("windowSize").toVectorReal();
+  vector<bool> maxShifted = parameter("maxShifted").toVectorBool();
+  vector<string> normalized = parameter("normalized").toVectorString();
+
+  int numberConfigurations = 1;
+  checkSize("size", sizes.size(), numberConfigurations);
+  checkSize("referenceFrequency", referenceFrequencies.size(), numberConfigurations);
+  checkSize("harmonics", harmonics.size(), numberConfigurations);
+  checkSize("bandPreset", bandPresets.size(), numberConfigurations);
+  checkSize("bandSplitFrequency", splitFrequencies.size(), numberConfigurations);
+  checkSize("minFrequency", minFrequencies.size(), numberConfigurations);
+  checkSize("maxFrequency", maxFrequencies.size(), numberConfigurations);
+  checkSize("weightType", weightTypes.size(), numberConfigurations);
+  checkSize("nonLinear", nonLinear.size(), numberConfigurations);
+  checkSize("windowSize", windowSizes.size(), numberConfigurations);
+  checkSize("maxShifted", maxShifted.size(), numberConfigurations);
+  checkSize("normalized", normalized.size(), numberConfigurations);
+
+  _engines.resize(numberConfigurations);
+  for (int i=0; i<numberConfigurations; ++i) {
+    ParameterMap configuration;
+    configuration.add("size", select(sizes, i));
+    configuration.add("referenceFrequency", select(referenceFrequencies, i));
+    configuration.add("harmonics", select(harmonics, i));
+    configuration.add("bandPreset", select(bandPresets, i));
+    configuration.add("bandSplitFrequency", select(splitFrequencies, i));
+    configuration.add("minFrequency", select(minFrequencies, i));
+    configuration.add("maxFrequency", select(maxFrequencies, i));
+    configuration.add("weightType", select(weightTypes, i));
+    configuration.add("nonLinear", select(nonLinear, i));
+    configuration.add("windowSize", select(windowSizes, i));
+    configuration.add("maxShifted", select(maxShifted, i));
+    configuration.add("normalized", select(normalized, i));
+    _engines[i].configure(configuration);
+  }
+  _octaves.reserve(HPCPEngine::reservedPeaks);
+}
+
+void MultiHPCP::compute() {
+  const vector<Real>& frequencies = _frequencies.get();
+  const vector<Real>& magnitudes = _magnitudes.get();
+  vector<vector<Real> >& hpcps = _hpcps.get();
+
+  HPCPEngine::computeOctaves(frequencies, _octaves);
+
+  hpcps.resize(_engines.size());
+  for (int i=0; i<(int)_engines.size(); ++i) {
+    _engines[i].compute(frequencies, _octaves, magnitudes, hpcps[i]);
+  }
+}
+
+} // namespace standard
+} // namespace essentia
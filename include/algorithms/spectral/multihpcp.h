@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+
+#ifndef ESSENTIA_MULTIHPCP_H
+#define ESSENTIA_MULTIHPCP_H
+
+#include "algorithm.h"
+#include "hpcpengine.h"
+
+namespace essentia {
+namespace standard {
+
+class MultiHPCP : public Algorithm {
+
+ protected:
+  Input<std::vector<Real> > _frequencies;
+  Input<std::vector<Real> > _magnitudes;
+  Output<std::vector<std::vector<Real> > > _hpcps;
+
+  std::vector<HPCPEngine> _engines;
+  std::vector<double> _octaves;
+
+ public:
+  MultiHPCP() {
+    declareInput(_frequencies, "frequencies", "the frequencies of the spectral peaks [Hz]");
+    declareInput(_magnitudes, "magnitudes", "the magnitudes of the spectral peaks");
+    declareOutput(_hpcps, "hpcps", "the resulting harmonic pitch class profiles, one per configuration");
+  }
+
+  // ranges only apply to single values: the ones of HPCP are checked for
+  // each configuration by HPCPEngine::configure()
+  void declareParameters() {
+    declareParameter("size", "the size of the output HPCPs (positive nonzero multiples of 12)", "", std::vector<int>(1, 12));
+    declareParameter("referenceFrequency", "the reference frequencies, positive, for semitone index calculation, corresponding to A3 [Hz]", "", std::vector<Real>(1, 440.0));
+    declareParameter("harmonics", "numbers of harmonics (positive or zero) for frequency contribution, 0 indicates exclusive fundamental frequency contribution", "", std::vector<int>(1, 0));
+    declareParameter("bandPreset", "whether to use a band preset", "", std::vector<bool>(1, true));
+    declareParameter("bandSplitFrequency", "the split frequencies, positive, for low and high bands, not used if bandPreset is false [Hz]", "", std::vector<Real>(1, 500.0));
+    declareParameter("minFrequency", "the minimum frequencies, positive, that contribute to the HPCPs [Hz]", "", std::vector<Real>(1, 40.0));
+    declareParameter("maxFrequency", "the maximum frequencies, positive, that contribute to the HPCPs [Hz]", "", std::vector<Real>(1, 5000.0));
+    declareParameter("weightType", "types of weighting function for determining frequency contribution, among {none,cosine,squaredCosine}", "", std::vector<std::string>(1, "squaredCosine"));
+    declareParameter("nonLinear", "whether to apply non-linear post-processing to the outputs (use with normalized='unitMax')", "", std::vector<bool>(1, false));
+    declareParameter("windowSize", "the sizes, in semitones, of the windows used for the weighting, in (0,12]", "", std::vector<Real>(1, 1.0));
+    declareParameter("maxShifted", "whether to shift the HPCP vectors so that their maximum peak is at index 0", "", std::vector<bool>(1, false));
+    declareParameter("normalized", "whether to normalize the HPCP vectors, among {none,unitSum,unitMax}", "", std::vector<std::string>(1, "unitMax"));
+  }
+
+  void configure();
+  void compute();
+
+  static const char* name;
+  static const char* category;
+  static const char* description;
+};
+
+} // namespace standard
+} // namespace essentia
+
+#include "streamingalgorithmwrapper.h"
+
+namespace essentia {
+namespace streaming {
+
+class MultiHPCP : public StreamingAlgorithmWrapper {
+
+ protected:
+  Sink<std::vector<Real> > _frequencies;
+  Sink<std::vector<Real> > _magnitudes;
+  Source<std::vector<std::vector<Real> > > _hpcps;
+
+ public:
+  MultiHPCP() {
+    declareAlgorithm("MultiHPCP");
+    declareInput(_frequencies, TOKEN, "frequencies");
+    declareInput(_magnitudes, TOKEN, "magnitudes");
+    declareOutput(_hpcps, TOKEN, "hpcps");
+  }
+};
+
+} // namespace streaming
+} // namespace essentia
+
+#endif // ESSENTIA_MULTIHPCP_H
@@ -83,7 +83,8 @@ void SpectralContrast::configure() {
 }
 
 void SpectralContrast::compute() {
-  vector<Real> spectrum = _spectrum.get(); // I want a copy because I'll be transforming it
+  vector<Real>& spectrum = _spectrumCopy;
+  spectrum = _spectrum.get(); // I want a copy because I'll be transforming it
   if (int(spectrum.size()) != _frameSize/2 + 1) {
     ostringstream msg;
     msg << "SpectralContrast: the size of the input spectrum should be half the frameSize parameter + 1. Current spectrum size is: " << spectrum.size() << " while frameSize is " << _frameSize;
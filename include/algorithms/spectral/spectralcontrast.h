@@ -32,6 +32,7 @@ protected:
   Output<std::vector<Real> >  _spectralcontrast;
   Output<std::vector<Real> >  _valleys;
   std::vector<int>            _numberOfBinsInBands;
+  std::vector<Real>           _spectrumCopy;
   Real                        _neighbourRatio;
   int                         _startAtBin;
   int                         _frameSize;
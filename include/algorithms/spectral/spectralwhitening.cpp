@@ -55,7 +55,14 @@ void SpectralWhitening::compute() {
   }
 
   const int nPeaks = magnitudes.size();
-  vector<Real> magnitudesdB(nPeaks, 0.0);
+  int specSize = spectrum.size();
+
+  // there are fewer peaks than bins in the spectrum: reserving for them
+  // avoids any allocation after the first frame
+  vector<Real>& magnitudesdB = _magnitudesdB;
+  magnitudesdB.reserve(specSize);
+  magnitudesdB.assign(nPeaks, 0.0);
+  magnitudesWhite.reserve(specSize);
   magnitudesWhite.resize(nPeaks);
 
   // If there are no magnitudes to whiten, do nothing
@@ -77,11 +84,12 @@ void SpectralWhitening::compute() {
   }
 
   // compute envelope
-  vector<Real> xPointsNoiseBPF;
-  vector<Real> yPointsNoiseBPF;
+  vector<Real>& xPointsNoiseBPF = _xPointsNoiseBPF;
+  vector<Real>& yPointsNoiseBPF = _yPointsNoiseBPF;
+  xPointsNoiseBPF.clear();
+  yPointsNoiseBPF.clear();
 
   Real incr = bpfResolution;
-  int specSize = spectrum.size();
   // reserve some meaningful space, i.e. size of sepctrum
   xPointsNoiseBPF.reserve(specSize);
   yPointsNoiseBPF.reserve(specSize);
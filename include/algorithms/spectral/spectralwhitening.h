@@ -39,6 +39,11 @@ class SpectralWhitening : public Algorithm {
 
   essentia::util::BPF _noiseBPF;
 
+  // scratch space of compute()
+  std::vector<Real> _magnitudesdB;
+  std::vector<Real> _xPointsNoiseBPF;
+  std::vector<Real> _yPointsNoiseBPF;
+
  public:
   SpectralWhitening() {
     declareInput(_spectrum, "spectrum", "the audio linear spectrum");
@@ -51,7 +51,8 @@ void TriangularBands::configure() {
   }
 
   _isLog = parameter("log").toBool();
-  setWeightingFunctions(parameter("weighting").toString());
+  _weighting = parameter("weighting").toString();
+  setWeightingFunctions(_weighting);
   createFilters(_inputSize);
 }
 
@@ -64,40 +65,33 @@ void TriangularBands::compute() {
     throw EssentiaException("TriangularBands: the size of the input spectrum is not greater than one");
   }
 
-  if (_filterCoefficients.empty() || _filterCoefficients[0].size() != spectrum.size()) {
-      E_INFO("TriangularBands: input spectrum size (" << spectrum.size() << ") does not correspond to the \"inputSize\" parameter (" << _filterCoefficients[0].size() << "). Recomputing the filter bank.");
+  if (_filterbank->spectrumSize() != (int)spectrum.size()) {
+      E_INFO("TriangularBands: input spectrum size (" << spectrum.size() << ") does not correspond to the \"inputSize\" parameter (" << _filterbank->spectrumSize() << "). Recomputing the filter bank.");
     createFilters(spectrum.size());
   }
 
-  Real frequencyScale = (_sampleRate / 2.0) / (spectrum.size() - 1);
-
-  bands.resize(_nBands);
-  fill(bands.begin(), bands.end(), (Real) 0.0);
-
-  for (int i=0; i<_nBands; ++i) {
-
-    // Find margins for FFT bins to iterate through
-    // (all bins fall inside the triangle and therefore have non-zero weights).
-    int jbegin = ceil(_bandFrequencies[i] / frequencyScale);
-    int jend = floor(_bandFrequencies[i+2] / frequencyScale);
-
-    for (int j=jbegin; j<=jend; ++j) {
-
-      if (_type == "power") {
-        bands[i] += (spectrum[j] * spectrum[j]) * _filterCoefficients[i][j];
-      }
-
-      if (_type == "magnitude") {
-        bands[i] += (spectrum[j]) * _filterCoefficients[i][j];
-      }
+  _filterbank->compute(spectrum, bands, _type == "power" ? Filterbank::POWER : Filterbank::MAGNITUDE);
 
+  if (_isLog) {
+    for (int i=0; i<_nBands; ++i) {
+      bands[i] = log2(1 + bands[i]);
     }
-    if (_isLog) bands[i] = log2(1 + bands[i]);
   }
-  
 }
 
 void TriangularBands::createFilters(int spectrumSize) {
+  Filterbank::Key key;
+  key.shape = "triangular/" + _weighting + "/" + _normalize;
+  key.spectrumSize = spectrumSize;
+  key.sampleRate = _sampleRate;
+  key.parameters = _bandFrequencies;
+
+  _filterbank = Filterbank::get(key, [this, spectrumSize](vector<vector<Real> >& weights) {
+    createWeights(spectrumSize, weights);
+  });
+}
+
+void TriangularBands::createWeights(int spectrumSize, vector<vector<Real> >& weights) {
   /*
   Calculate the filter coefficients...
   Basically what we're doing here is the following. Every filter is
@@ -120,7 +114,7 @@ void TriangularBands::createFilters(int spectrumSize) {
     throw EssentiaException("TriangularBands: Filter bank cannot be computed from a spectrum with less than 2 bins");
   }
 
-  _filterCoefficients = vector<vector<Real> >(_nBands, vector<Real>(spectrumSize, 0.0));
+  weights.assign(_nBands, vector<Real>(spectrumSize, 0.0));
 
   Real frequencyScale = (_sampleRate / 2.0) / (spectrumSize - 1);
 
@@ -142,13 +136,13 @@ void TriangularBands::createFilters(int spectrumSize) {
       Real binfreq = j*frequencyScale;
       // in the ascending part of the triangle...
       if (binfreq < _bandFrequencies[i+1]) {
-        _filterCoefficients[i][j] = ((*_weighter)(binfreq) - (*_weighter)(_bandFrequencies[i])) / fstep1;
+        weights[i][j] = ((*_weighter)(binfreq) - (*_weighter)(_bandFrequencies[i])) / fstep1;
       }
       // in the descending part of the triangle...
       else if (binfreq >= _bandFrequencies[i+1]) {
-        _filterCoefficients[i][j] = ((*_weighter)(_bandFrequencies[i+2]) - (*_weighter)(binfreq)) / fstep2;
+        weights[i][j] = ((*_weighter)(_bandFrequencies[i+2]) - (*_weighter)(binfreq)) / fstep2;
       }
-      weight += _filterCoefficients[i][j];
+      weight += weights[i][j];
     }
 
     if (!weight) {
@@ -164,7 +158,7 @@ void TriangularBands::createFilters(int spectrumSize) {
 
     if (_normalize == "unit_sum" || _normalize == "unit_tri") {
       for (int j=jbegin; j<=jend; ++j) {
-        _filterCoefficients[i][j] = _filterCoefficients[i][j] / weight;
+        weights[i][j] = weights[i][j] / weight;
       }
     }
   }
@@ -22,6 +22,7 @@
 
 #include "algorithm.h"
 #include "essentiautil.h"
+#include "filterbank.h"
 
 using namespace std;
 
@@ -39,11 +40,13 @@ class TriangularBands : public Algorithm {
   int _nBands;
   Real _sampleRate;
   bool _isLog;
-  std::vector<std::vector<Real> > _filterCoefficients;
+  std::shared_ptr<const Filterbank> _filterbank;
   Real _inputSize;
   std::string _normalize;
   std::string _type;
+  std::string _weighting;
   void createFilters(int spectrumSize);
+  void createWeights(int spectrumSize, std::vector<std::vector<Real> >& weights);
   void setWeightingFunctions(std::string weighting);
 
   typedef  Real (*funcPointer)(Real);
@@ -18,7 +18,10 @@
  */
 
 #include "fftw.h"
+#include "fftwplancache.h"
 #include "essentia.h"
+#include <map>
+#include <atomic>
 
 using namespace std;
 using namespace essentia;
@@ -38,17 +41,9 @@ const char* FFTW::description = DOC("This algorithm computes the positive comple
 ForcedMutex FFTW::globalFFTWMutex;
 
 FFTW::~FFTW() {
-  ForcedMutexLocker lock(globalFFTWMutex);
-
-  // we might have called essentia::shutdown() before this algorithm goes out
-  // of scope, so make sure we're not doing stupid things here
-  // This will cause a memory leak then, but it is definitely a better choice
-  // than a crash (right, right??? :-) )
-  if (essentia::isInitialized()) {
-    fftwf_destroy_plan(_fftPlan);
-    fftwf_free(_input);
-    fftwf_free(_output);
-  }
+  // the plan belongs to the FFTWPlanCache, only the arrays are ours
+  fftwf_free(_input);
+  fftwf_free(_output);
 }
 
 void FFTW::compute() {
@@ -71,7 +66,7 @@ void FFTW::compute() {
   memcpy(_input, &signal[0], size*sizeof(Real));
 
   // calculate the fft
-  fftwf_execute(_fftPlan);
+  fftwf_execute_dft_r2c(_fftPlan, _input, (fftwf_complex*)_output);
 
   // copy result from plan to output vector
   fft.resize(size/2+1);
@@ -84,8 +79,6 @@ void FFTW::configure() {
 }
 
 void FFTW::createFFTObject(int size) {
-  ForcedMutexLocker lock(globalFFTWMutex);
-
   // This is only needed because at the moment we return half of the spectrum,
   // which means that there are 2 different input signals that could yield the
   // same FFT...
@@ -94,15 +87,159 @@ void FFTW::createFFTObject(int size) {
   }
 
   // create the temporary storage array
-  fftwf_free(_input);
-  fftwf_free(_output);
-  _input = (Real*)fftwf_malloc(sizeof(Real)*size);
-  _output = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
-
-  if (_fftPlan != 0) {
-    fftwf_destroy_plan(_fftPlan);
+  if (_input == 0 || _fftPlanSize != size) {
+    fftwf_free(_input);
+    fftwf_free(_output);
+    _input = (Real*)fftwf_malloc(sizeof(Real)*size);
+    _output = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
   }
 
-  _fftPlan = fftwf_plan_dft_r2c_1d(size, _input, (fftwf_complex*)_output, FFTW_ESTIMATE);
+  _fftPlan = FFTWPlanCache::plan(FFTWPlanCache::REAL_FORWARD, size,
+                                 fftwf_alignment_of(_input),
+                                 fftwf_alignment_of((Real*)_output));
   _fftPlanSize = size;
 }
+
+
+namespace essentia {
+namespace standard {
+
+struct FFTWPlanKey {
+  int transform;
+  int size;
+  int inputAlignment;
+  int outputAlignment;
+
+  bool operator<(const FFTWPlanKey& other) const {
+    if (transform != other.transform) return transform < other.transform;
+    if (size != other.size) return size < other.size;
+    if (inputAlignment != other.inputAlignment) return inputAlignment < other.inputAlignment;
+    return outputAlignment < other.outputAlignment;
+  }
+};
+
+typedef std::map<FFTWPlanKey, fftwf_plan> FFTWPlanMap;
+
+// all the plans created so far, guarded by FFTW::globalFFTWMutex
+static FFTWPlanMap sharedPlans;
+static bool wisdomImported = false;
+static bool measurePlans = false;
+
+// incremented by FFTWPlanCache::clear(), so that the threads know that the
+// plans they kept for themselves are not valid anymore
+static std::atomic<unsigned int> planGeneration(0);
+
+// the plans already looked up by the current thread, which can be used
+// without taking the lock
+struct FFTWLocalPlans {
+  unsigned int generation;
+  FFTWPlanMap plans;
+  FFTWLocalPlans() : generation(0) {}
+};
+
+static thread_local FFTWLocalPlans localPlans;
+
+
+static fftwf_plan createPlan(const FFTWPlanKey& key, Real* input, Real* output, unsigned int flags) {
+  switch (key.transform) {
+    case FFTWPlanCache::REAL_FORWARD:
+      return fftwf_plan_dft_r2c_1d(key.size, input, (fftwf_complex*)output, flags);
+    case FFTWPlanCache::REAL_BACKWARD:
+      return fftwf_plan_dft_c2r_1d(key.size, (fftwf_complex*)input, output, flags);
+    case FFTWPlanCache::COMPLEX_FORWARD:
+      return fftwf_plan_dft_1d(key.size, (fftwf_complex*)input, (fftwf_complex*)output, FFTW_FORWARD, flags);
+    case FFTWPlanCache::COMPLEX_BACKWARD:
+      return fftwf_plan_dft_1d(key.size, (fftwf_complex*)input, (fftwf_complex*)output, FFTW_BACKWARD, flags);
+  }
+  return 0;
+}
+
+// needs to be called with FFTW::globalFFTWMutex locked
+static fftwf_plan createPlan(const FFTWPlanKey& key) {
+  // the planner may overwrite the arrays when measuring, so plan on scratch
+  // arrays which have the same alignment as those of the algorithm. FFTW
+  // never requires more than 64 bytes of alignment.
+  const int maxAlignment = 64;
+  size_t bytes = sizeof(complex<Real>)*key.size;
+  char* inputMemory = (char*)fftwf_malloc(bytes + maxAlignment);
+  char* outputMemory = (char*)fftwf_malloc(bytes + maxAlignment);
+  Real* input = (Real*)(inputMemory + key.inputAlignment);
+  Real* output = (Real*)(outputMemory + key.outputAlignment);
+
+  fftwf_plan plan = 0;
+  if (measurePlans) {
+    plan = createPlan(key, input, output, FFTW_MEASURE);
+  }
+  else {
+    if (wisdomImported) {
+      plan = createPlan(key, input, output, FFTW_MEASURE | FFTW_WISDOM_ONLY);
+    }
+    if (!plan) {
+      plan = createPlan(key, input, output, FFTW_ESTIMATE);
+    }
+  }
+
+  fftwf_free(inputMemory);
+  fftwf_free(outputMemory);
+
+  if (!plan) {
+    throw EssentiaException("FFT: could not create an FFTW plan of size ", key.size);
+  }
+  return plan;
+}
+
+fftwf_plan FFTWPlanCache::plan(Transform transform, int size,
+                               int inputAlignment, int outputAlignment) {
+  FFTWPlanKey key = { transform, size, inputAlignment, outputAlignment };
+
+  if (localPlans.generation == planGeneration) {
+    FFTWPlanMap::const_iterator it = localPlans.plans.find(key);
+    if (it != localPlans.plans.end()) return it->second;
+  }
+
+  ForcedMutexLocker lock(FFTW::globalFFTWMutex);
+
+  if (localPlans.generation != planGeneration) {
+    localPlans.plans.clear();
+    localPlans.generation = planGeneration;
+  }
+
+  FFTWPlanMap::const_iterator it = sharedPlans.find(key);
+  fftwf_plan plan = (it != sharedPlans.end()) ? it->second : 0;
+  if (!plan) {
+    plan = createPlan(key);
+    sharedPlans.insert(make_pair(key, plan));
+  }
+
+  localPlans.plans.insert(make_pair(key, plan));
+  return plan;
+}
+
+bool FFTWPlanCache::importWisdom(const string& filename) {
+  ForcedMutexLocker lock(FFTW::globalFFTWMutex);
+  if (!fftwf_import_wisdom_from_filename(filename.c_str())) return false;
+  wisdomImported = true;
+  return true;
+}
+
+bool FFTWPlanCache::exportWisdom(const string& filename) {
+  ForcedMutexLocker lock(FFTW::globalFFTWMutex);
+  return fftwf_export_wisdom_to_filename(filename.c_str()) != 0;
+}
+
+void FFTWPlanCache::setMeasure(bool measure) {
+  ForcedMutexLocker lock(FFTW::globalFFTWMutex);
+  measurePlans = measure;
+}
+
+void FFTWPlanCache::clear() {
+  ForcedMutexLocker lock(FFTW::globalFFTWMutex);
+  for (FFTWPlanMap::iterator it = sharedPlans.begin(); it != sharedPlans.end(); ++it) {
+    fftwf_destroy_plan(it->second);
+  }
+  sharedPlans.clear();
+  planGeneration++;
+}
+
+} // namespace standard
+} // namespace essentia
@@ -35,7 +35,7 @@ class FFTW : public Algorithm {
   Output<std::vector<std::complex<Real> > > _fft;
 
  public:
-  FFTW() : _fftPlan(0), _input(0), _output(0) {
+  FFTW() : _fftPlan(0), _fftPlanSize(0), _input(0), _output(0) {
     declareInput(_signal, "frame", "the input audio frame");
     declareOutput(_fft, "fft", "the FFT of the input frame");
   }
@@ -54,9 +54,8 @@ class FFTW : public Algorithm {
   static const char* description;
 
  protected:
-  friend class IFFTW;
-  friend class FFTWComplex;
-  friend class IFFTWComplex;
+  friend class FFTWPlanCache;
+  // protects the FFTW planner, which is not thread-safe, and the plan cache
   static ForcedMutex globalFFTWMutex;
 
   fftwf_plan _fftPlan;
@@ -19,6 +19,7 @@
 
 #include "fftwcomplex.h"
 #include "fftw.h"
+#include "fftwplancache.h"
 #include "essentia.h"
 
 using namespace std;
@@ -38,17 +39,9 @@ const char* FFTWComplex::description = DOC("This algorithm computes the complex
 
 
 FFTWComplex::~FFTWComplex() {
-  ForcedMutexLocker lock(FFTW::globalFFTWMutex);
-
-  // we might have called essentia::shutdown() before this algorithm goes out
-  // of scope, so make sure we're not doing stupid things here
-  // This will cause a memory leak then, but it is definitely a better choice
-  // than a crash (right, right??? :-) )
-  if (essentia::isInitialized()) {
-    fftwf_destroy_plan(_fftPlan);
-    fftwf_free(_input);
-    fftwf_free(_output);
-  }
+  // the plan belongs to the FFTWPlanCache, only the arrays are ours
+  fftwf_free(_input);
+  fftwf_free(_output);
 }
 
 void FFTWComplex::compute() {
@@ -71,7 +64,7 @@ void FFTWComplex::compute() {
   memcpy(_input, &signal[0], size*sizeof(complex<Real>));
 
   // calculate the fft
-  fftwf_execute(_fftPlan);
+  fftwf_execute_dft(_fftPlan, (fftwf_complex*)_input, (fftwf_complex*)_output);
 
   // copy result from plan to output vector
   if (_negativeFrequencies){
@@ -90,8 +83,6 @@ void FFTWComplex::configure() {
 }
 
 void FFTWComplex::createFFTObject(int size) {
-  ForcedMutexLocker lock(FFTW::globalFFTWMutex);
-
   // This is only needed because at the moment we return half of the spectrum,
   // which means that there are 2 different input signals that could yield the
   // same FFT...
@@ -100,15 +91,15 @@ void FFTWComplex::createFFTObject(int size) {
   }
 
   // create the temporary storage array
-  fftwf_free(_input);
-  fftwf_free(_output);
-  _input = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
-  _output = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
-
-  if (_fftPlan != 0) {
-    fftwf_destroy_plan(_fftPlan);
+  if (_input == 0 || _fftPlanSize != size) {
+    fftwf_free(_input);
+    fftwf_free(_output);
+    _input = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
+    _output = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
   }
 
-  _fftPlan = fftwf_plan_dft_1d(size, (fftwf_complex*)_input, (fftwf_complex*)_output, FFTW_FORWARD, FFTW_ESTIMATE);
+  _fftPlan = FFTWPlanCache::plan(FFTWPlanCache::COMPLEX_FORWARD, size,
+                                 fftwf_alignment_of((Real*)_input),
+                                 fftwf_alignment_of((Real*)_output));
   _fftPlanSize = size;
 }
@@ -35,7 +35,7 @@ class FFTWComplex : public Algorithm {
   Output<std::vector<std::complex<Real> > > _fft;
 
  public:
-  FFTWComplex() : _fftPlan(0), _input(0), _output(0) {
+  FFTWComplex() : _fftPlan(0), _fftPlanSize(0), _input(0), _output(0) {
     declareInput(_signal, "frame", "the input frame (complex)");
     declareOutput(_fft, "fft", "the FFT of the input frame");
   }
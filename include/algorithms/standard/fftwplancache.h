@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_FFTWPLANCACHE_H
+#define ESSENTIA_FFTWPLANCACHE_H
+
+#include <string>
+
+// opaque FFTW plan type, so that this header can be used without fftw3.h
+struct fftwf_plan_s;
+
+namespace essentia {
+namespace standard {
+
+/**
+ * Process-wide cache of the FFTW plans used by the FFT, IFFT, FFTC and IFFTC
+ * algorithms.
+ *
+ * Plans are keyed by transform, size and alignment of the arrays they will be
+ * executed on, and are created only once for the whole process on scratch
+ * arrays owned by the cache. The algorithms then execute them on their own
+ * arrays with the new-array execute functions of FFTW, which are thread-safe,
+ * so that any number of FFT instances living in different threads can share
+ * the same plan.
+ *
+ * Each thread keeps its own copy of the plans it already looked up, so that
+ * configuring an FFT only needs to take the global FFTW lock the first time a
+ * thread sees a given size. The plans themselves are only destroyed by
+ * clear().
+ *
+ * When some wisdom has been imported, plans are first looked up in it with
+ * FFTW_MEASURE, otherwise they are created with FFTW_ESTIMATE, unless
+ * setMeasure(true) has been called, in which case sizes which are not in the
+ * wisdom yet are measured (which takes some time for the first plan of each
+ * size, but then ends up in the wisdom which can be exported).
+ */
+class FFTWPlanCache {
+ public:
+  enum Transform {
+    REAL_FORWARD,     // r2c, used by FFT
+    REAL_BACKWARD,    // c2r, used by IFFT
+    COMPLEX_FORWARD,  // used by FFTC
+    COMPLEX_BACKWARD  // used by IFFTC
+  };
+
+  /**
+   * Returns the plan for the given transform and size, suitable for arrays
+   * which have the given alignment (as returned by fftwf_alignment_of()).
+   * The plan belongs to the cache and must not be destroyed.
+   */
+  static fftwf_plan_s* plan(Transform transform, int size,
+                            int inputAlignment, int outputAlignment);
+
+  /**
+   * Imports the FFTW wisdom stored in the given file. Returns false if it
+   * could not be read.
+   */
+  static bool importWisdom(const std::string& filename);
+
+  /**
+   * Exports the FFTW wisdom accumulated so far to the given file. Returns
+   * false if it could not be written.
+   */
+  static bool exportWisdom(const std::string& filename);
+
+  /**
+   * Whether plans for sizes which are not in the wisdom should be measured
+   * instead of estimated. Defaults to false.
+   */
+  static void setMeasure(bool measure);
+
+  /**
+   * Destroys all the cached plans. No FFT algorithm should be alive, nor be
+   * computing in another thread, when calling this.
+   */
+  static void clear();
+};
+
+} // namespace standard
+} // namespace essentia
+
+#endif // ESSENTIA_FFTWPLANCACHE_H
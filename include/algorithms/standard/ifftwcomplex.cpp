@@ -19,6 +19,7 @@
 
 #include "ifftwcomplex.h"
 #include "fftw.h"
+#include "fftwplancache.h"
 
 using namespace std;
 using namespace essentia;
@@ -38,9 +39,7 @@ const char* IFFTWComplex::description = DOC("This algorithm calculates the inver
 
 
 IFFTWComplex::~IFFTWComplex() {
-  ForcedMutexLocker lock(FFTW::globalFFTWMutex);
-
-  fftwf_destroy_plan(_fftPlan);
+  // the plan belongs to the FFTWPlanCache, only the arrays are ours
   fftwf_free(_input);
   fftwf_free(_output);
 }
@@ -64,7 +63,7 @@ void IFFTWComplex::compute() {
   memcpy(_input, &fft[0], size*sizeof(complex<Real>));
 
   // calculate the fft
-  fftwf_execute(_fftPlan);
+  fftwf_execute_dft(_fftPlan, (fftwf_complex*)_input, (fftwf_complex*)_output);
 
   // copy result from plan to output vector
   signal.resize(size);
@@ -85,20 +84,17 @@ void IFFTWComplex::configure() {
 }
 
 void IFFTWComplex::createFFTObject(int size) {
-  ForcedMutexLocker lock(FFTW::globalFFTWMutex);
-
   // create the temporary storage array
-  fftwf_free(_input);
-  fftwf_free(_output);
-  _input = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
-  _output = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
-
-  if (_fftPlan != 0) {
-    fftwf_destroy_plan(_fftPlan);
+  if (_input == 0 || _fftPlanSize != size) {
+    fftwf_free(_input);
+    fftwf_free(_output);
+    _input = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
+    _output = (complex<Real>*)fftwf_malloc(sizeof(complex<Real>)*size);
   }
 
-  //_fftPlan = fftwf_plan_dft_c2r_1d(size, (fftwf_complex*)_input, _output, FFTW_MEASURE);
-  _fftPlan = fftwf_plan_dft_1d(size, (fftwf_complex*)_input, (fftwf_complex*)_output, FFTW_BACKWARD, FFTW_ESTIMATE);
+  _fftPlan = FFTWPlanCache::plan(FFTWPlanCache::COMPLEX_BACKWARD, size,
+                                 fftwf_alignment_of((Real*)_input),
+                                 fftwf_alignment_of((Real*)_output));
   _fftPlanSize = size;
 
 }
@@ -36,7 +36,7 @@ class IFFTWComplex : public Algorithm {
 
  public:
 
-  IFFTWComplex() : _fftPlan(0), _input(0), _output(0) {
+  IFFTWComplex() : _fftPlan(0), _fftPlanSize(0), _input(0), _output(0) {
     declareInput(_fft, "fft", "the input frame");
     declareOutput(_signal, "frame", "the complex IFFT of the input frame");
   }
@@ -74,7 +74,10 @@ void PeakDetection::compute() {
   // which makes more sense in general?
   const Real scale = _range / (Real)(size - 1);
 
-  std::vector<Peak> peaks;
+  // scratch space kept from a call to the next, so that there is no
+  // allocation once the largest array has been seen
+  std::vector<Peak>& peaks = _peaks;
+  peaks.clear();
   peaks.reserve(size);
 
   // we want to round up to the next integer instead of simple truncation,
@@ -170,7 +173,8 @@ void PeakDetection::compute() {
   // remove peaks that are closer than 'minPeakDistance'
   if (_minPeakDistance > 0 && peaks.size() > 1) {
     
-    std::vector<int> deletedPeaks;
+    std::vector<int>& deletedPeaks = _deletedPeaks;
+    deletedPeaks.clear();
     deletedPeaks.reserve(peaks.size());
     Real minPos;
     Real maxPos;
@@ -196,7 +200,6 @@ void PeakDetection::compute() {
         peaks.erase(peaks.begin() + deletedPeaks[l]);
         
       deletedPeaks.clear();
-      deletedPeaks.reserve(peaks.size());
       k++;
     }
 
@@ -234,6 +237,12 @@ void PeakDetection::compute() {
   // we only want this many peaks
   size_t nWantedPeaks = std::min((size_t)_maxPeaks, peaks.size());
 
+  // there cannot be more peaks than the array has elements, and reserving
+  // for them keeps the outputs from growing again on the next frames
+  size_t nMaxPeaks = std::min((size_t)_maxPeaks, (size_t)size);
+  peakPosition.reserve(nMaxPeaks);
+  peakValue.reserve(nMaxPeaks);
+
   peakPosition.resize(nWantedPeaks);
   peakValue.resize(nWantedPeaks);
 
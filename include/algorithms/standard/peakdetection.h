@@ -21,6 +21,7 @@
 #define ESSENTIA_PEAKDETECTION_H
 
 #include "algorithm.h"
+#include "peak.h"
 
 namespace essentia {
 namespace standard {
@@ -41,6 +42,9 @@ class PeakDetection : public Algorithm {
   std::string _orderBy;
   Real _minPeakDistance;
 
+  std::vector<util::Peak> _peaks;
+  std::vector<int> _deletedPeaks;
+
  public:
   PeakDetection() {
     declareInput(_array, "array", "the input array");
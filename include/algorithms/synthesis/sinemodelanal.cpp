@@ -51,7 +51,8 @@ bool SineModelAnal::comparator_down ( const mypair& l, const mypair& r)
 void SineModelAnal::sort_indexes(std::vector<int> &idx, const std::vector<Real> &v, bool ascending) {
 
   // initialize original index locations
-  std::vector<mypair> pairs(v.size());
+  std::vector<mypair>& pairs = _pairs;
+  pairs.resize(v.size());
   for (int i = 0; i != (int)pairs.size(); ++i){
     pairs[i].first = i;
     pairs[i].second = v[i];
@@ -64,30 +65,34 @@ void SineModelAnal::sort_indexes(std::vector<int> &idx, const std::vector<Real>
     sort(pairs.begin(), pairs.end(),comparator_down);
 
   // copy sorted indexes
+  idx.clear();
   for (int i = 0; i != (int)pairs.size(); ++i) idx.push_back(pairs[i].first);
 
   return;
 }
 
-void SineModelAnal::copy_vector_from_indexes(std::vector<Real> &out, const std::vector<Real> v, const std::vector<int> idx){
+void SineModelAnal::copy_vector_from_indexes(std::vector<Real> &out, const std::vector<Real>& v, const std::vector<int>& idx){
 
+  out.clear();
   for (int i = 0; i < (int)idx.size(); ++i){
     out.push_back(v[idx[i]]);
   }
   return;
 }
 
-void SineModelAnal::copy_int_vector_from_indexes(std::vector<int> &out, const std::vector<int> v, const std::vector<int> idx){
+void SineModelAnal::copy_int_vector_from_indexes(std::vector<int> &out, const std::vector<int>& v, const std::vector<int>& idx){
 
+  out.clear();
   for (int i = 0; i < (int)idx.size(); ++i){
     out.push_back(v[idx[i]]);
   }
   return;
 }
 
-// erase elements from a vector given a vector of indexes
-void SineModelAnal::erase_vector_from_indexes(std::vector<Real> &v, const std::vector<int> idx){
-  std::vector<Real> tmp;
+// erase elements from a vector given a vector of indexes, keeping the
+// remaining ones in order
+void SineModelAnal::erase_vector_from_indexes(std::vector<Real> &v, const std::vector<int>& idx){
+  int kept = 0;
   bool found;
   for (int i = 0; i < (int)v.size(); ++i) {
     found = false;
@@ -96,11 +101,11 @@ void SineModelAnal::erase_vector_from_indexes(std::vector<Real> &v, const std::v
         found = true;
     }
     if (!found) {
-      tmp.push_back(v[i]);
+      v[kept++] = v[i];
     }
   }
 
-  v = tmp;
+  v.resize(kept);
   return;
 }
 
@@ -124,6 +129,23 @@ void SineModelAnal::configure() {
 
   Real maxFrequency  = std::min(float(parameter("sampleRate").toReal()/2.0), float(parameter("maxFrequency").toReal()));
 
+  _sampleRate = parameter("sampleRate").toReal();
+  _freqDevOffset = parameter("freqDevOffset").toReal();
+  _freqDevSlope = parameter("freqDevSlope").toReal();
+  _maxSines = int(parameter("maxnSines").toReal());
+  _maxPeaks = parameter("maxPeaks").toInt();
+
+  // there are at most maxPeaks peaks per frame and maxnSines tracks coming
+  // from the previous frame
+  _pairs.reserve(_maxPeaks);
+  _magOrder.reserve(_maxPeaks);
+  _peaksleft.reserve(_maxPeaks);
+  _incomingTracks.reserve(_maxSines);
+  _newTracks.reserve(_maxSines);
+  _indext.reserve(_maxSines);
+  _indexp.reserve(_maxSines);
+  _emptyt.reserve(_maxSines);
+
   _peakDetect->configure("interpolate", true,
                          "range", parameter("sampleRate").toReal()/2.0,
                          "maxPeaks", parameter("maxPeaks"),
@@ -145,15 +167,14 @@ void SineModelAnal::compute() {
   std::vector<Real>& tpeakFrequency = _frequencies.get();
   std::vector<Real>& tpeakPhase = _phases.get();
 
-  // temp arrays
-  std::vector<Real> peakMagnitude;
-  std::vector<Real> peakFrequency;
-  std::vector<Real> peakPhase;
-
+  // temp arrays, kept from a frame to the next
+  std::vector<Real>& peakMagnitude = _peakMagnitude;
+  std::vector<Real>& peakFrequency = _peakFrequency;
+  std::vector<Real>& peakPhase = _peakPhase;
 
-  std::vector<Real> fftmag;
-  std::vector<Real> fftmagdB;
-  std::vector<Real> fftphase;
+  std::vector<Real>& fftmag = _fftmag;
+  std::vector<Real>& fftmagdB = _fftmagdB;
+  std::vector<Real>& fftphase = _fftphase;
 
   _cartesianToPolar->input("complex").set(fft);
   _cartesianToPolar->output("magnitude").set(fftmag);
@@ -166,6 +187,7 @@ void SineModelAnal::compute() {
   _cartesianToPolar->compute();
 
   // convert to dB
+    fftmagdB.clear();
     for (int i=0; i < (int)fftmag.size(); ++i){
       fftmagdB.push_back(20.f * std::log10(fftmag[i] + 1e-10));
     }
@@ -175,12 +197,18 @@ void SineModelAnal::compute() {
   phaseInterpolation(fftphase, peakFrequency, peakPhase);
 
   // tracking
-  sinusoidalTracking(peakMagnitude, peakFrequency, peakPhase, _lasttpeakFrequency, parameter("freqDevOffset").toReal(), parameter("freqDevSlope").toReal(), tpeakMagnitude, tpeakFrequency, tpeakPhase);
+  // the tracks of the previous frame and the peaks left over, at most: the
+  // outputs do not need to grow again after the first frame
+  tpeakFrequency.reserve(_maxSines + _maxPeaks);
+  tpeakMagnitude.reserve(_maxSines + _maxPeaks);
+  tpeakPhase.reserve(_maxSines + _maxPeaks);
+
+  sinusoidalTracking(peakMagnitude, peakFrequency, peakPhase, _lasttpeakFrequency, _freqDevOffset, _freqDevSlope, tpeakMagnitude, tpeakFrequency, tpeakPhase);
 
 
 
   // limit number of tracks to maxnSines
-  int maxSines = int ( parameter("maxnSines").toReal() );
+  int maxSines = _maxSines;
 
   tpeakFrequency.resize(maxSines);
   tpeakMagnitude.resize(maxSines);
@@ -195,7 +223,7 @@ void SineModelAnal::compute() {
 // ---------------------------
 // additional methods
 
-void SineModelAnal::sinusoidalTracking(std::vector<Real>& peakMags, std::vector<Real>& peakFrequencies, std::vector<Real>& peakPhases, const std::vector<Real> tfreq, Real freqDevOffset, Real freqDevSlope, std::vector<Real> &tmagn, std::vector<Real> &tfreqn, std::vector<Real> &tphasen ){
+void SineModelAnal::sinusoidalTracking(std::vector<Real>& peakMags, std::vector<Real>& peakFrequencies, std::vector<Real>& peakPhases, const std::vector<Real>& tfreq, Real freqDevOffset, Real freqDevSlope, std::vector<Real> &tmagn, std::vector<Real> &tfreqn, std::vector<Real> &tphasen ){
 
   //	pfreq, pmag, pphase: frequencies and magnitude of current frame
   //	tfreq: frequencies of incoming tracks from previous frame
@@ -214,19 +242,16 @@ void SineModelAnal::sinusoidalTracking(std::vector<Real>& peakMags, std::vector<
   tphasen.resize (tfreq.size());
   std::fill(tphasen.begin(), tphasen.end(), 0.);
 
-  //	pindexes = np.array(np.nonzero(pfreq), dtype=np.int)[0]    # indexes of current peaks
-  std::vector<int> pindexes;
-  for (int i=0;i < (int)peakFrequencies.size(); ++i){  if (peakFrequencies[i] > 0) pindexes.push_back(i); }
-
   //	incomingTracks = np.array(np.nonzero(tfreq), dtype=np.int)[0] # indexes of incoming tracks
-  std::vector<Real> incomingTracks ;
+  std::vector<int>& incomingTracks = _incomingTracks;
+  incomingTracks.clear();
   for (int i=0;i < (int)tfreq.size(); ++i){ if (tfreq[i]>0) incomingTracks.push_back(i); }
   //	newTracks = np.zeros(tfreq.size, dtype=np.int) -1           # initialize to -1 new tracks
-  std::vector<int> newTracks(tfreq.size());
-  std::fill(newTracks.begin(), newTracks.end(), -1);
+  std::vector<int>& newTracks = _newTracks;
+  newTracks.assign(tfreq.size(), -1);
 
   //	magOrder = np.argsort(-pmag[pindexes])                      # order current peaks by magnitude
-  std::vector<int> magOrder;
+  std::vector<int>& magOrder = _magOrder;
   sort_indexes(magOrder, peakMags, false);
 
 
@@ -270,7 +295,8 @@ void SineModelAnal::sinusoidalTracking(std::vector<Real>& peakMags, std::vector<
 
 
   //	indext = np.array(np.nonzero(newTracks != -1), dtype=np.int)[0]   # indexes of assigned tracks
-  std::vector<int> indext;
+  std::vector<int>& indext = _indext;
+  indext.clear();
   for (int i=0; i < (int)newTracks.size(); ++i)
   {
     if (newTracks[i] != -1) indext.push_back(i);
@@ -279,7 +305,7 @@ void SineModelAnal::sinusoidalTracking(std::vector<Real>& peakMags, std::vector<
   if (indext.size() > 0)
   {
     //		indexp = newTracks[indext]                                    # indexes of assigned peaks
-    std::vector<int> indexp;
+    std::vector<int>& indexp = _indexp;
     copy_int_vector_from_indexes(indexp, newTracks, indext);
 
     for (int i=0; i < (int)indexp.size(); ++i){
@@ -296,14 +322,15 @@ void SineModelAnal::sinusoidalTracking(std::vector<Real>& peakMags, std::vector<
 
   // -----
   // create new tracks for non used peaks
-  std::vector<int> emptyt;
+  std::vector<int>& emptyt = _emptyt;
+  emptyt.clear();
   for (int i=0; i < (int)tfreq.size(); ++i)
   {
     if (tfreq[i] == 0) emptyt.push_back(i);
   }
 
   //	peaksleft = np.argsort(-pmagt)                                  # sort left peaks by magnitude
-  std::vector<int> peaksleft;
+  std::vector<int>& peaksleft = _peaksleft;
   sort_indexes(peaksleft, pmagt, false);
 
   if ((peaksleft.size() > 0) && (emptyt.size() >= peaksleft.size())){    // fill empty tracks
@@ -339,7 +366,7 @@ void SineModelAnal::sinusoidalTracking(std::vector<Real>& peakMags, std::vector<
 
 
 
-void SineModelAnal::phaseInterpolation(std::vector<Real> fftphase, std::vector<Real> peakFrequencies, std::vector<Real>& peakPhases){
+void SineModelAnal::phaseInterpolation(const std::vector<Real>& fftphase, const std::vector<Real>& peakFrequencies, std::vector<Real>& peakPhases){
 
   int N = peakFrequencies.size();
   peakPhases.resize(N);
@@ -350,7 +377,7 @@ void SineModelAnal::phaseInterpolation(std::vector<Real> fftphase, std::vector<R
 
   for (int i=0; i < N; ++i){
     // linear interpolation. (as done in numpy.interp function)
-    pos =  fftSize * (peakFrequencies[i] / (parameter("sampleRate").toReal()/2.0) );
+    pos =  fftSize * (peakFrequencies[i] / (_sampleRate/2.0) );
     idx = int ( 0.5 + pos ); // closest index
 
     a = pos - idx; // interpolate factor
@@ -363,7 +390,8 @@ void SineModelAnal::phaseInterpolation(std::vector<Real> fftphase, std::vector<R
         peakPhases[i] = (std::abs(fftphase[idx+1] - fftphase[idx]) < Real(M_PI)) ? a * fftphase[idx+1] + (1.0 -a) * fftphase[idx]: fftphase[idx];
       }
       else {
-       peakPhases[i] = fftphase[idx];
+       // a peak at the Nyquist frequency would be one bin past the end
+       peakPhases[i] = fftphase[std::min(idx, fftSize-1)];
      }
     }
   }
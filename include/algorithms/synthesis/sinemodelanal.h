@@ -76,8 +76,8 @@ class SineModelAnal : public Algorithm {
   void configure();
   void compute();
 
-  void phaseInterpolation(std::vector<Real> fftphase, std::vector<Real> peakFrequencies, std::vector<Real>& peakPhases);
-  void sinusoidalTracking(std::vector<Real>& peakMags, std::vector<Real>& peakFrequencies, std::vector<Real>& peakPhases, const std::vector<Real> tfreq, Real freqDevOffset, Real freqDevSlope,  std::vector<Real> &tmagn, std::vector<Real> &tfreqn, std::vector<Real> &tphasen );
+  void phaseInterpolation(const std::vector<Real>& fftphase, const std::vector<Real>& peakFrequencies, std::vector<Real>& peakPhases);
+  void sinusoidalTracking(std::vector<Real>& peakMags, std::vector<Real>& peakFrequencies, std::vector<Real>& peakPhases, const std::vector<Real>& tfreq, Real freqDevOffset, Real freqDevSlope,  std::vector<Real> &tmagn, std::vector<Real> &tfreqn, std::vector<Real> &tphasen );
   void cleaningSineTrack();
 
   std::vector<Real> _lasttpeakFrequency;
@@ -89,14 +89,37 @@ class SineModelAnal : public Algorithm {
 
  private:
   void sort_indexes(std::vector<int> &idx, const std::vector<Real> &v, bool ascending);
-  void copy_vector_from_indexes(std::vector<Real> &out, const std::vector<Real> v, const std::vector<int> idx);
-  void copy_int_vector_from_indexes(std::vector<int> &out, const std::vector<int> v, const std::vector<int> idx);
-  void erase_vector_from_indexes(std::vector<Real> &v, const std::vector<int> idx);
+  void copy_vector_from_indexes(std::vector<Real> &out, const std::vector<Real>& v, const std::vector<int>& idx);
+  void copy_int_vector_from_indexes(std::vector<int> &out, const std::vector<int>& v, const std::vector<int>& idx);
+  void erase_vector_from_indexes(std::vector<Real> &v, const std::vector<int>& idx);
 
   // support functions for sort_indexes()
   static bool comparator_up ( const mypair& l, const mypair& r);
   static bool comparator_down ( const mypair& l, const mypair& r);
 
+  Real _sampleRate;
+  Real _freqDevOffset;
+  Real _freqDevSlope;
+  int _maxSines;
+  int _maxPeaks;
+
+  // scratch space of compute(), kept from a frame to the next so that there
+  // is no allocation once the first frame has been processed
+  std::vector<Real> _fftmag;
+  std::vector<Real> _fftmagdB;
+  std::vector<Real> _fftphase;
+  std::vector<Real> _peakMagnitude;
+  std::vector<Real> _peakFrequency;
+  std::vector<Real> _peakPhase;
+  std::vector<mypair> _pairs;
+  std::vector<int> _incomingTracks;
+  std::vector<int> _newTracks;
+  std::vector<int> _magOrder;
+  std::vector<int> _indext;
+  std::vector<int> _indexp;
+  std::vector<int> _emptyt;
+  std::vector<int> _peaksleft;
+
 };
 
 } // namespace standard
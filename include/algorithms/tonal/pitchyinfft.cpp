@@ -126,7 +126,7 @@ void PitchYinFFT::compute() {
 
   // build modified squared difference function using a weighted
   // input norm spectrum
-  vector<complex<Real> > frameFFT;
+  vector<complex<Real> >& frameFFT = _frameFFT;
   _fft->input("frame").set(_sqrMag);
   _fft->output("fft").set(frameFFT);
 
@@ -50,6 +50,27 @@ class ESSENTIA_API AlgorithmInfo {
 };
 
 
+/**
+ * Scope of the creation of an algorithm by a factory, ie: its constructor and
+ * its configuration. It is counted per thread, so that the networks built
+ * inside an algorithm (eg: in a composite or an extractor) can tell they are
+ * not top-level ones, see scheduler::Network::defaultNumberThreads.
+ */
+class ESSENTIA_API AlgorithmCreation {
+ public:
+  AlgorithmCreation() { _depth++; }
+  ~AlgorithmCreation() { _depth--; }
+
+  /**
+   * Returns whether an algorithm is being created on the calling thread.
+   */
+  static bool active() { return _depth > 0; }
+
+ private:
+  static thread_local int _depth;
+};
+
+
 /**
  * This factory creates instances of the common BaseAlgorithm interface, while
  * getting information from the ReferenceAlgorithm implementation.
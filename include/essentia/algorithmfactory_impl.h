@@ -55,6 +55,8 @@ BaseAlgorithm* EssentiaFactory<BaseAlgorithm>::create_i(const std::string& id) c
     throw EssentiaException(msg);
   }
 
+  AlgorithmCreation creation;
+
   E_DEBUG_INDENT;
   BaseAlgorithm* algo = it->second.create();
   E_DEBUG_OUTDENT;
@@ -114,6 +116,7 @@ BaseAlgorithm* EssentiaFactory<BaseAlgorithm>::create_i(const std::string& id) c
     }                                                                                                       \
     throw EssentiaException(msg);                                                                           \
   }                                                                                                         \
+  AlgorithmCreation creation;                                                                               \
   E_DEBUG_INDENT;                                                                                           \
   BaseAlgorithm* algo = it->second.create();                                                                \
   E_DEBUG_OUTDENT;                                                                                          \
@@ -19,6 +19,7 @@
 
 #include "essentia.h"
 #include "algorithmfactory.h"
+#include "streaming/bufferarena.h"
 // Need to do this to keep essentia FFT "agnostic"
 // #include <fftw3.h>
 
@@ -62,6 +63,7 @@ void shutdown() {
   standard::AlgorithmFactory::shutdown();
   streaming::AlgorithmFactory::shutdown();
   TypeMap::shutdown();
+  streaming::BufferArena::clearPool();
 
   _initialized = false;
 }
@@ -75,6 +77,8 @@ template<> streaming::AlgorithmFactory* streaming::AlgorithmFactory::_instance =
 
 EssentiaMap<string,string> * TypeMap::_typeMap = 0;
 
+thread_local int AlgorithmCreation::_depth = 0;
+
 
 #ifndef OS_WIN32
 
@@ -27,6 +27,105 @@ using namespace TNT;
 
 namespace essentia {
 
+Pool::Pool(const Pool& pool) : _indexed(0), _threadSafe(false) {
+  *this = pool;
+}
+
+Pool& Pool::operator=(const Pool& pool) {
+  if (&pool == this) return *this;
+
+  GLOBAL_LOCK
+
+  _poolReal = pool._poolReal;
+  _poolVectorReal = pool._poolVectorReal;
+  _poolString = pool._poolString;
+  _poolVectorString = pool._poolVectorString;
+  _poolArray2DReal = pool._poolArray2DReal;
+  _poolStereoSample = pool._poolStereoSample;
+  _poolSingleReal = pool._poolSingleReal;
+  _poolSingleString = pool._poolSingleString;
+  _poolSingleVectorReal = pool._poolSingleVectorReal;
+  _poolSingleVectorString = pool._poolSingleVectorString;
+
+  rebuildIndex();
+  return *this;
+}
+
+const Pool::IndexEntry* Pool::lookup(const string& name) const {
+  if (_index.empty()) return 0;
+
+  size_t hash = std::hash<string>()(name);
+  size_t mask = _index.size() - 1;
+
+  // linear probing, there is always at least one empty slot
+  for (size_t i=hash & mask; ; i=(i+1) & mask) {
+    const IndexEntry& entry = _index[i];
+    if (!entry.name) return 0;
+    if (entry.hash == hash && *entry.name == name) return &entry;
+  }
+}
+
+void Pool::indexInsert(const string* name, SubPoolType subPool, void* data) {
+  // the new descriptor is already in its map, so growing the index by
+  // rebuilding it from the maps indexes it as well
+  if (2*(_indexed+1) > _index.size()) {
+    rebuildIndex();
+    return;
+  }
+
+  size_t hash = std::hash<string>()(*name);
+  size_t mask = _index.size() - 1;
+  size_t i = hash & mask;
+  while (_index[i].name) i = (i+1) & mask;
+
+  IndexEntry& entry = _index[i];
+  entry.hash = hash;
+  entry.name = name;
+  entry.subPool = subPool;
+  entry.data = data;
+  _indexed++;
+}
+
+void Pool::rebuildIndex() {
+  size_t count = _poolReal.size()         +
+                 _poolVectorReal.size()   +
+                 _poolString.size()       +
+                 _poolVectorString.size() +
+                 _poolArray2DReal.size()  +
+                 _poolStereoSample.size() +
+                 _poolSingleReal.size()   +
+                 _poolSingleString.size() +
+                 _poolSingleVectorReal.size() +
+                 _poolSingleVectorString.size();
+
+  size_t size = 16;
+  while (size < 2*(count+1)) size *= 2;
+
+  IndexEntry empty = { 0, 0, RealPool, 0 };
+  _index.assign(size, empty);
+  _indexed = 0;
+
+  #define INDEX_POOL(type, tname)                                              \
+  for (map<string, type >::iterator it = _pool##tname.begin();                 \
+       it != _pool##tname.end();                                               \
+       ++it) {                                                                 \
+    indexInsert(&it->first, tname##Pool, &it->second);                         \
+  }
+
+  INDEX_POOL(Real, SingleReal);
+  INDEX_POOL(vector<Real>, Real);
+  INDEX_POOL(vector<Real>, SingleVectorReal);
+  INDEX_POOL(vector<vector<Real> >, VectorReal);
+  INDEX_POOL(string, SingleString);
+  INDEX_POOL(vector<string>, String);
+  INDEX_POOL(vector<string>, SingleVectorString);
+  INDEX_POOL(vector<vector<string> >, VectorString);
+  INDEX_POOL(vector<TNT::Array2D<Real> >, Array2DReal);
+  INDEX_POOL(vector<StereoSample>, StereoSample);
+
+  #undef INDEX_POOL
+}
+
 void Pool::clear() {
   GLOBAL_LOCK;
 
@@ -39,7 +138,10 @@ void Pool::clear() {
   _poolSingleReal.clear();
   _poolSingleString.clear();
   _poolSingleVectorReal.clear();
-  _poolSingleVectorString.clear();  
+  _poolSingleVectorString.clear();
+
+  _index.clear();
+  _indexed = 0;
 }
 
 void Pool::checkIntegrity() const {
@@ -63,13 +165,15 @@ void Pool::checkIntegrity() const {
 // this implementation makes the assumption that the key 'name' only exists in
 // one of the sub-pools, as enforced by checkIntegrity
 void Pool::remove(const string& name) {
+  // removing a descriptor modifies the index, acquire a global lock
+  GLOBAL_LOCK
 
   #define SEARCH_AND_DESTROY(t, tname)                                         \
   {                                                                            \
-    MutexLocker lock(mutex##tname);                                            \
     map<string, t >::iterator i = _pool##tname.find(name);                     \
     if (i != _pool##tname.end()) {                                             \
       _pool##tname.erase(i);                                                   \
+      rebuildIndex();                                                          \
       return;                                                                  \
     }                                                                          \
   }
@@ -91,10 +195,11 @@ void Pool::remove(const string& name) {
 }
 
 void Pool::removeNamespace(const string& ns) {
+  // removing descriptors modifies the index, acquire a global lock
+  GLOBAL_LOCK
 
   #define SEARCH_AND_DESTROY(t, tname)                              \
   {                                                                 \
-    MutexLocker lock(mutex##tname);                                 \
     map<string, t >::iterator it = _pool##tname.begin();            \
     int pos = 0;                                                    \
     /*temp iterator that keeps track of the position in the map*/   \
@@ -129,6 +234,8 @@ void Pool::removeNamespace(const string& ns) {
   SEARCH_AND_DESTROY(vector<StereoSample>, StereoSample);
 
   #undef SEARCH_AND_DESTROY
+
+  rebuildIndex();
 }
 
 
@@ -138,7 +245,7 @@ vector<string> Pool::descriptorNames() const {
 
   #define ADD_DESC_NAMES(type, tname)                                          \
   {                                                                            \
-    MutexLocker lock(mutex##tname);                                            \
+    ConditionalMutexLocker lock(mutex##tname, _threadSafe);                    \
     descNames.resize(descNames.size() + _pool##tname.size());                  \
     for (map<string, type >::const_iterator it = _pool##tname.begin();         \
          it != _pool##tname.end();                                             \
@@ -167,7 +274,7 @@ vector<string> Pool::descriptorNames(const std::string& ns) const {
   vector<string> descNames;
   #define ADD_DESC_NAMES(type, tname)                            \
   {                                                              \
-    MutexLocker lock(mutex##tname);                              \
+    ConditionalMutexLocker lock(mutex##tname, _threadSafe);      \
     map<string, type>::const_iterator it = _pool##tname.begin(); \
     while (it != _pool##tname.end()) {                           \
       if (it->first.find(ns+".") == 0)                           \
@@ -231,28 +338,38 @@ vector<string> Pool::descriptorNamesNoLocking() const {
   return descNames;
 }
 
+// returns whether name is in the namespace given by parent, ie: whether it
+// starts with parent + "."
+static bool isChildName(const string& name, const string& parent) {
+  return name.size() > parent.size() && name[parent.size()] == '.' &&
+         name.compare(0, parent.size(), parent) == 0;
+}
+
 void Pool::validateKey(const string& name) {
-  std::vector<std::string> allNames = descriptorNamesNoLocking();
-  for (int i=0; i<int(allNames.size()); ++i) {
-    /* first check if name already exists in another sub-pool */
-    if (name == allNames[i]) {
-      throw EssentiaException("Pool: Cannot set/add/merge value to the pool under "
-                              "the name '"+name+"' because that name already exists but "
-                              "contains a different data type than value");
-    }
+  /* first check if name already exists in another sub-pool */
+  if (lookup(name)) {
+    throw EssentiaException("Pool: Cannot set/add/merge value to the pool under "
+                            "the name '"+name+"' because that name already exists but "
+                            "contains a different data type than value");
+  }
+
+  for (int i=0; i<int(_index.size()); ++i) {
+    if (!_index[i].name) continue;
+    const string& other = *_index[i].name;
+
     /* now check if adding this new key will result in a parent descriptor
      * having a value and child descriptors (there are 2 cases where this can
      * happen)*/
-    if ( name.find(allNames[i] + ".") == 0 ) {
+    if (isChildName(name, other)) {
       throw EssentiaException("Pool: Cannot set/add/merge value to the pool under the name '"+name+
                               "' because '"+name+"' has a parent descriptor name already in "
-                              "the pool (e.g. '"+allNames[i]+"')");
+                              "the pool (e.g. '"+other+"')");
     }
 
-    if ( allNames[i].find(name+".") == 0 ) {
+    if (isChildName(other, name)) {
       throw EssentiaException("Pool: Cannot add/set/merge value to the pool under "
                               "the name '"+name+"' because '"+name+"' has child descriptor "
-                              "names (e.g. '"+allNames[i]+"')");
+                              "names (e.g. '"+other+"')");
     }
   }
 }
@@ -263,19 +380,20 @@ void Pool::add(const string& name, const type& value, bool validityCheck) {  \
   /* first check if the pool has ever seen this key before, if it has, we can
    * just add it, if not, we need to run some validation tests */            \
   {                                                                          \
-    MutexLocker lock(mutex##tname);                                          \
+    ConditionalMutexLocker lock(mutex##tname, _threadSafe);                  \
     if (validityCheck && !isValid(value)) {                                  \
       throw EssentiaException("Pool::add value contains invalid numbers (NaN or inf)");\
     }                                                                        \
-    if (_pool##tname.find(name) != _pool##tname.end()) {                     \
-      _pool##tname[name].push_back(value);                                   \
+    vector<type>* values = find<vector<type> >(name, tname##Pool);           \
+    if (values) {                                                            \
+      values->push_back(value);                                              \
       return;                                                                \
     }                                                                        \
   }                                                                          \
   /* validating will require checking all sub-pools, acquire a global lock*/ \
   GLOBAL_LOCK                                                                \
   validateKey(name);                                                         \
-  _pool##tname[name].push_back(value);                                       \
+  insertNoLocking(_pool##tname, name, tname##Pool).push_back(value);         \
 }
 
 
@@ -292,18 +410,19 @@ void Pool::add(const string& name, const Array2D<Real>& value, bool validityChec
   /* first check if the pool has ever seen this key before, if it has, we can
    * just add it, if not, we need to run some validation tests */
   {
-    MutexLocker lock(mutexArray2DReal);
+    ConditionalMutexLocker lock(mutexArray2DReal, _threadSafe);
     if (validityCheck && !isValid(value)) {
       throw EssentiaException("Pool::add array contains invalid numbers (NaN or inf)");
     }
-    if (_poolArray2DReal.find(name) != _poolArray2DReal.end()) {
-      _poolArray2DReal[name].push_back(value.copy());
+    vector<Array2D<Real> >* values = find<vector<Array2D<Real> > >(name, Array2DRealPool);
+    if (values) {
+      values->push_back(value.copy());
       return;
     }
   }
   GLOBAL_LOCK
   validateKey(name);
-  _poolArray2DReal[name].push_back(value.copy());
+  insertNoLocking(_poolArray2DReal, name, Array2DRealPool).push_back(value.copy());
 }
 
 #define SPECIALIZE_SET_IMPL(type, tname)                                     \
@@ -312,18 +431,19 @@ void Pool::set(const string& name, const type& value, bool validityCheck) {  \
   /* first check if the pool has ever seen this key before, if it has, we can
    * just set it, if not, we need to run some validation tests */            \
   {                                                                          \
-    MutexLocker lock(mutexSingle##tname);                                    \
+    ConditionalMutexLocker lock(mutexSingle##tname, _threadSafe);            \
     if (validityCheck && !isValid(value)) {                                  \
       throw EssentiaException("Pool::set value contains invalid numbers (NaN or inf)");\
     }                                                                        \
-    if (_poolSingle##tname.find(name) != _poolSingle##tname.end()) {         \
-      _poolSingle##tname[name] = value;                                      \
+    type* single = find<type>(name, Single##tname##Pool);                    \
+    if (single) {                                                            \
+      *single = value;                                                       \
       return;                                                                \
     }                                                                        \
   }                                                                          \
   GLOBAL_LOCK                                                                \
   validateKey(name);                                                         \
-  _poolSingle##tname[name] = value;                                          \
+  insertNoLocking(_poolSingle##tname, name, Single##tname##Pool) = value;    \
 }
 
 SPECIALIZE_SET_IMPL(Real, Real)
@@ -338,7 +458,7 @@ void Pool::merge(Pool& p, const string& mergeType) {
     vector<string> descNames;                                                        \
     descNames.reserve(p.get##tname##Pool().size());                                  \
     {                                                                                \
-      MutexLocker lock(p.mutex##tname);                                              \
+      ConditionalMutexLocker lock(p.mutex##tname, p._threadSafe);                    \
       for (map<string, vector<t> >::const_iterator it = p.get##tname##Pool().begin();\
            it != p.get##tname##Pool().end();                                         \
            ++it) {                                                                   \
@@ -354,7 +474,7 @@ void Pool::merge(Pool& p, const string& mergeType) {
     vector<string> descNames;                                                \
     descNames.reserve(p.get##tname##Pool().size());                          \
     {                                                                        \
-      MutexLocker lock(p.mutex##tname);                                    \
+      ConditionalMutexLocker lock(p.mutex##tname, p._threadSafe);          \
       for (map<string, t>::const_iterator it = p.get##tname##Pool().begin(); \
            it != p.get##tname##Pool().end();                                 \
            ++it) {                                                           \
@@ -391,38 +511,31 @@ void Pool::merge(const string& name, const vector<type>& value, const string& me
   /* first check if the pool has ever seen this key before, if it has, we can
    * just add it, if not, we need to run some validation tests */                                      \
   {                                                                                                    \
-    MutexLocker lock(mutex##tname);                                                                    \
-    map<string, vector<type> >::iterator it = _pool##tname.find(name);                                 \
-    if (it != _pool##tname.end()) {                                                                    \
+    ConditionalMutexLocker lock(mutex##tname, _threadSafe);                                            \
+    vector<type>* values = find<vector<type> >(name, tname##Pool);                                     \
+    if (values) {                                                                                      \
       if (mergeType == "") {                                                                           \
         throw EssentiaException("Pool::merge, cannot merge descriptor names with the same name:" +     \
                                 name + " unless a merge type (\"append\", \"replace\" or " +           \
                                 "\"interleave\") is specified");                                       \
       }                                                                                                \
       else if (mergeType=="append") {                                                                  \
-        _pool##tname[name].reserve(_pool##tname[name].size()+value.size());                            \
-        for(int i=0; i<int(value.size()); i++) {                                                       \
-          _pool##tname[name].push_back(value[i]);                                                      \
-        }                                                                                              \
+        values->insert(values->end(), value.begin(), value.end());                                     \
       }                                                                                                \
       else if (mergeType == "replace") {                                                               \
-        _pool##tname.erase(it);                                                                        \
-        _pool##tname.insert(make_pair(name, value));                                                   \
+        *values = value;                                                                               \
       }                                                                                                \
       else if (mergeType=="interleave") {                                                              \
-        if (value.size() != _pool##tname[name].size()) {                                               \
+        if (value.size() != values->size()) {                                                          \
           throw EssentiaException("Pool::merge, cannot interleave descriptors with different sizes :", name);\
         }                                                                                              \
-        vector<type> temp = _pool##tname[name];                                                        \
-        _pool##tname.erase(it);\
-        _pool##tname[name].push_back(temp[0]);                                                         \
-        _pool##tname[name].push_back(value[0]);                                                        \
-        _pool##tname[name].reserve(2*temp.size());                                                     \
-        for (int i=1; i<(int)temp.size(); i++) {                                                       \
-          _pool##tname[name].push_back(temp[i]);                                                       \
-          _pool##tname[name].push_back(value[i]);                                                      \
+        vector<type> interleaved;                                                                      \
+        interleaved.reserve(2*value.size());                                                           \
+        for (int i=0; i<(int)value.size(); i++) {                                                      \
+          interleaved.push_back((*values)[i]);                                                         \
+          interleaved.push_back(value[i]);                                                             \
         }                                                                                              \
-        return;\
+        values->swap(interleaved);                                                                     \
       }                                                                                                \
       else {                                                                                           \
         throw EssentiaException("Pool::merge, unknown merge type: ", mergeType);                       \
@@ -432,11 +545,7 @@ void Pool::merge(const string& name, const vector<type>& value, const string& me
   }                                                                                                    \
   GLOBAL_LOCK                                                                                          \
   validateKey(name);                                                                                   \
-  _pool##tname[name].push_back(value[0]);                                                              \
-  _pool##tname[name].reserve(value.size());                                                            \
-  for (int i=1; i<(int)value.size(); ++i) {                                                            \
-    _pool##tname[name].push_back(value[i]);                                                            \
-  }                                                                                                    \
+  insertNoLocking(_pool##tname, name, tname##Pool) = value;                                            \
 }
 
 SPECIALIZE_MERGE_IMPL(Real, Real);
@@ -451,12 +560,11 @@ void Pool::mergeSingle(const string& name, const type& value, const string& merg
   /* first check if the pool has ever seen this key before, if it has, we can
    * just add it, if not, we need to run some validation tests */                                      \
   {                                                                                                    \
-    MutexLocker lock(mutexSingle##tname);                                                              \
-    map<string, type>::iterator it = _poolSingle##tname.find(name);                                    \
-    if (it != _poolSingle##tname.end()) {                                                              \
+    ConditionalMutexLocker lock(mutexSingle##tname, _threadSafe);                                      \
+    type* single = find<type>(name, Single##tname##Pool);                                              \
+    if (single) {                                                                                      \
       if (mergeType == "replace") {                                                                    \
-        _poolSingle##tname.erase(it);                                                                  \
-        _poolSingle##tname.insert(make_pair(name, value));                                             \
+        *single = value;                                                                               \
       }                                                                                                \
       else {                                                                                           \
         throw EssentiaException("Pool::mergeSingle, values for single value descriptors can only be"   \
@@ -468,7 +576,7 @@ void Pool::mergeSingle(const string& name, const type& value, const string& merg
   }                                                                                                    \
   GLOBAL_LOCK                                                                                          \
   validateKey(name);                                                                                   \
-  _poolSingle##tname.insert(make_pair(name, value));                                                   \
+  insertNoLocking(_poolSingle##tname, name, Single##tname##Pool) = value;                              \
 }
 
 SPECIALIZE_MERGE_SINGLE_IMPL(Real, Real)
@@ -481,41 +589,38 @@ void Pool::merge(const string& name, const vector<Array2D<Real> >& value, const
   /* first check if the pool has ever seen this key before, if it has, we can
    * just add it, if not, we need to run some validation tests */
   {
-    MutexLocker lock(mutexArray2DReal);
-    map<string, vector<Array2D<Real> > >::iterator it = _poolArray2DReal.find(name);
-    if (it != _poolArray2DReal.end()) {
+    ConditionalMutexLocker lock(mutexArray2DReal, _threadSafe);
+    vector<Array2D<Real> >* values = find<vector<Array2D<Real> > >(name, Array2DRealPool);
+    if (values) {
       if (mergeType == "") {
         throw EssentiaException("Pool::merge, cannot merge descriptor names with the same name:" +
                                 name + " unless a merge type (\"append\", \"replace\" or " +
                                 "\"interleave\") is specified");
       }
       else if (mergeType=="append") {
-        _poolArray2DReal[name].reserve(_poolArray2DReal[name].size()+value.size());
+        values->reserve(values->size()+value.size());
         for(int i=0; i<int(value.size()); i++) {
-          _poolArray2DReal[name].push_back(value[i].copy());
+          values->push_back(value[i].copy());
         }
       }
       else if (mergeType == "replace") {
-        _poolArray2DReal.erase(it);
-        _poolArray2DReal[name].reserve(value.size());
+        values->clear();
+        values->reserve(value.size());
         for(int i=0; i<int(value.size()); i++) {
-          _poolArray2DReal[name].push_back(value[i].copy());
+          values->push_back(value[i].copy());
         }
       }
       else if (mergeType=="interleave") {
-        if (value.size() != _poolArray2DReal[name].size()) {
+        if (value.size() != values->size()) {
           throw EssentiaException("Pool::merge, cannot interleave descriptors with different sizes :", name);
         }
-        vector<Array2D<Real> > temp = _poolArray2DReal[name];
-        _poolArray2DReal.erase(it);
-        _poolArray2DReal[name].push_back(temp[0].copy());
-        _poolArray2DReal[name].push_back(value[0].copy());
-        _poolArray2DReal[name].reserve(2*temp.size());
-        for (int i=1; i<(int)temp.size(); i++) {
-          _poolArray2DReal[name].push_back(temp[i].copy());
-          _poolArray2DReal[name].push_back(value[i].copy());
+        vector<Array2D<Real> > interleaved;
+        interleaved.reserve(2*value.size());
+        for (int i=0; i<(int)value.size(); i++) {
+          interleaved.push_back((*values)[i]);
+          interleaved.push_back(value[i].copy());
         }
-        return;
+        values->swap(interleaved);
       }
       else {
         throw EssentiaException("Pool::merge, unknown merge type: ", mergeType);
@@ -523,31 +628,32 @@ void Pool::merge(const string& name, const vector<Array2D<Real> >& value, const
       return;
     }
   }
+  if (value.empty()) return;
+
   GLOBAL_LOCK
   validateKey(name);
-  _poolArray2DReal[name].push_back(value[0].copy());
-  _poolArray2DReal[name].reserve(value.size());
-  for (int i=1; i<(int)value.size(); ++i) {
-    _poolArray2DReal[name].push_back(value[i].copy());
+  vector<Array2D<Real> >& values = insertNoLocking(_poolArray2DReal, name, Array2DRealPool);
+  values.reserve(value.size());
+  for (int i=0; i<(int)value.size(); ++i) {
+    values.push_back(value[i].copy());
   }
 }
 
 bool Pool::isSingleValue(const string& name) {
-  #define SEARCH_SINGLE(t, tname)                                              \
-  {                                                                            \
-    MutexLocker lock(mutex##tname);                                            \
-    map<string, t >::iterator i = _pool##tname.find(name);                     \
-    if (i != _pool##tname.end()) {                                             \
-      return true;                                                             \
-    }                                                                          \
+  // any of the sub-pool locks is enough to read the index
+  ConditionalMutexLocker lock(mutexSingleReal, _threadSafe);
+  const IndexEntry* entry = lookup(name);
+  if (!entry) return false;
+
+  switch (entry->subPool) {
+    case SingleRealPool:
+    case SingleVectorRealPool:
+    case SingleStringPool:
+    case SingleVectorStringPool:
+      return true;
+    default:
+      return false;
   }
-  SEARCH_SINGLE(Real, SingleReal);
-  SEARCH_SINGLE(vector<Real>, SingleVectorReal);
-  SEARCH_SINGLE(string, SingleString);
-  SEARCH_SINGLE(vector<string>, SingleVectorString);
-
-  #undef SEARCH_SINGLE
-  return false;
 }
 
 } // namespace essentia
@@ -20,6 +20,7 @@
 #ifndef ESSENTIA_POOL_H
 #define ESSENTIA_POOL_H
 
+#include <functional>
 #include "types.h"
 #include "threading.h"
 #include "utils/tnt/tnt.h"
@@ -77,18 +78,19 @@ typedef std::string DescriptorName;
  * into a Pool using the YamlInput algorithm.
  *
  * For each type, the pool has its own public mutex (i.e. mutexReal, mutexVectorReal, etc.)
+ * The pool only locks them itself once it has been made thread-safe, see setThreadSafe().
  * If locking the pool globally or partially, lock should be acquired in the following order:
  *
- *         MutexLocker lockReal(mutexReal)
- *         MutexLocker lockVectorReal(mutexVectorReal)
- *         MutexLocker lockString(mutexString)
- *         MutexLocker lockVectorString(mutexVectorString)
- *         MutexLocker lockArray2DReal(mutexArray2DReal)
- *         MutexLocker lockStereoSample(mutexStereoSample)
- *         MutexLocker lockSingleReal(mutexSingleReal)
- *         MutexLocker lockSingleString(mutexSingleString)
- *         MutexLocker lockSingleVectorReal(mutexSingleVectorReal)
- *         MutexLocker lockSingleVectorString(mutexSingleVectorString)
+ *         ForcedMutexLocker lockReal(mutexReal)
+ *         ForcedMutexLocker lockVectorReal(mutexVectorReal)
+ *         ForcedMutexLocker lockString(mutexString)
+ *         ForcedMutexLocker lockVectorString(mutexVectorString)
+ *         ForcedMutexLocker lockArray2DReal(mutexArray2DReal)
+ *         ForcedMutexLocker lockStereoSample(mutexStereoSample)
+ *         ForcedMutexLocker lockSingleReal(mutexSingleReal)
+ *         ForcedMutexLocker lockSingleString(mutexSingleString)
+ *         ForcedMutexLocker lockSingleVectorReal(mutexSingleVectorReal)
+ *         ForcedMutexLocker lockSingleVectorString(mutexSingleVectorString)
  *
  * To release the locks, the order should be reversed!
  *
@@ -110,6 +112,44 @@ class Pool {
   PoolOf(TNT::Array2D<Real>) _poolArray2DReal;
   PoolOf(StereoSample) _poolStereoSample;
 
+  // Open-addressing hash index over the descriptor names of all sub-pools,
+  // so that adding to (or reading from) an existing descriptor costs one hash
+  // and one string comparison instead of a walk down the map tree. Entries
+  // point into the map nodes, which never move, so the names are interned in
+  // the maps themselves.
+  // The index is only modified while holding all the sub-pool locks, hence
+  // holding any single one of them is enough to read it.
+  enum SubPoolType {
+    RealPool, VectorRealPool, StringPool, VectorStringPool, Array2DRealPool,
+    StereoSamplePool, SingleRealPool, SingleStringPool, SingleVectorRealPool,
+    SingleVectorStringPool
+  };
+
+  struct IndexEntry {
+    std::size_t hash;
+    const std::string* name; // 0 for an empty slot
+    SubPoolType subPool;
+    void* data;
+  };
+
+  std::vector<IndexEntry> _index; // size is a power of 2, at most half full
+  std::size_t _indexed;
+
+  bool _threadSafe;
+
+  const IndexEntry* lookup(const std::string& name) const;
+
+  // returns the data stored under name if it lives in the given sub-pool, or 0
+  template <typename T>
+  T* find(const std::string& name, SubPoolType subPool) const;
+
+  // WARNING: these functions assume that all sub-pools are locked
+  void indexInsert(const std::string* name, SubPoolType subPool, void* data);
+  void rebuildIndex();
+
+  template <typename T>
+  T& insertNoLocking(std::map<std::string, T>& pool, const std::string& name, SubPoolType subPool);
+
   // WARNING: this function assumes that all sub-pools are locked
   std::vector<std::string> descriptorNamesNoLocking() const;
 
@@ -122,10 +162,27 @@ class Pool {
 
  public:
 
-  mutable Mutex mutexReal, mutexVectorReal, mutexString, mutexVectorString,
+  mutable ForcedMutex mutexReal, mutexVectorReal, mutexString, mutexVectorString,
                 mutexArray2DReal, mutexStereoSample,
                 mutexSingleReal, mutexSingleString, mutexSingleVectorReal, mutexSingleVectorString;
 
+  Pool() : _indexed(0), _threadSafe(false) {}
+
+  // the index points into the maps of the pool it was built for, so it has to
+  // be rebuilt for the copy
+  Pool(const Pool& pool);
+  Pool& operator=(const Pool& pool);
+
+  /**
+   * When set, every access to the pool locks the mutex of the sub-pool it
+   * concerns, so that the pool can be used by several threads at a time.
+   * This is done by the ParallelScheduler for the pools written to by a
+   * network run on more than one thread; otherwise the pool is only used by
+   * one thread at a time and is not locked.
+   */
+  void setThreadSafe(bool threadSafe) { _threadSafe = threadSafe; }
+  bool threadSafe() const { return _threadSafe; }
+
   /**
    * Adds @e value to the Pool under @e name
    * @param name a descriptor name that identifies the collection of data to add
@@ -378,6 +435,22 @@ class Pool {
 };
 
 
+template <typename T>
+inline T* Pool::find(const std::string& name, SubPoolType subPool) const {
+  const IndexEntry* entry = lookup(name);
+  if (!entry || entry->subPool != subPool) return 0;
+  return static_cast<T*>(entry->data);
+}
+
+template <typename T>
+inline T& Pool::insertNoLocking(std::map<std::string, T>& pool,
+                                const std::string& name, SubPoolType subPool) {
+  typename std::map<std::string, T>::iterator it = pool.insert(std::make_pair(name, T())).first;
+  indexInsert(&it->first, subPool, &it->second);
+  return it->second;
+}
+
+
 // make doxygen skip the macros
 /// @cond
 
@@ -385,15 +458,15 @@ class Pool {
 #define SPECIALIZE_VALUE(type, tname)                                          \
 template <>                                                                    \
 inline const type& Pool::value(const std::string& name) const {                \
-  MutexLocker lock(mutex##tname);                                              \
-  std::map<std::string,type >::const_iterator result = _pool##tname.find(name);\
-  if (result == _pool##tname.end()) {                                          \
+  ConditionalMutexLocker lock(mutex##tname, _threadSafe);                      \
+  const type* result = find<type>(name, tname##Pool);                          \
+  if (!result) {                                                               \
     std::ostringstream msg;                                                    \
     msg << "Descriptor name '" << name << "' of type "                         \
         << nameOfType(typeid(type)) << " not found";                           \
     throw EssentiaException(msg);                                              \
   }                                                                            \
-  return result->second;                                                       \
+  return *result;                                                              \
 }
 
 SPECIALIZE_VALUE(Real, SingleReal);
@@ -408,21 +481,17 @@ SPECIALIZE_VALUE(std::vector<StereoSample>, StereoSample);
 // in two separate sub-pools (poolReal and poolSingleVectorReal)
 template<>
 inline const std::vector<Real>& Pool::value(const std::string& name) const {
-  std::map<std::string, std::vector<Real> >::const_iterator result;
+  const std::vector<Real>* result;
   {
-    MutexLocker lock(mutexReal);
-    result = _poolReal.find(name);
-    if (result != _poolReal.end()) {
-      return result->second;
-    }
+    ConditionalMutexLocker lock(mutexReal, _threadSafe);
+    result = find<std::vector<Real> >(name, RealPool);
+    if (result) return *result;
   }
 
   {
-    MutexLocker lock(mutexSingleVectorReal);
-    result = _poolSingleVectorReal.find(name);
-    if (result != _poolSingleVectorReal.end()) {
-      return result->second;
-    }
+    ConditionalMutexLocker lock(mutexSingleVectorReal, _threadSafe);
+    result = find<std::vector<Real> >(name, SingleVectorRealPool);
+    if (result) return *result;
   }
 
   std::ostringstream msg;
@@ -435,21 +504,17 @@ inline const std::vector<Real>& Pool::value(const std::string& name) const {
 // in two separate sub-pools (poolString and poolSingleVectorString)
 template<>
 inline const std::vector<std::string>& Pool::value(const std::string& name) const {
-  std::map<std::string, std::vector<std::string> >::const_iterator result;
+  const std::vector<std::string>* result;
   {
-    MutexLocker lock(mutexString);
-    result = _poolString.find(name);
-    if (result != _poolString.end()) {
-      return result->second;
-    }
+    ConditionalMutexLocker lock(mutexString, _threadSafe);
+    result = find<std::vector<std::string> >(name, StringPool);
+    if (result) return *result;
   }
 
   {
-    MutexLocker lock(mutexSingleVectorString);
-    result = _poolSingleVectorString.find(name);
-    if (result != _poolSingleVectorString.end()) {
-      return result->second;
-    }
+    ConditionalMutexLocker lock(mutexSingleVectorString, _threadSafe);
+    result = find<std::vector<std::string> >(name, SingleVectorStringPool);
+    if (result) return *result;
   }
 
   std::ostringstream msg;
@@ -462,12 +527,8 @@ inline const std::vector<std::string>& Pool::value(const std::string& name) cons
 #define SPECIALIZE_CONTAINS(type, tname)                                       \
 template <>                                                                    \
 inline bool Pool::contains<type>(const std::string& name) const {              \
-  MutexLocker lock(mutex##tname);                                              \
-  std::map<std::string,type >::const_iterator result = _pool##tname.find(name);\
-  if (result == _pool##tname.end()) {                                          \
-    return false;                                                              \
-  }                                                                            \
-  return true;                                                                 \
+  ConditionalMutexLocker lock(mutex##tname, _threadSafe);                      \
+  return find<type>(name, tname##Pool) != 0;                                   \
 }
 
 SPECIALIZE_CONTAINS(Real, SingleReal);
@@ -482,21 +543,14 @@ SPECIALIZE_CONTAINS(std::vector<StereoSample>, StereoSample);
 // in two separate sub-pools (poolReal and poolSingleVectorReal)
 template<>
 inline bool Pool::contains<std::vector<Real> >(const std::string& name) const {
-  std::map<std::string, std::vector<Real> >::const_iterator result;
   {
-    MutexLocker lock(mutexReal);
-    result = _poolReal.find(name);
-    if (result != _poolReal.end()) {
-      return true;
-    }
+    ConditionalMutexLocker lock(mutexReal, _threadSafe);
+    if (find<std::vector<Real> >(name, RealPool)) return true;
   }
 
   {
-    MutexLocker lock(mutexSingleVectorReal);
-    result = _poolSingleVectorReal.find(name);
-    if (result != _poolSingleVectorReal.end()) {
-      return true;
-    }
+    ConditionalMutexLocker lock(mutexSingleVectorReal, _threadSafe);
+    if (find<std::vector<Real> >(name, SingleVectorRealPool)) return true;
   }
 
   return false;
@@ -507,21 +561,14 @@ inline bool Pool::contains<std::vector<Real> >(const std::string& name) const {
 // in two separate sub-pools (poolString and poolSingleVectorString)
 template<>
 inline bool Pool::contains<std::vector<std::string> >(const std::string& name) const {
-  std::map<std::string, std::vector<std::string> >::const_iterator result;
   {
-    MutexLocker lock(mutexString);
-    result = _poolString.find(name);
-    if (result != _poolString.end()) {
-      return true;
-    }
+    ConditionalMutexLocker lock(mutexString, _threadSafe);
+    if (find<std::vector<std::string> >(name, StringPool)) return true;
   }
 
   {
-    MutexLocker lock(mutexSingleVectorString);
-    result = _poolSingleVectorString.find(name);
-    if (result != _poolSingleVectorString.end()) {
-      return true;
-    }
+    ConditionalMutexLocker lock(mutexSingleVectorString, _threadSafe);
+    if (find<std::vector<std::string> >(name, SingleVectorStringPool)) return true;
   }
 
   return false;
@@ -529,17 +576,17 @@ inline bool Pool::contains<std::vector<std::string> >(const std::string& name) c
 
 // Used to get a lock over all sub-pools, make sure to update this when adding
 // a new sub-pool
-#define GLOBAL_LOCK                                         \
-MutexLocker lockReal(mutexReal);                            \
-MutexLocker lockVectorReal(mutexVectorReal);                \
-MutexLocker lockString(mutexString);                        \
-MutexLocker lockVectorString(mutexVectorString);            \
-MutexLocker lockArray2DReal(mutexArray2DReal);              \
-MutexLocker lockStereoSample(mutexStereoSample);            \
-MutexLocker lockSingleReal(mutexSingleReal);                \
-MutexLocker lockSingleString(mutexSingleString);            \
-MutexLocker lockSingleVectorReal(mutexSingleVectorReal);    \
-MutexLocker lockSingleVectorString(mutexSingleVectorString);
+#define GLOBAL_LOCK                                                                  \
+ConditionalMutexLocker lockReal(mutexReal, _threadSafe);                             \
+ConditionalMutexLocker lockVectorReal(mutexVectorReal, _threadSafe);                 \
+ConditionalMutexLocker lockString(mutexString, _threadSafe);                         \
+ConditionalMutexLocker lockVectorString(mutexVectorString, _threadSafe);             \
+ConditionalMutexLocker lockArray2DReal(mutexArray2DReal, _threadSafe);               \
+ConditionalMutexLocker lockStereoSample(mutexStereoSample, _threadSafe);             \
+ConditionalMutexLocker lockSingleReal(mutexSingleReal, _threadSafe);                 \
+ConditionalMutexLocker lockSingleString(mutexSingleString, _threadSafe);             \
+ConditionalMutexLocker lockSingleVectorReal(mutexSingleVectorReal, _threadSafe);     \
+ConditionalMutexLocker lockSingleVectorString(mutexSingleVectorString, _threadSafe);
 
 
 
@@ -552,21 +599,17 @@ inline void Pool::append(const std::string& name, const std::vector<T>& values)
 template <>                                                                           \
 inline void Pool::append(const std::string& name, const std::vector<type>& values) {  \
   {                                                                                   \
-    MutexLocker lock(mutex##tname);                                                   \
-    PoolOf(type)::iterator result = _pool##tname.find(name);                          \
-    if (result != _pool##tname.end()) {                                               \
-                                                                                      \
-      std::vector<type>& v = result->second;                                          \
-      int vsize = v.size();                                                           \
-      v.resize(vsize + values.size());                                                \
-      fastcopy(&v[vsize], &values[0], values.size());                                 \
+    ConditionalMutexLocker lock(mutex##tname, _threadSafe);                           \
+    std::vector<type>* result = find<std::vector<type> >(name, tname##Pool);          \
+    if (result) {                                                                     \
+      result->insert(result->end(), values.begin(), values.end());                    \
       return;                                                                         \
     }                                                                                 \
   }                                                                                   \
                                                                                       \
   GLOBAL_LOCK                                                                         \
   validateKey(name);                                                                  \
-  _pool##tname[name] = values;                                                        \
+  insertNoLocking(_pool##tname, name, tname##Pool) = values;                          \
 }
 
 
@@ -18,10 +18,16 @@
  */
 
 #include <stack>
+#include <thread>
+#include <algorithm>
+#include <ctime>
 #include "network.h"
+#include "parallelscheduler.h"
 #include "graphutils.h"
 #include "../streaming/streamingalgorithm.h"
 #include "../streaming/streamingalgorithmcomposite.h"
+#include "../streaming/bufferarena.h"
+#include "../algorithmfactory.h"
 using namespace std;
 using namespace essentia;
 using namespace essentia::streaming;
@@ -165,12 +171,21 @@ vector<NetworkNode*> NetworkNode::addVisibleDependencies(map<Algorithm*, Network
 
 
 Network* Network::lastCreated = 0;
+Network* Network::lastProfiled = 0;
+int Network::defaultNumberThreads = 1;
+bool Network::defaultProfiling = false;
 
 Network::Network(Algorithm* generator, bool takeOwnership) : _takeOwnership(takeOwnership),
                                                              _generator(generator),
                                                              _visibleNetworkRoot(0),
-                                                             _executionNetworkRoot(0) {
+                                                             _executionNetworkRoot(0),
+                                                             _deterministic(false),
+                                                             _profiling(defaultProfiling),
+                                                             _scheduler(0) {
   lastCreated = this;
+  // the networks built inside an algorithm run on the thread of the network
+  // running it, which might already be one of many
+  setNumberThreads(AlgorithmCreation::active() ? 1 : defaultNumberThreads);
 
   // 1- find the simple list of algorithms connected in this network
   buildVisibleNetwork();
@@ -183,10 +198,14 @@ Network::Network(Algorithm* generator, bool takeOwnership) : _takeOwnership(take
 
 Network::~Network() {
   if (lastCreated == this) lastCreated = 0;
+  if (lastProfiled == this) lastProfiled = 0;
   clear();
 }
 
 void Network::clear() {
+  // the scheduler points to the algorithms, get rid of it first
+  clearScheduler();
+
   if (_takeOwnership) {
     deleteAlgorithms();
   }
@@ -232,6 +251,22 @@ bool algorithmHasProduced(Algorithm* algo, EssentiaMap<SourceBase*, int>& produc
   return hasProduced;
 }
 
+void Network::setNumberThreads(int numberThreads) {
+  if (numberThreads < 0) {
+    throw EssentiaException("Network: the number of threads cannot be negative");
+  }
+  if (numberThreads == 0) {
+    numberThreads = max((int)thread::hardware_concurrency(), 1);
+  }
+  _numberThreads = numberThreads;
+}
+
+void Network::clearScheduler() {
+  if (!_scheduler) return;
+  delete _scheduler;
+  _scheduler = 0;
+}
+
 void Network::run() {
   runPrepare();
   while (runStep());
@@ -255,6 +290,24 @@ void Network::runPrepare() {
   // 4- resize the buffers depending on the requirements of the connected sinks
   checkBufferSizes();
 
+  // 5- now that their sizes are known, allocate all the buffers at once
+  allocateBuffers();
+
+  // 6- set up the parallel scheduler if needed, it relies on the execution
+  //    network that we just built. Its worker threads are kept from one run
+  //    to the next, as long as the number of threads does not change
+  int numberThreads = _deterministic ? 1 : _numberThreads;
+  _profile.prepare(_toposortedNetwork, numberThreads, _profiling);
+  if (_profiling) lastProfiled = this;
+  if (_numberThreads > 1 || _deterministic) {
+    if (_scheduler && _scheduler->numberThreads() != numberThreads) clearScheduler();
+    if (!_scheduler) _scheduler = new ParallelScheduler(numberThreads);
+    _scheduler->prepare(_executionNetworkRoot, _toposortedNetwork, &_profile);
+  }
+  else {
+    clearScheduler();
+  }
+
 #if DEBUGGING_ENABLED
   for (int i=0; i<(int)_toposortedNetwork.size(); i++) _toposortedNetwork[i]->nProcess = 0;
 #endif
@@ -264,6 +317,8 @@ void Network::runPrepare() {
 // returns False when there are no more steps to run
 bool Network::runStep() {
   // 5- actually run the network
+  if (_scheduler) return _scheduler->runStep();
+
   if (_toposortedNetwork.empty()) return false;
 
   streaming::Algorithm* gen = _toposortedNetwork[0];
@@ -278,11 +333,12 @@ bool Network::runStep() {
   E_DEBUG(ENetwork, "-------- Running generator loop index " << gen->nProcess << " --------");
 
   E_DEBUG(EScheduler, dash << " Buffer states before running generator, nProcess = " << gen->nProcess << " " << dash);
-  printNetworkBufferFillState();
+  printBufferFillState();
 #endif
 
   // first run the generator once
-  gen->process();
+  if (_profiling) _profile.process(0, 0);
+  else gen->process();
 
   bool endOfStream = gen->shouldStop();
 
@@ -310,7 +366,7 @@ bool Network::runStep() {
       _toposortedNetwork[i]->shouldStop(endOfStream && runStack.empty());
       AlgorithmStatus status;
       do {
-        status = _toposortedNetwork[i]->process();
+        status = _profiling ? _profile.process(i, 0) : _toposortedNetwork[i]->process();
 
 #if DEBUGGING_ENABLED
         if (status == OK || status == FINISHED) _toposortedNetwork[i]->nProcess++;
@@ -333,7 +389,7 @@ bool Network::runStep() {
           E_WARNING("You may want to consider resizing one of the output buffers of " <<
                     "this algorithm for better performance");
           */
-          printNetworkBufferFillState();
+          printBufferFillState();
         }
       } while (status == OK);
 
@@ -796,6 +852,8 @@ FractalNode* expandNode(FractalNode* node) {
 
 void Network::buildExecutionNetwork() {
   E_DEBUG(ENetwork, "building execution network");
+  // the scheduler, if any, still points to the previous execution network:
+  // it is set up again for the new one by runPrepare()
   clearExecutionNetwork();
 
   // 1- First build the visible network
@@ -969,6 +1027,7 @@ void Network::printBufferFillState() {
 void printNetworkBufferFillState() {
   if (!Network::lastCreated) {
     E_WARNING("No network created, or last created network has been deleted...");
+    return;
   }
 
   Network::lastCreated->printBufferFillState();
@@ -1052,6 +1111,181 @@ void Network::checkBufferSizes() {
   E_DEBUG(ENetwork, "checking buffer sizes ok");
 }
 
+void Network::allocateBuffers() {
+  // this is run before each run of the network, so it only walks the sorted
+  // network to avoid allocating memory itself when there is nothing to do.
+  // NB: the outputs of a composite left in the execution network are proxies
+  //     of sources which are also there, so a buffer might be counted twice
+  size_t size = 0;
+  bool allocated = (bool)_bufferArena;
+
+  for (int i=0; i<(int)_toposortedNetwork.size(); i++) {
+    const Algorithm::OutputMap& outputs = _toposortedNetwork[i]->outputs();
+    for (Algorithm::OutputMap::const_iterator output = outputs.begin(); output != outputs.end(); ++output) {
+      SourceBase* source = output->second;
+      size += BufferArena::alignedSize(source->bufferStorageSize());
+      allocated = allocated && source->bufferArena() == _bufferArena.get();
+    }
+  }
+
+  if (allocated) {
+    E_DEBUG(ENetwork, "buffers already allocated from the arena of the previous run");
+    return;
+  }
+
+  E_DEBUG(ENetwork, "allocating the buffers from an arena of " << size << " bytes");
+  shared_ptr<BufferArena> arena = BufferArena::create(size);
+  for (int i=0; i<(int)_toposortedNetwork.size(); i++) {
+    const Algorithm::OutputMap& outputs = _toposortedNetwork[i]->outputs();
+    for (Algorithm::OutputMap::const_iterator output = outputs.begin(); output != outputs.end(); ++output) {
+      SourceBase* source = output->second;
+      if (source->bufferArena() != arena.get()) source->allocateBufferFrom(arena);
+    }
+  }
+  _bufferArena = arena;
+}
+
+
+
+// CPU time consumed by the calling thread, in seconds
+static double threadCpuTime() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  timespec now;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0) {
+    return now.tv_sec + now.tv_nsec * 1e-9;
+  }
+#endif
+  return 0;
+}
+
+void NetworkProfile::prepare(const vector<Algorithm*>& algos, int numberThreads, bool profiling) {
+  _algos = algos;
+  _statistics.clear();
+  _statistics.reserve(algos.size());
+  for (int i=0; i<(int)algos.size(); i++) _statistics.push_back(NodeStatistics(algos[i]));
+  _traces.clear();
+  _traces.resize(profiling ? max(numberThreads, 1) : 0);
+  _profiling = profiling;
+  _origin = chrono::steady_clock::now();
+}
+
+AlgorithmStatus NetworkProfile::process(int node, int thread) {
+  Algorithm* algo = _algos[node];
+  NodeStatistics& stats = _statistics[node];
+
+  if (!_profiling) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AlgorithmStatus status = algo->process();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (status == OK || status == FINISHED) {
+      stats.busyCalls++;
+      stats.busyTime += elapsed;
+    }
+    else {
+      stats.idleCalls++;
+      stats.idleTime += elapsed;
+    }
+    return status;
+  }
+
+  const Algorithm::InputMap& inputs = algo->inputs();
+  const Algorithm::OutputMap& outputs = algo->outputs();
+  long long consumed = 0;
+  long long produced = 0;
+  for (int i=0; i<(int)inputs.size(); i++) consumed -= inputs[i].second->totalConsumed();
+  for (int i=0; i<(int)outputs.size(); i++) produced -= outputs[i].second->totalProduced();
+
+  double cpuStart = threadCpuTime();
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  AlgorithmStatus status = algo->process();
+  chrono::steady_clock::time_point end = chrono::steady_clock::now();
+  stats.cpuTime += threadCpuTime() - cpuStart;
+
+  double elapsed = chrono::duration<double>(end - start).count();
+  if (status == OK || status == FINISHED) {
+    stats.busyCalls++;
+    stats.busyTime += elapsed;
+    _traces[thread].push_back(TraceEvent(node, thread,
+      chrono::duration<double>(start - _origin).count(), elapsed));
+  }
+  else {
+    stats.idleCalls++;
+    stats.idleTime += elapsed;
+  }
+
+  for (int i=0; i<(int)inputs.size(); i++) consumed += inputs[i].second->totalConsumed();
+  stats.tokensConsumed += consumed;
+  for (int i=0; i<(int)outputs.size(); i++) {
+    SourceBase* output = outputs[i].second;
+    produced += output->totalProduced();
+    int waiting = output->bufferInfo().size - output->available();
+    stats.bufferHighWater = max(stats.bufferHighWater, waiting);
+  }
+  stats.tokensProduced += produced;
+
+  return status;
+}
+
+static bool startsBefore(const TraceEvent& a, const TraceEvent& b) {
+  return a.start < b.start;
+}
+
+vector<TraceEvent> NetworkProfile::trace() const {
+  vector<TraceEvent> events;
+  for (int i=0; i<(int)_traces.size(); i++) {
+    events.insert(events.end(), _traces[i].begin(), _traces[i].end());
+  }
+  stable_sort(events.begin(), events.end(), startsBefore);
+  return events;
+}
+
+static void writeJsonString(ostream& out, const string& str) {
+  out << '"';
+  for (int i=0; i<(int)str.size(); i++) {
+    unsigned char c = str[i];
+    if (c == '"' || c == '\\') out << '\\' << c;
+    else if (c < 0x20) out << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 0xf];
+    else out << c;
+  }
+  out << '"';
+}
+
+void NetworkProfile::writeStatistics(ostream& out) const {
+  out << "{\"profiling\": " << (_profiling ? "true" : "false") << ", \"algorithms\": [";
+  for (int i=0; i<(int)_statistics.size(); i++) {
+    const NodeStatistics& stats = _statistics[i];
+    out << (i ? ",\n  " : "\n  ") << "{\"index\": " << i << ", \"name\": ";
+    writeJsonString(out, stats.algorithm->name());
+    out << ", \"busyCalls\": " << stats.busyCalls
+        << ", \"idleCalls\": " << stats.idleCalls
+        << ", \"busyTime\": " << stats.busyTime
+        << ", \"idleTime\": " << stats.idleTime;
+    if (_profiling) {
+      out << ", \"cpuTime\": " << stats.cpuTime
+          << ", \"tokensConsumed\": " << stats.tokensConsumed
+          << ", \"tokensProduced\": " << stats.tokensProduced
+          << ", \"bufferHighWater\": " << stats.bufferHighWater;
+    }
+    out << "}";
+  }
+  out << "\n]}\n";
+}
+
+void NetworkProfile::writeTrace(ostream& out) const {
+  // complete events ("X"), with timestamps and durations in microseconds
+  vector<TraceEvent> events = trace();
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  for (int i=0; i<(int)events.size(); i++) {
+    const TraceEvent& event = events[i];
+    out << (i ? ",\n  " : "\n  ") << "{\"name\": ";
+    writeJsonString(out, _statistics[event.node].algorithm->name());
+    out << ", \"cat\": \"process\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << event.thread
+        << ", \"ts\": " << event.start * 1e6
+        << ", \"dur\": " << event.duration * 1e6
+        << ", \"args\": {\"index\": " << event.node << "}}";
+  }
+  out << "\n]}\n";
+}
 
 } // namespace scheduler
 } // namespace essentia
@@ -23,6 +23,9 @@
 #include <vector>
 #include <set>
 #include <stack>
+#include <chrono>
+#include <memory>
+#include <ostream>
 #include "../streaming/streamingalgorithm.h"
 #include "../essentiautil.h"
 
@@ -31,6 +34,7 @@ namespace streaming {
 
 class AlgorithmComposite;
 class SourceBase;
+class BufferArena;
 
 } // namespace streaming
 } // namespace essentia
@@ -79,6 +83,99 @@ typedef std::set<NetworkNode*> NodeSet;
 typedef std::stack<NetworkNode*> NodeStack;
 
 
+/**
+ * Counters gathered for each algorithm of the execution network when the
+ * network is run by the ParallelScheduler or when profiling is enabled. A call
+ * to process() is counted as busy when it returned OK or FINISHED, and as idle
+ * otherwise (ie: when the algorithm did not have enough input tokens or output
+ * space to do anything).
+ */
+struct NodeStatistics {
+  const streaming::Algorithm* algorithm;
+  int busyCalls;
+  int idleCalls;
+  double busyTime; // in seconds
+  double idleTime; // in seconds
+
+  // only gathered when profiling is enabled
+  double cpuTime;            // of the thread(s) running process(), in seconds
+  long long tokensConsumed;  // on all the inputs
+  long long tokensProduced;  // on all the outputs
+  int bufferHighWater;       // most tokens ever waiting in one of the output buffers
+
+  NodeStatistics(const streaming::Algorithm* algo = 0) :
+    algorithm(algo), busyCalls(0), idleCalls(0), busyTime(0), idleTime(0),
+    cpuTime(0), tokensConsumed(0), tokensProduced(0), bufferHighWater(0) {}
+};
+
+/**
+ * A busy call to process() recorded in the trace of a profiled network.
+ */
+struct TraceEvent {
+  int node;        // index of the algorithm in the statistics
+  int thread;      // 0 is the thread running the network
+  double start;    // since runPrepare(), in seconds
+  double duration; // in seconds
+
+  TraceEvent(int n, int t, double s, double d) : node(n), thread(t), start(s), duration(d) {}
+};
+
+/**
+ * Statistics of the algorithms of an execution network, filled in while it
+ * is run. The statistics of a node are only updated by the thread running
+ * it and each thread has its own trace, so that no locking is needed.
+ *
+ * Without profiling, only the busy/idle counters and wall times are kept.
+ * With profiling, the CPU time, the tokens going through the ports and the
+ * fill of the output buffers are looked at after each call, and busy calls
+ * are recorded in the trace.
+ */
+class NetworkProfile {
+ public:
+  NetworkProfile() : _profiling(false) {}
+
+  /**
+   * Clears the statistics, for the given algorithms in topological order.
+   */
+  void prepare(const std::vector<streaming::Algorithm*>& algos, int numberThreads, bool profiling);
+
+  /**
+   * Calls process() on the given node from the given thread (0 to
+   * numberThreads-1), updating its statistics.
+   */
+  streaming::AlgorithmStatus process(int node, int thread);
+
+  bool profiling() const { return _profiling; }
+  const std::vector<NodeStatistics>& statistics() const { return _statistics; }
+
+  /**
+   * Returns the busy calls of all the threads, sorted by start time.
+   */
+  std::vector<TraceEvent> trace() const;
+
+  /**
+   * Writes the statistics as a JSON object, with one entry per algorithm in
+   * topological order.
+   */
+  void writeStatistics(std::ostream& out) const;
+
+  /**
+   * Writes the trace in the Chrome trace event format, which can be opened
+   * in chrome://tracing or Perfetto, one track per thread.
+   */
+  void writeTrace(std::ostream& out) const;
+
+ protected:
+  std::vector<streaming::Algorithm*> _algos;
+  std::vector<NodeStatistics> _statistics;
+  std::vector<std::vector<TraceEvent> > _traces; // one per thread
+  bool _profiling;
+  std::chrono::steady_clock::time_point _origin;
+};
+
+class ParallelScheduler;
+
+
 
 /**
  * A Network is a structure that holds all algorithms that have been connected
@@ -131,6 +228,78 @@ class Network {
    */
   bool runStep();
 
+  /**
+   * Sets the number of threads used to run the network. With 1 thread, the
+   * algorithms are run in topological order by the calling thread. With more
+   * threads, the network is handed to a ParallelScheduler, which dispatches
+   * each algorithm on a work-stealing pool of threads as soon as all the
+   * algorithms it depends on are done for the current step. A value of 0 uses
+   * as many threads as there are hardware threads available.
+   *
+   * The new value is taken into account on the next call to runPrepare().
+   * The threads are started by the first run and are kept sleeping between
+   * runs, until the network is cleared or deleted.
+   */
+  void setNumberThreads(int numberThreads);
+  int numberThreads() const { return _numberThreads; }
+
+  /**
+   * When set, the network is run by the ParallelScheduler on the calling
+   * thread only, dispatching the algorithms which are ready in topological
+   * order. This gives the same execution order on every run (useful for
+   * tests and debugging), together with the per-algorithm statistics.
+   */
+  void setDeterministic(bool deterministic) { _deterministic = deterministic; }
+  bool deterministic() const { return _deterministic; }
+
+  /**
+   * Returns the busy/idle counters of all the algorithms of the execution
+   * network, in topological order. They are only gathered when the network
+   * is run by the ParallelScheduler or when profiling is enabled, and are
+   * reset by runPrepare().
+   */
+  const std::vector<NodeStatistics>& statistics() const { return _profile.statistics(); }
+
+  /**
+   * When set, the CPU time, the tokens consumed and produced and the high
+   * water mark of the output buffers are gathered for each algorithm on top
+   * of the busy/idle counters, and every busy call to process() is recorded
+   * to build a timeline of the run. This costs a few clock reads and a look
+   * at the ports on each call, without profiling the network runs as usual.
+   *
+   * The new value is taken into account on the next call to runPrepare().
+   */
+  void setProfiling(bool profiling) { _profiling = profiling; }
+  bool profiling() const { return _profiling; }
+
+  const NetworkProfile& profile() const { return _profile; }
+
+  /**
+   * Writes the statistics of the last run as JSON, see NetworkProfile.
+   */
+  void writeStatistics(std::ostream& out) const { _profile.writeStatistics(out); }
+
+  /**
+   * Writes the timeline of the last profiled run in the Chrome trace event
+   * format, see NetworkProfile.
+   */
+  void writeTrace(std::ostream& out) const { _profile.writeTrace(out); }
+
+  /**
+   * Number of threads used by the networks created from then on, except for
+   * the ones built while an algorithm is created by the AlgorithmFactory (eg:
+   * inside extractors and composites), which use 1 thread: they are run from
+   * within the network using the algorithm, on one of its threads.
+   */
+  static int defaultNumberThreads;
+
+  /**
+   * Whether the networks created from then on are profiled. Together with
+   * lastProfiled, this gives access to the profile of the network built
+   * inside a standard algorithm (eg: BeatTrackerMultiFeature).
+   */
+  static bool defaultProfiling;
+
   /**
    * Rebuilds the visible and execution network.
    */
@@ -202,6 +371,12 @@ class Network {
    */
   static Network* lastCreated;
 
+  /**
+   * Last instance of Network which has been prepared to run with profiling
+   * enabled, 0 if it has been deleted or if there is none.
+   */
+  static Network* lastProfiled;
+
  protected:
   bool _takeOwnership;
   streaming::Algorithm* _generator;
@@ -209,6 +384,18 @@ class Network {
   NetworkNode* _executionNetworkRoot;
   std::vector<streaming::Algorithm*> _toposortedNetwork;
 
+  int _numberThreads;
+  bool _deterministic;
+  bool _profiling;
+  ParallelScheduler* _scheduler;
+  NetworkProfile _profile;
+  std::shared_ptr<streaming::BufferArena> _bufferArena;
+
+  /**
+   * Deletes the parallel scheduler, if any.
+   */
+  void clearScheduler();
+
   /**
    * Build the network of visibly connected algorithms (ie: do not enter composite
    * algorithms) and stores its root in @c _visibleNetworkRoot.
@@ -253,6 +440,16 @@ class Network {
    */
   void checkBufferSizes();
 
+  /**
+   * Allocate the buffers of all the sources of the execution network from a
+   * single BufferArena, once their sizes are known. If they are all already
+   * allocated from the arena of the previous run (eg: the network is run
+   * again for the next file), this does nothing. Otherwise they are all
+   * moved to a new arena, and the previous one is given back once its last
+   * buffer left it.
+   */
+  void allocateBuffers();
+
   /**
    * Delete all the NetworkNodes used in the visible network. Do not touch the
    * algorithms pointed to by these nodes.
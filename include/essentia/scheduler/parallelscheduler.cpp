@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#include "parallelscheduler.h"
+#include "graphutils.h"
+#include "../streaming/streamingalgorithm.h"
+#include "../streaming/algorithms/poolstorage.h"
+using namespace std;
+using namespace essentia::streaming;
+
+namespace essentia {
+namespace scheduler {
+
+
+ParallelScheduler::ParallelScheduler(int numberThreads) :
+  _profile(0), _endOfStream(false), _remaining(0), _failed(false),
+  _numberQueues(numberThreads), _queued(0), _sleeping(0), _wave(0), _quit(false) {
+
+  if (numberThreads < 1) {
+    throw EssentiaException("ParallelScheduler: the number of threads should be at least 1");
+  }
+
+  if (numberThreads > 1) {
+    _queues.reset(new WorkQueue[numberThreads]);
+    // the calling thread is worker 0, only start the other ones
+    try {
+      for (int i=1; i<numberThreads; i++) {
+        _workers.push_back(thread(&ParallelScheduler::workerLoop, this, i));
+      }
+    }
+    catch (...) {
+      // the destructor is not called, stop the threads already started
+      stopWorkers();
+      throw;
+    }
+  }
+}
+
+void ParallelScheduler::prepare(NetworkNode* executionNetworkRoot,
+                                const vector<Algorithm*>& toposortedNetwork,
+                                NetworkProfile* profile) {
+  _algos = toposortedNetwork;
+  _profile = profile;
+  _endOfStream = false;
+
+  int n = (int)_algos.size();
+  map<Algorithm*, int> index;
+  for (int i=0; i<n; i++) index[_algos[i]] = i;
+
+  // keep the dependencies of the execution network as indices in the
+  // topological order, so that we don't need the nodes anymore afterwards
+  _children.assign(n, vector<int>());
+  NodeVector nodes = depthFirstSearch(executionNetworkRoot);
+  for (int i=0; i<(int)nodes.size(); i++) {
+    int parent = index[nodes[i]->algorithm()];
+    const NodeVector& children = nodes[i]->children();
+    for (int j=0; j<(int)children.size(); j++) {
+      _children[parent].push_back(index[children[j]->algorithm()]);
+    }
+  }
+
+  _active.assign(n, 0);
+  _pending.assign(n, 0);
+  _waitingParents.reset(new atomic<int>[n]);
+  _tainted.reset(new atomic<bool>[n]);
+
+  // PoolStorage algorithms in different branches may write to the same pool
+  // at the same time, which the pool then has to lock
+  if (!_workers.empty()) {
+    for (int i=0; i<n; i++) {
+      PoolStorageBase* storage = dynamic_cast<PoolStorageBase*>(_algos[i]);
+      if (storage && storage->pool()) storage->pool()->setThreadSafe(true);
+    }
+  }
+}
+
+ParallelScheduler::~ParallelScheduler() {
+  stopWorkers();
+}
+
+void ParallelScheduler::stopWorkers() {
+  {
+    lock_guard<mutex> lock(_sleepMutex);
+    _quit = true;
+  }
+  _wakeUp.notify_all();
+  for (int i=0; i<(int)_workers.size(); i++) _workers[i].join();
+}
+
+
+// returns false when there are no more steps to run
+bool ParallelScheduler::runStep() {
+  if (_algos.empty()) return false;
+
+  Algorithm* gen = _algos[0];
+
+  if (gen->shouldStop()) return false;
+
+#if DEBUGGING_ENABLED
+  restoreDebugLevels();
+  setDebugLevelForTimeIndex(gen->nProcess);
+  E_DEBUG(ENetwork, "-------- Running generator loop index " << gen->nProcess << " --------");
+#endif
+
+  // first run the generator once
+  _profile->process(0, 0);
+
+#if DEBUGGING_ENABLED
+  gen->nProcess++;
+#endif
+
+  _endOfStream = gen->shouldStop();
+
+  // then run all the other algorithms, and again those which could not write
+  // all their output together with their descendants, until they are all done
+  fill(_active.begin(), _active.end(), 1);
+  _active[0] = 0;
+
+  while (true) {
+    runWave();
+
+    if (_failed) {
+      exception_ptr error = _error;
+      _error = exception_ptr();
+      _failed = false;
+      rethrow_exception(error);
+    }
+
+    // nodes are in topological order, so a node is always visited after all
+    // of its parents
+    bool rerun = false;
+    fill(_active.begin(), _active.end(), 0);
+    for (int i=1; i<(int)_algos.size(); i++) {
+      if (_pending[i]) _active[i] = 1;
+      if (!_active[i]) continue;
+      rerun = true;
+      for (int j=0; j<(int)_children[i].size(); j++) _active[_children[i][j]] = 1;
+    }
+
+    if (!rerun) break;
+  }
+
+  return true;
+}
+
+void ParallelScheduler::runWave() {
+  int n = (int)_algos.size();
+  int count = 0;
+
+  for (int i=0; i<n; i++) {
+    _pending[i] = 0;
+    _waitingParents[i] = 0;
+    _tainted[i] = false;
+  }
+  for (int i=0; i<n; i++) {
+    if (!_active[i]) continue;
+    count++;
+    for (int j=0; j<(int)_children[i].size(); j++) {
+      if (_active[_children[i][j]]) _waitingParents[_children[i][j]]++;
+    }
+  }
+
+  if (count == 0) return;
+  _remaining = count;
+
+  // push the roots of the wave in reverse order, so that the calling thread
+  // starts with the first one in topological order
+  for (int i=n-1; i>=0; i--) {
+    if (_active[i] && _waitingParents[i] == 0) push(0, i);
+  }
+
+  if (_workers.empty()) {
+    while (!_ready.empty()) {
+      int node = _ready.top();
+      _ready.pop();
+      runNode(0, node);
+    }
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(_sleepMutex);
+    _wave++;
+  }
+  _wakeUp.notify_all();
+
+  work(0);
+}
+
+void ParallelScheduler::runNode(int worker, int node) {
+  Algorithm* algo = _algos[node];
+
+  // once an algorithm failed, the remaining ones in the wave are only marked
+  // as done, the error is rethrown at the end of the wave
+  if (!_failed) {
+    try {
+      // only propagate the end of stream marker as long as none of the
+      // ancestors of this algorithm has been rescheduled to run
+      algo->shouldStop(_endOfStream && !_tainted[node]);
+      AlgorithmStatus status;
+      do {
+        status = _profile->process(node, worker);
+#if DEBUGGING_ENABLED
+        if (status == OK || status == FINISHED) algo->nProcess++;
+#endif
+      } while (status == OK);
+
+      if (status == NO_OUTPUT) {
+        _pending[node] = 1;
+        E_DEBUG(EScheduler, "Rescheduling algorithm " << algo->name() <<
+                " to run later, output buffers temporarily full");
+      }
+    }
+    catch (...) {
+      lock_guard<mutex> lock(_errorMutex);
+      if (!_error) _error = current_exception();
+      _failed = true;
+    }
+  }
+
+  bool tainted = _pending[node] || _tainted[node];
+  const vector<int>& children = _children[node];
+  for (int i=0; i<(int)children.size(); i++) {
+    int child = children[i];
+    if (!_active[child]) continue;
+    if (tainted) _tainted[child] = true;
+    if (--_waitingParents[child] == 0) push(worker, child);
+  }
+
+  if (--_remaining == 0 && !_workers.empty()) {
+    // wake up everybody waiting for work so that they see the wave is over
+    { lock_guard<mutex> lock(_sleepMutex); }
+    _workReady.notify_all();
+  }
+}
+
+void ParallelScheduler::push(int worker, int node) {
+  if (_workers.empty()) {
+    _ready.push(node);
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(_queues[worker].mutex);
+    _queues[worker].nodes.push_back(node);
+  }
+  _queued++;
+
+  // only wake up a worker if one is idle, the busy ones look into the queues
+  // before going to sleep. A worker counts itself as sleeping before checking
+  // _queued, so either it sees this node or we see it sleeping, and taking
+  // the mutex makes sure it is waiting before being notified.
+  if (_sleeping > 0) {
+    { lock_guard<mutex> lock(_sleepMutex); }
+    _workReady.notify_one();
+  }
+}
+
+bool ParallelScheduler::take(int worker, int& node) {
+  // newest node from our own queue first, its inputs are still hot in the cache
+  {
+    WorkQueue& queue = _queues[worker];
+    lock_guard<mutex> lock(queue.mutex);
+    if (!queue.nodes.empty()) {
+      node = queue.nodes.back();
+      queue.nodes.pop_back();
+      _queued--;
+      return true;
+    }
+  }
+
+  // otherwise steal the oldest node from another worker
+  for (int i=1; i<_numberQueues; i++) {
+    WorkQueue& queue = _queues[(worker + i) % _numberQueues];
+    lock_guard<mutex> lock(queue.mutex);
+    if (!queue.nodes.empty()) {
+      node = queue.nodes.front();
+      queue.nodes.pop_front();
+      _queued--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ParallelScheduler::work(int worker) {
+  int node;
+  while (_remaining > 0) {
+    if (take(worker, node)) {
+      runNode(worker, node);
+      continue;
+    }
+
+    // _queued can be negative for a moment, when a node is taken before
+    // push() counted it
+    unique_lock<mutex> lock(_sleepMutex);
+    _sleeping++;
+    while (_queued <= 0 && _remaining > 0) _workReady.wait(lock);
+    _sleeping--;
+  }
+}
+
+void ParallelScheduler::workerLoop(int worker) {
+  unsigned int wave = 0;
+  while (true) {
+    {
+      unique_lock<mutex> lock(_sleepMutex);
+      while (!_quit && _wave == wave) _wakeUp.wait(lock);
+      if (_quit) return;
+      wave = _wave;
+    }
+    work(worker);
+  }
+}
+
+} // namespace scheduler
+} // namespace essentia
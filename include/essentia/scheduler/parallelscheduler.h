@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_SCHEDULER_PARALLELSCHEDULER_H
+#define ESSENTIA_SCHEDULER_PARALLELSCHEDULER_H
+
+#include <vector>
+#include <deque>
+#include <queue>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include "network.h"
+
+namespace essentia {
+namespace scheduler {
+
+
+/**
+ * The ParallelScheduler runs the execution network of a Network as a dataflow
+ * graph instead of as a linear list of algorithms.
+ *
+ * As with Network::runStep(), each step runs the generator once and then all
+ * the other algorithms until they have consumed everything on their inputs.
+ * Inside a step, an algorithm is dispatched as soon as all its parents in the
+ * execution network are done, ie: when all the tokens it can get for this step
+ * are waiting in its input buffers. Independent branches of the network thus
+ * run concurrently on a pool of worker threads, each of them having its own
+ * queue of ready algorithms and stealing work from the others when it runs
+ * out of it. The calling thread takes part in the work as well.
+ *
+ * An algorithm which could not write all its output (NO_OUTPUT) is run again
+ * once its descendants have made some room in the buffers, and the end of
+ * stream is not signaled to them until that happens, in the same way as
+ * Network::runStep() does.
+ *
+ * This is safe because a PhantomBuffer is never accessed concurrently by its
+ * writer and its readers (readers only start once the writer is done), and
+ * each reader only modifies its own read window. Algorithms in independent
+ * branches should not share any state other than a Pool written to by
+ * PoolStorage algorithms, which the scheduler makes thread-safe.
+ *
+ * With a single thread, the algorithms which are ready are run in topological
+ * order, which makes the execution fully deterministic.
+ */
+class ParallelScheduler {
+ public:
+  /**
+   * Starts the worker threads, which then sleep until the network is run. A
+   * scheduler is kept by its Network across runs, so that they are only
+   * started once.
+   */
+  explicit ParallelScheduler(int numberThreads);
+  ~ParallelScheduler();
+
+  int numberThreads() const { return _numberQueues; }
+
+  /**
+   * Sets up the scheduler for the given execution network, before running it.
+   * The statistics of the algorithms are gathered in the given profile, which
+   * should have been prepared for the same algorithms and number of threads.
+   */
+  void prepare(NetworkNode* executionNetworkRoot,
+               const std::vector<streaming::Algorithm*>& toposortedNetwork,
+               NetworkProfile* profile);
+
+  /**
+   * Processes all tokens generated with one call of process() on the
+   * generator. Returns false if there are no more tokens to process.
+   */
+  bool runStep();
+
+ protected:
+  std::vector<streaming::Algorithm*> _algos; // in topological order, generator first
+  std::vector<std::vector<int> > _children;
+  NetworkProfile* _profile;
+
+  // state of the current wave of execution
+  bool _endOfStream;
+  std::vector<char> _active;   // whether the node takes part in the wave
+  std::vector<char> _pending;  // whether the node returned NO_OUTPUT
+  std::unique_ptr<std::atomic<int>[]> _waitingParents;
+  std::unique_ptr<std::atomic<bool>[]> _tainted; // an ancestor has been rescheduled
+  std::atomic<int> _remaining;
+  std::atomic<bool> _failed;
+  std::exception_ptr _error;
+  std::mutex _errorMutex;
+
+  // ready nodes when running on the calling thread only
+  std::priority_queue<int, std::vector<int>, std::greater<int> > _ready;
+
+  // worker threads and their queues of ready nodes
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<int> nodes;
+  };
+  std::vector<std::thread> _workers;
+  std::unique_ptr<WorkQueue[]> _queues;
+  int _numberQueues;
+  std::atomic<int> _queued;
+  std::atomic<int> _sleeping; // workers waiting in work() for ready nodes
+  std::mutex _sleepMutex;
+  std::condition_variable _wakeUp;    // a wave starts, or the scheduler quits
+  std::condition_variable _workReady; // a node is queued, or the wave is over
+  unsigned int _wave;
+  bool _quit;
+
+  void runWave();
+  void runNode(int worker, int node);
+  void push(int worker, int node);
+  bool take(int worker, int& node);
+  void work(int worker);
+  void workerLoop(int worker);
+  void stopWorkers();
+};
+
+} // namespace scheduler
+} // namespace essentia
+
+#endif // ESSENTIA_SCHEDULER_PARALLELSCHEDULER_H
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#include "bufferarena.h"
+#include "../types.h"
+#include "../threading.h"
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+namespace essentia {
+namespace streaming {
+
+// Blocks of the arenas which are not used anymore. There are only a few of
+// them at a time: one per network being built, plus the one that a network
+// gives back when its buffers are laid out again.
+static const int maxPooledBlocks = 4;
+
+struct PooledBlock {
+  char* block;
+  size_t capacity;
+};
+
+struct BlockPool {
+  ForcedMutex mutex;
+  vector<PooledBlock> blocks;
+};
+
+// never destroyed: an arena can be given back while the static objects are
+// being destroyed, if the algorithms which use it are static themselves
+static BlockPool& blockPool() {
+  static BlockPool* pool = new BlockPool();
+  return *pool;
+}
+
+
+shared_ptr<BufferArena> BufferArena::create(size_t capacity) {
+  capacity = alignedSize(capacity);
+  BlockPool& pool = blockPool();
+  {
+    // take the smallest block which is large enough
+    ForcedMutexLocker lock(pool.mutex);
+    int best = -1;
+    for (int i=0; i<(int)pool.blocks.size(); i++) {
+      if (pool.blocks[i].capacity >= capacity &&
+          (best < 0 || pool.blocks[i].capacity < pool.blocks[best].capacity)) {
+        best = i;
+      }
+    }
+    if (best >= 0) {
+      PooledBlock block = pool.blocks[best];
+      pool.blocks.erase(pool.blocks.begin() + best);
+      return shared_ptr<BufferArena>(new BufferArena(block.block, block.capacity));
+    }
+  }
+
+  return shared_ptr<BufferArena>(new BufferArena(new char[capacity + alignment], capacity));
+}
+
+void BufferArena::clearPool() {
+  BlockPool& pool = blockPool();
+  ForcedMutexLocker lock(pool.mutex);
+  for (int i=0; i<(int)pool.blocks.size(); i++) delete[] pool.blocks[i].block;
+  pool.blocks.clear();
+}
+
+BufferArena::BufferArena(char* block, size_t capacity) :
+  _block(block), _capacity(capacity), _used(0) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(block);
+  _data = block + (alignment - address % alignment) % alignment;
+}
+
+BufferArena::~BufferArena() {
+  BlockPool& pool = blockPool();
+  ForcedMutexLocker lock(pool.mutex);
+  if ((int)pool.blocks.size() < maxPooledBlocks) {
+    PooledBlock block = { _block, _capacity };
+    pool.blocks.push_back(block);
+  }
+  else {
+    delete[] _block;
+  }
+}
+
+void* BufferArena::allocate(size_t size) {
+  size = alignedSize(size);
+  if (size > _capacity - _used) {
+    throw EssentiaException("BufferArena: cannot allocate ", size, " bytes, free bytes left: ", _capacity - _used);
+  }
+  void* slice = _data + _used;
+  _used += size;
+  return slice;
+}
+
+} // namespace streaming
+} // namespace essentia
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2006-2016  Music Technology Group - Universitat Pompeu Fabra
+ *
+ * This file is part of Essentia
+ *
+ * Essentia is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation (FSF), either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the Affero GNU General Public License
+ * version 3 along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#ifndef ESSENTIA_BUFFERARENA_H
+#define ESSENTIA_BUFFERARENA_H
+
+#include <cstddef>
+#include <memory>
+
+namespace essentia {
+namespace streaming {
+
+/**
+ * A BufferArena is a single block of memory from which the buffers of the
+ * sources of a scheduler::Network are allocated, instead of each of them
+ * allocating its own storage. The network computes the total size once, when
+ * it is prepared to run, and the buffers then just take consecutive slices of
+ * the block.
+ *
+ * An arena is shared by the buffers allocated from it, so that it lives as
+ * long as the last of them, whatever is deleted first between the network and
+ * its algorithms. Once it is not used anymore, its block is kept in a small
+ * process-wide pool, so that the next network with the same buffers (eg: the
+ * same network built again for the next file) gets it back without asking
+ * the system for memory.
+ */
+class BufferArena {
+ public:
+  /**
+   * Alignment of the slices given by allocate(), one cache line so that two
+   * buffers written by different threads never share one.
+   */
+  static const size_t alignment = 64;
+
+  /**
+   * Number of bytes taken in an arena by a slice of the given size.
+   */
+  static size_t alignedSize(size_t size) {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  /**
+   * Returns an arena of at least the given capacity, reusing a pooled block
+   * when there is one large enough.
+   */
+  static std::shared_ptr<BufferArena> create(size_t capacity);
+
+  /**
+   * Frees the blocks kept in the pool.
+   */
+  static void clearPool();
+
+  ~BufferArena();
+
+  /**
+   * Returns the next slice of the given size. Throws an EssentiaException if
+   * the arena is full.
+   */
+  void* allocate(size_t size);
+
+  size_t capacity() const { return _capacity; }
+  size_t used() const { return _used; }
+
+ protected:
+  BufferArena(char* block, size_t capacity);
+
+  char* _block;    // as allocated, the first slice starts at the next alignment
+  char* _data;
+  size_t _capacity;
+  size_t _used;
+
+ private:
+  BufferArena(const BufferArena&);
+  BufferArena& operator=(const BufferArena&);
+};
+
+} // namespace streaming
+} // namespace essentia
+
+#endif // ESSENTIA_BUFFERARENA_H
@@ -21,11 +21,14 @@
 #define ESSENTIA_MULTIRATEBUFFER_H
 
 #include <vector>
+#include <memory>
 #include "../types.h"
 
 namespace essentia {
 namespace streaming {
 
+class BufferArena;
+
 template <typename T>
 class MultiRateBuffer {
 
@@ -36,6 +39,11 @@ class MultiRateBuffer {
   virtual BufferInfo bufferInfo() const = 0;
   virtual void setBufferInfo(const BufferInfo& info) = 0;
 
+  // where the storage of the buffer comes from, see BufferArena
+  virtual size_t storageSize() const = 0;
+  virtual const BufferArena* arena() const = 0;
+  virtual void allocateFrom(const std::shared_ptr<BufferArena>& arena) = 0;
+
   // add/remove readers to/from the buffer
   // returns the id of the newly attached reader
   virtual ReaderID addReader(bool startFromZero = false) = 0;
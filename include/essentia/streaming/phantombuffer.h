@@ -21,7 +21,9 @@
 #define ESSENTIA_PHANTOMBUFFER_H
 
 #include <vector>
+#include <memory>
 #include "multiratebuffer.h"
+#include "bufferarena.h"
 #include "../roguevector.h"
 #include "../threading.h"
 #include "../essentiautil.h"
@@ -61,8 +63,8 @@ class PhantomBuffer : public MultiRateBuffer<T> {
 
  public:
 
-  PhantomBuffer(SourceBase* parent, BufferUsage::BufferUsageType type) {
-    _parent = parent;
+  PhantomBuffer(SourceBase* parent, BufferUsage::BufferUsageType type) :
+    _parent(parent), _bufferSize(0), _phantomSize(0), _buffer(0) {
     setBufferType(type);
   }
 
@@ -104,23 +106,28 @@ class PhantomBuffer : public MultiRateBuffer<T> {
   }
 
   void setBufferInfo(const BufferInfo& info) {
-    _bufferSize = info.size;
-    _phantomSize = info.maxContiguousElements;
-    _buffer.resize(_bufferSize + _phantomSize);
+    resize(info.size, info.maxContiguousElements);
   }
 
   PhantomBuffer(SourceBase* parent, int size, int phantomSize) :
     _parent(parent),
     _bufferSize(size),
     _phantomSize(phantomSize),
-    _buffer(size + phantomSize) {
+    _buffer(0) {
     // initialize views and all??
   }
 
+  ~PhantomBuffer() { releaseStorage(); }
+
+  size_t storageSize() const { return (_bufferSize + _phantomSize) * sizeof(T); }
+  const BufferArena* arena() const { return _arena.get(); }
+
   /**
-   * @todo implement me if necessary
+   * Moves the storage of the buffer (phantom zone included) to a slice of the
+   * given arena, keeping its contents. The buffer keeps the arena alive until
+   * it is resized, allocated from another arena, or deleted.
    */
-  ~PhantomBuffer() {}
+  void allocateFrom(const std::shared_ptr<BufferArena>& arena);
 
   const std::vector<T>& readView(ReaderID id) const;
   std::vector<T>& writeView() { return _writeView; }
@@ -160,7 +167,9 @@ class PhantomBuffer : public MultiRateBuffer<T> {
    *       it takes too much time, as it should be called only very rarely
    */
   void resize(int size, int phantomSize) {
-    _buffer.resize(size+phantomSize);
+    // the storage might come from an arena, do not give it up for nothing
+    if (size == _bufferSize && phantomSize == _phantomSize) return;
+    resizeStorage(size+phantomSize);
     _bufferSize = size;
     _phantomSize = phantomSize;
   }
@@ -193,9 +202,16 @@ class PhantomBuffer : public MultiRateBuffer<T> {
   SourceBase* _parent;
 
   int _bufferSize, _phantomSize; // bufferSize does not include phantomSize
-  std::vector<T> _buffer; // the buffer where data is stored
   // bufferSize must be > phantomSize in all cases
 
+  // the buffer where data is stored, either _ownedBuffer or a slice of _arena.
+  // It is only allocated when first written to, if the network did not
+  // allocate it from its arena before, so that buffers which get resized
+  // (or moved to an arena) before running never allocate memory for nothing
+  T* _buffer;
+  std::vector<T> _ownedBuffer;
+  std::shared_ptr<BufferArena> _arena;
+
   Window _writeWindow;
   std::vector<Window> _readWindow;
 
@@ -215,6 +231,13 @@ class PhantomBuffer : public MultiRateBuffer<T> {
   void updateReadView(ReaderID id);
   void updateWriteView();
 
+  // storage of the buffer: resizeStorage() (which leaves the arena, if any)
+  // must be called before _bufferSize and _phantomSize are updated, as it
+  // uses them to know how many elements are currently stored
+  void allocateStorage();
+  void resizeStorage(int size);
+  void releaseStorage();
+
   // mutex should be locked before entering this function
   // make sure it doesn't overflow
   int availableForRead(ReaderID id) const;
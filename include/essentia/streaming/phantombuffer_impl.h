@@ -20,6 +20,9 @@
 #ifndef ESSENTIA_PHANTOMBUFFER_IMPL_H
 #define ESSENTIA_PHANTOMBUFFER_IMPL_H
 
+#include <algorithm>
+#include <iterator>
+#include <memory>
 #include "streamingalgorithm.h"
 
 namespace essentia {
@@ -111,6 +114,7 @@ bool PhantomBuffer<T>::acquireForWrite(int requested) {
   }
 
   MutexLocker lock(mutex); NOWARN_UNUSED(lock);
+  if (!_buffer) allocateStorage();
   if (availableForWrite() < requested) return false;
 
   _writeWindow.end = _writeWindow.begin + requested;
@@ -201,13 +205,13 @@ template <typename T>
 inline void PhantomBuffer<T>::updateReadView(ReaderID id) {
   const RogueVector<T>& vconst = static_cast<const RogueVector<T>&>(readView(id));
   RogueVector<T>& v = const_cast<RogueVector<T>&>(vconst);
-  v.setData(&_buffer[0] + _readWindow[id].begin);
+  v.setData(_buffer + _readWindow[id].begin);
   v.setSize(_readWindow[id].end - _readWindow[id].begin);
 }
 
 template <typename T>
 inline void PhantomBuffer<T>::updateWriteView() {
-  _writeView.setData(&_buffer[0] + _writeWindow.begin);
+  _writeView.setData(_buffer + _writeWindow.begin);
   _writeView.setSize(_writeWindow.end - _writeWindow.begin);
 }
 
@@ -294,6 +298,68 @@ void PhantomBuffer<T>::relocateReadWindow(ReaderID id) {
   }
 }
 
+template <typename T>
+void PhantomBuffer<T>::allocateFrom(const std::shared_ptr<BufferArena>& arena) {
+  int size = _bufferSize + _phantomSize;
+  T* storage = static_cast<T*>(arena->allocate(size * sizeof(T)));
+  if (_buffer) {
+    std::uninitialized_copy(std::make_move_iterator(_buffer),
+                            std::make_move_iterator(_buffer + size),
+                            storage);
+    releaseStorage();
+  }
+  else {
+    std::uninitialized_fill(storage, storage + size, T());
+  }
+  _buffer = storage;
+  _arena = arena;
+
+  updateWriteView();
+  for (int i=0; i<(int)_readWindow.size(); i++) updateReadView(i);
+}
+
+template <typename T>
+void PhantomBuffer<T>::allocateStorage() {
+  _ownedBuffer.resize(_bufferSize + _phantomSize);
+  _buffer = &_ownedBuffer[0];
+}
+
+template <typename T>
+void PhantomBuffer<T>::resizeStorage(int size) {
+  // nothing to keep, the storage will be allocated with the new size
+  if (!_buffer) return;
+
+  if (!_arena) {
+    _ownedBuffer.resize(size);
+    _buffer = &_ownedBuffer[0];
+    return;
+  }
+
+  // the slice of the arena has a fixed size, so move back to our own storage;
+  // the network allocates the buffer from an arena again when it next runs
+  std::vector<T> owned(size);
+  std::move(_buffer, _buffer + (std::min)(size, _bufferSize + _phantomSize), owned.begin());
+  releaseStorage();
+  _ownedBuffer.swap(owned);
+  _buffer = &_ownedBuffer[0];
+
+  updateWriteView();
+  for (int i=0; i<(int)_readWindow.size(); i++) updateReadView(i);
+}
+
+template <typename T>
+void PhantomBuffer<T>::releaseStorage() {
+  if (_arena) {
+    // the elements were constructed in place, the memory goes with the arena
+    for (int i=0; i<_bufferSize+_phantomSize; i++) _buffer[i].~T();
+    _arena.reset();
+  }
+  else {
+    std::vector<T>().swap(_ownedBuffer);
+  }
+  _buffer = 0;
+}
+
 template <typename T>
 void PhantomBuffer<T>::reset() {
   // we don't need to clear the buffer, because when new data is written to the
@@ -93,6 +93,11 @@ class Sink : public SinkBase {
                               ", which has not been connected.");
   }
 
+  virtual int totalConsumed() const {
+    if (!_source && !_sproxy) return 0;
+    return buffer().totalTokensRead(_id);
+  }
+
   virtual void reset() {}
 
   TokenType pop() {
@@ -85,6 +85,12 @@ class SinkBase : public Connector {
   // should return a TokenType*
   virtual const void* getFirstToken() const = 0;
 
+  /**
+   * Returns the number of tokens consumed by this sink since the connected
+   * buffer was last reset.
+   */
+  virtual int totalConsumed() const = 0;
+
  protected:
   // methods for standard connections
 
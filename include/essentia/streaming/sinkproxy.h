@@ -232,6 +232,10 @@ class SinkProxy : public SinkProxyBase {
     return buffer().availableForRead(_id);
   }
 
+  virtual int totalConsumed() const {
+    return buffer().totalTokensRead(_id);
+  }
+
   virtual void reset() {}
 
 };
@@ -62,6 +62,18 @@ class Source : public SourceBase {
     _buffer->setBufferInfo(info);
   }
 
+  virtual size_t bufferStorageSize() const {
+    return _buffer->storageSize();
+  }
+
+  virtual const BufferArena* bufferArena() const {
+    return _buffer->arena();
+  }
+
+  virtual void allocateBufferFrom(const std::shared_ptr<BufferArena>& arena) {
+    _buffer->allocateFrom(arena);
+  }
+
   int totalProduced() const { return _buffer->totalTokensWritten(); }
 
   ReaderID addReader() {
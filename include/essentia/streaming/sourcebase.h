@@ -20,6 +20,7 @@
 #ifndef ESSENTIA_SOURCEBASE_H
 #define ESSENTIA_SOURCEBASE_H
 
+#include <memory>
 #include "../types.h"
 #include "../connector.h"
 
@@ -31,6 +32,7 @@ class SourceProxyBase;
   //template <typename T> class SourceProxy;
 class SinkBase;
 class Algorithm;
+class BufferArena;
 
 void connect(SourceBase& source, SinkBase& sink);
 void disconnect(SourceBase& source, SinkBase& sink);
@@ -113,6 +115,12 @@ class SourceBase : public Connector {
   virtual BufferInfo bufferInfo() const = 0;
   virtual void setBufferInfo(const BufferInfo& info) = 0;
 
+  // the network allocates the buffers of its sources from a single arena,
+  // see scheduler::Network::allocateBuffers()
+  virtual size_t bufferStorageSize() const = 0;
+  virtual const BufferArena* bufferArena() const = 0;
+  virtual void allocateBufferFrom(const std::shared_ptr<BufferArena>& arena) = 0;
+
  protected:
   // made those protected so that only our friend streaming::{dis}connect() functions can access these
   // @todo this function should probably be protected by a mutex (?)
@@ -80,6 +80,18 @@ class SourceProxyBase : public SourceBase {
     _proxiedSource->setBufferInfo(info);
   }
 
+  virtual size_t bufferStorageSize() const {
+    return _proxiedSource->bufferStorageSize();
+  }
+
+  virtual const BufferArena* bufferArena() const {
+    return _proxiedSource->bufferArena();
+  }
+
+  virtual void allocateBufferFrom(const std::shared_ptr<BufferArena>& arena) {
+    _proxiedSource->allocateBufferFrom(arena);
+  }
+
 
   //---- StreamConnector interface hijacking for proxies ----------------------------------------//
 
@@ -68,6 +68,9 @@ class ForcedMutex {
   CRITICAL_SECTION criticalSection;
  public:
   ForcedMutex()  { InitializeCriticalSection(&criticalSection); }
+  // copying an object which owns a mutex gives it a new, unlocked one
+  ForcedMutex(const ForcedMutex&) { InitializeCriticalSection(&criticalSection); }
+  ForcedMutex& operator=(const ForcedMutex&) { return *this; }
   ~ForcedMutex() { DeleteCriticalSection(&criticalSection); }
   void lock()    { EnterCriticalSection(&criticalSection); }
   void unlock()  { LeaveCriticalSection(&criticalSection); }
@@ -85,6 +88,12 @@ class ForcedMutex {
     if (pthread_mutex_init(&pthreadMutex,0) != 0)
       throw EssentiaException("can't create mutex type");
   }
+  // copying an object which owns a mutex gives it a new, unlocked one
+  ForcedMutex(const ForcedMutex&) {
+    if (pthread_mutex_init(&pthreadMutex,0) != 0)
+      throw EssentiaException("can't create mutex type");
+  }
+  ForcedMutex& operator=(const ForcedMutex&) { return *this; }
   ~ForcedMutex() { pthread_mutex_destroy(&pthreadMutex); }
   void lock()    { pthread_mutex_lock(&pthreadMutex); }
   void unlock()  { pthread_mutex_unlock(&pthreadMutex); }
@@ -100,6 +109,19 @@ class ForcedMutexLocker {
   ~ForcedMutexLocker() { _mutex.unlock(); }
 };
 
+// locks the mutex only when asked to, for the objects which only need to be
+// protected while they are shared between threads (ex: a Pool written to by
+// a network run on several threads)
+class ConditionalMutexLocker {
+ protected:
+  ForcedMutex* _mutex;
+ public:
+  ConditionalMutexLocker(ForcedMutex& mutex, bool locking) : _mutex(locking ? &mutex : 0) {
+    if (_mutex) _mutex->lock();
+  }
+  ~ConditionalMutexLocker() { if (_mutex) _mutex->unlock(); }
+};
+
 
 } // namespace essentia
 
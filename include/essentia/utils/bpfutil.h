@@ -33,10 +33,10 @@ namespace essentia {
       public:
         BPF() {
         }
-        BPF(std::vector<Real> xPoints, std::vector<Real> yPoints) {
+        BPF(const std::vector<Real>& xPoints, const std::vector<Real>& yPoints) {
           init(xPoints,yPoints);
         }
-        void init(std::vector<Real> xPoints, std::vector<Real> yPoints) {
+        void init(const std::vector<Real>& xPoints, const std::vector<Real>& yPoints) {
           _xPoints = xPoints;
           _yPoints = yPoints;
           if (_xPoints.size() != _yPoints.size()) {
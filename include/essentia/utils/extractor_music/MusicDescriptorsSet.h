@@ -31,6 +31,7 @@
 #include "essentia/algorithmfactory.h"
 #include "essentia/streaming/algorithms/poolstorage.h"
 #include "essentia/streaming/algorithms/vectorinput.h"
+#include "essentia/streaming/algorithms/vectoroutput.h"
 
 using namespace std;
 using namespace essentia;
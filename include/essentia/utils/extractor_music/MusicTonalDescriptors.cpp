@@ -24,7 +24,8 @@ using namespace essentia::streaming;
 
 const string MusicTonalDescriptors::nameSpace="tonal.";  
 
-void MusicTonalDescriptors::createNetworkTuningFrequency(SourceBase& source, Pool& pool){
+void MusicTonalDescriptors::createNetworkTuningFrequency(SourceBase& source, Pool& pool,
+                                                         vector<vector<Real> >* spectra){
 
   int frameSize = int(options.value<Real>("tonal.frameSize"));
   int hopSize =   int(options.value<Real>("tonal.hopSize"));
@@ -59,24 +60,22 @@ void MusicTonalDescriptors::createNetworkTuningFrequency(SourceBase& source, Poo
   peaks->output("frequencies")      >> tuning->input("frequencies");
   tuning->output("tuningFrequency") >> PC(pool, nameSpace + "tuning_frequency");
   tuning->output("tuningCents")     >> NOWHERE;
+
+  // the tonal descriptors use the same frames, keep their spectra for later
+  if (spectra) {
+    Algorithm* storage = new VectorOutput<vector<Real> >(spectra);
+    spec->output("spectrum")        >> storage->input("data");
+  }
 }
 
 void MusicTonalDescriptors::createNetwork(SourceBase& source, Pool& pool) {
 
-  // Using the 20-3500 Hz frequency ranges as suggested by Angel Faraldo
-  // This range improves key estimation significantly for electronic music 
-  // (lowering max frequency removes harmonics that would confuse  estimation).
-  // It does not degrate estimation for pop music. Not evaluated on classical.
-  // Previous range: 40-5000 Hz
-
   int frameSize = int(options.value<Real>("tonal.frameSize"));
   int hopSize =   int(options.value<Real>("tonal.hopSize"));
   string silentFrames = options.value<string>("tonal.silentFrames");
   string windowType = options.value<string>("tonal.windowType");
   int zeroPadding = int(options.value<Real>("tonal.zeroPadding"));
 
-  Real tuningFreq = pool.value<vector<Real> >(nameSpace + "tuning_frequency").back();
-
   AlgorithmFactory& factory = AlgorithmFactory::instance();
 
   Algorithm* fc = factory.create("FrameCutter",
@@ -87,6 +86,26 @@ void MusicTonalDescriptors::createNetwork(SourceBase& source, Pool& pool) {
                                 "type", windowType,
                                 "zeroPadding", zeroPadding);
   Algorithm* spec = factory.create("Spectrum");
+
+  source                       >> fc->input("signal");
+  fc->output("frame")          >> w->input("frame");
+  w->output("frame")           >> spec->input("frame");
+
+  createNetworkFromSpectrum(spec->output("spectrum"), pool);
+}
+
+void MusicTonalDescriptors::createNetworkFromSpectrum(SourceBase& spectrum, Pool& pool) {
+
+  // Using the 20-3500 Hz frequency ranges as suggested by Angel Faraldo
+  // This range improves key estimation significantly for electronic music 
+  // (lowering max frequency removes harmonics that would confuse  estimation).
+  // It does not degrate estimation for pop music. Not evaluated on classical.
+  // Previous range: 40-5000 Hz
+
+  Real tuningFreq = pool.value<vector<Real> >(nameSpace + "tuning_frequency").back();
+
+  AlgorithmFactory& factory = AlgorithmFactory::instance();
+
   Algorithm* peaks = factory.create("SpectralPeaks",
                                     "maxPeaks", 60,
                                     "magnitudeThreshold", 0.00001,
@@ -96,23 +115,44 @@ void MusicTonalDescriptors::createNetwork(SourceBase& source, Pool& pool) {
   // Detecting 60 peaks instead of all of them as it may be better not to 
   // consider too many harmonics, especially for electronic music
 
-  // Using HPCP parameters recommended for electronic music:
-  Algorithm* hpcp_key = factory.create("HPCP",
-                                       "size", 36,
-                                       "referenceFrequency", tuningFreq,
-                                       "bandPreset", false,
-                                       "minFrequency", 20.0,
-                                       //"bandSplitFrequency", 250.0, // TODO ???
-                                       "maxFrequency", 3500.0,
-                                       "weightType", "cosine",
-                                       "nonLinear", false,
-                                       "windowSize", 1.);
-  // Previously used parameter values: 
+  // The key, chord and tuning profiles are computed from the same peaks by
+  // one MultiHPCP, in this order:
+  // - key: using HPCP parameters recommended for electronic music;
+  // - chords: TODO review this parameters to improve our chords detection;
+  // - tuning: the chord parameters with a higher resolution.
+  vector<int> sizes(3, 36);
+  sizes[2] = 120;
+  vector<int> harmonics(3, 8);
+  harmonics[0] = 0;
+  vector<bool> bandPresets(3, true);
+  bandPresets[0] = false;
+  // TODO ??? bandSplitFrequency = 250.0 for the key
+  vector<bool> nonLinear(3, true);
+  nonLinear[0] = false;
+  vector<Real> windowSizes(3, 0.5);
+  windowSizes[0] = 1.;
+
+  Algorithm* hpcps = factory.create("MultiHPCP",
+                                    "size", sizes,
+                                    "referenceFrequency", vector<Real>(1, tuningFreq),
+                                    "harmonics", harmonics,
+                                    "bandPreset", bandPresets,
+                                    "minFrequency", vector<Real>(1, 20.0),
+                                    "maxFrequency", vector<Real>(1, 3500.0),
+                                    "bandSplitFrequency", vector<Real>(1, 500.0),
+                                    "weightType", vector<string>(1, "cosine"),
+                                    "nonLinear", nonLinear,
+                                    "windowSize", windowSizes);
+  // Previously used parameter values for the key:
   // - nonLinear = false
   // - weightType = squaredCosine
   // - windowSize = 4.0/3.0
   // - bandPreset = true
 
+  Algorithm* hpcp_key = factory.create("HPCPSelector", "index", 0);
+  Algorithm* hpcp_chord = factory.create("HPCPSelector", "index", 1);
+  Algorithm* hpcp_tuning = factory.create("HPCPSelector", "index", 2);
+
   Algorithm* skey_temperley = factory.create("Key",
                                    "numHarmonics", 4,
                                    "pcpSize", 36,
@@ -137,29 +177,15 @@ void MusicTonalDescriptors::createNetwork(SourceBase& source, Pool& pool) {
                                    "usePolyphony", true,
                                    "useThreeChords", true);
 
-  // TODO review this parameters to improve our chords detection
-  Algorithm* hpcp_chord = factory.create("HPCP",
-                                         "size", 36,
-                                         "referenceFrequency", tuningFreq,
-                                         "harmonics", 8,
-                                         "bandPreset", true,
-                                         "minFrequency", 20.0,
-                                         "maxFrequency", 3500.0,
-                                         "bandSplitFrequency", 500.0,
-                                         "weightType", "cosine",
-                                         "nonLinear", true,
-                                         "windowSize", 0.5);
-
   Algorithm* schord = factory.create("ChordsDetection");
   Algorithm* schords_desc = factory.create("ChordsDescriptors");
 
-  source                       >> fc->input("signal");
-  fc->output("frame")          >> w->input("frame");
-  w->output("frame")           >> spec->input("frame");
-  spec->output("spectrum")     >> peaks->input("spectrum");
+  spectrum                     >> peaks->input("spectrum");
+
+  peaks->output("frequencies") >> hpcps->input("frequencies");
+  peaks->output("magnitudes")  >> hpcps->input("magnitudes");
 
-  peaks->output("frequencies") >> hpcp_key->input("frequencies");
-  peaks->output("magnitudes")  >> hpcp_key->input("magnitudes");
+  hpcps->output("hpcps")       >> hpcp_key->input("hpcps");
   hpcp_key->output("hpcp")     >> PC(pool, nameSpace + "hpcp");
   hpcp_key->output("hpcp")     >> skey_temperley->input("pcp");
   hpcp_key->output("hpcp")     >> skey_krumhansl->input("pcp");
@@ -178,8 +204,7 @@ void MusicTonalDescriptors::createNetwork(SourceBase& source, Pool& pool) {
   skey_edma->output("strength")     >> PC(pool, nameSpace + "key_edma.strength");
 
 
-  peaks->output("frequencies") >> hpcp_chord->input("frequencies");
-  peaks->output("magnitudes")  >> hpcp_chord->input("magnitudes");
+  hpcps->output("hpcps")       >> hpcp_chord->input("hpcps");
   hpcp_chord->output("hpcp")   >> schord->input("pcp");
   schord->output("strength")   >> PC(pool, nameSpace + "chords_strength");
   
@@ -209,20 +234,7 @@ void MusicTonalDescriptors::createNetwork(SourceBase& source, Pool& pool) {
   crest->output("crest") >> PC(pool, nameSpace + "hpcp_crest");
 
   // HPCP Tuning
-  Algorithm* hpcp_tuning = factory.create("HPCP",
-                                          "size", 120,
-                                          "referenceFrequency", tuningFreq,
-                                          "harmonics", 8,
-                                          "bandPreset", true,
-                                          "minFrequency", 20.0,
-                                          "maxFrequency", 3500.0,
-                                          "bandSplitFrequency", 500.0,
-                                          "weightType", "cosine",
-                                          "nonLinear", true,
-                                          "windowSize", 0.5);
-
-  peaks->output("frequencies")  >> hpcp_tuning->input("frequencies");
-  peaks->output("magnitudes")   >> hpcp_tuning->input("magnitudes");
+  hpcps->output("hpcps")        >> hpcp_tuning->input("hpcps");
   hpcp_tuning->output("hpcp")   >> PC(pool, nameSpace + "hpcp_highres");
 }
 
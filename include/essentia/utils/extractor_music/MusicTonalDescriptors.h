@@ -33,8 +33,13 @@ class MusicTonalDescriptors : public MusicDescriptorSet {
   }
   ~MusicTonalDescriptors();
 
-  void createNetworkTuningFrequency(SourceBase& source, Pool& pool);
+  // if spectra is given, the spectra of the tonal frames are stored in it, so
+  // that they can be given to createNetworkFromSpectrum() once the tuning
+  // frequency is known
+  void createNetworkTuningFrequency(SourceBase& source, Pool& pool,
+                                    vector<vector<Real> >* spectra=0);
  	void createNetwork(SourceBase& source, Pool& pool);
+  void createNetworkFromSpectrum(SourceBase& spectrum, Pool& pool);
   void computeTuningSystemFeatures(Pool& pool);
 };
 
@@ -0,0 +1,219 @@
+#include "AnalysisCache.h"
+#include <essentia/essentia.h>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace essentia;
+
+// The file starts with a header identifying the format, followed by the
+// records, each of them being a RecordHeader, the key and the ticks. Values
+// are stored in the byte order of the device, the file is not meant to be
+// copied elsewhere.
+static const char fileMagic[8] = { 'I', 'K', 'A', 'C', 'A', 'C', 'H', 'E' };
+static const uint32_t fileVersion = 1;
+static const size_t fileHeaderSize = 16;
+
+struct RecordHeader {
+    uint32_t keySize;
+    uint32_t numberTicks;
+    float bpm;
+    float confidence;
+};
+
+// Version of the analysis results, part of the keys. It must be bumped
+// whenever a change to the analyses or to the algorithms they use changes
+// their results, even slightly, as essentia::version is not changed by the
+// patches applied to the bundled sources. History:
+//   1: keys without a version
+//   2: downmixing and resampling by libavresample in AudioLoader, seeded
+//      noise in TempoTapDegara, tabulated HPCP weighting
+//   3: downmixing and resampling by MonoMixer and Resample again
+//   4: excerpts of the fast analysis loaded with the samples of the whole file
+static const int analysisVersion = 4;
+
+// guards against reading garbage sizes from a damaged file
+static const uint32_t maxKeySize = 4096;
+static const uint32_t maxNumberTicks = 1 << 24;
+
+
+AnalysisCache::AnalysisCache(const string& filename) : _fd(-1), _data(0), _size(0) {
+    open(filename);
+}
+
+AnalysisCache::~AnalysisCache() {
+    unmap();
+    if (_fd >= 0) ::close(_fd);
+}
+
+void AnalysisCache::open(const string& filename) {
+    _fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (_fd < 0) return;
+
+    struct stat info;
+    if (fstat(_fd, &info) != 0) {
+        ::close(_fd);
+        _fd = -1;
+        return;
+    }
+    size_t size = (size_t)info.st_size;
+
+    char header[fileHeaderSize];
+    bool valid = size >= fileHeaderSize &&
+                 pread(_fd, header, fileHeaderSize, 0) == (ssize_t)fileHeaderSize &&
+                 memcmp(header, fileMagic, sizeof(fileMagic)) == 0;
+    uint32_t version = 0;
+    if (valid) memcpy(&version, header + sizeof(fileMagic), sizeof(version));
+
+    if (!valid || version != fileVersion) {
+        // unknown or older format, start again from scratch
+        memset(header, 0, fileHeaderSize);
+        memcpy(header, fileMagic, sizeof(fileMagic));
+        memcpy(header + sizeof(fileMagic), &fileVersion, sizeof(fileVersion));
+        if (ftruncate(_fd, 0) != 0 ||
+            pwrite(_fd, header, fileHeaderSize, 0) != (ssize_t)fileHeaderSize) {
+            ::close(_fd);
+            _fd = -1;
+            return;
+        }
+        return;
+    }
+
+    map(size);
+    if (!_data) {
+        ::close(_fd);
+        _fd = -1;
+        return;
+    }
+
+    // index the complete records, a later record replaces an earlier one
+    // with the same key
+    size_t offset = fileHeaderSize;
+    while (offset + sizeof(RecordHeader) <= size) {
+        RecordHeader record;
+        memcpy(&record, _data + offset, sizeof(record));
+        if (record.keySize > maxKeySize || record.numberTicks > maxNumberTicks) break;
+
+        size_t recordSize = sizeof(record) + record.keySize + record.numberTicks * sizeof(float);
+        if (offset + recordSize > size) break;
+
+        _offsets[string(_data + offset + sizeof(record), record.keySize)] = offset;
+        offset += recordSize;
+    }
+
+    // drop a partly written record, so that the next ones are appended right
+    // after the last complete one
+    if (offset < size) {
+        unmap();
+        if (ftruncate(_fd, offset) != 0) {
+            _offsets.clear();
+            ::close(_fd);
+            _fd = -1;
+            return;
+        }
+        map(offset);
+    }
+}
+
+void AnalysisCache::map(size_t size) {
+    void* data = mmap(0, size, PROT_READ, MAP_SHARED, _fd, 0);
+    if (data == MAP_FAILED) return;
+    _data = (const char*)data;
+    _size = size;
+}
+
+void AnalysisCache::unmap() {
+    if (_data) munmap((void*)_data, _size);
+    _data = 0;
+}
+
+bool AnalysisCache::find(const string& key, Entry& entry) const {
+    lock_guard<mutex> lock(_mutex);
+
+    unordered_map<string, Entry>::const_iterator added = _added.find(key);
+    if (added != _added.end()) {
+        entry = added->second;
+        return true;
+    }
+
+    unordered_map<string, size_t>::const_iterator it = _offsets.find(key);
+    if (it == _offsets.end()) return false;
+
+    const char* data = _data + it->second;
+    RecordHeader record;
+    memcpy(&record, data, sizeof(record));
+    entry.bpm = record.bpm;
+    entry.confidence = record.confidence;
+    entry.ticks.resize(record.numberTicks);
+    if (record.numberTicks > 0) {
+        memcpy(&entry.ticks[0], data + sizeof(record) + record.keySize,
+               record.numberTicks * sizeof(float));
+    }
+    return true;
+}
+
+void AnalysisCache::insert(const string& key, const Entry& entry) {
+    if (key.size() > maxKeySize || entry.ticks.size() > maxNumberTicks) return;
+
+    RecordHeader record;
+    record.keySize = (uint32_t)key.size();
+    record.numberTicks = (uint32_t)entry.ticks.size();
+    record.bpm = entry.bpm;
+    record.confidence = entry.confidence;
+
+    vector<char> buffer(sizeof(record) + key.size() + entry.ticks.size() * sizeof(float));
+    memcpy(&buffer[0], &record, sizeof(record));
+    memcpy(&buffer[sizeof(record)], key.data(), key.size());
+    if (!entry.ticks.empty()) {
+        memcpy(&buffer[sizeof(record) + key.size()], &entry.ticks[0],
+               entry.ticks.size() * sizeof(float));
+    }
+
+    lock_guard<mutex> lock(_mutex);
+    _added[key] = entry;
+
+    if (_fd < 0) return;
+
+    struct stat info;
+    if (fstat(_fd, &info) != 0) return;
+    off_t end = info.st_size;
+    if (pwrite(_fd, &buffer[0], buffer.size(), end) != (ssize_t)buffer.size()) {
+        // do not leave half a record behind, the following ones would be lost
+        if (ftruncate(_fd, end) != 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+    }
+}
+
+int AnalysisCache::size() const {
+    lock_guard<mutex> lock(_mutex);
+    int size = (int)_added.size();
+    for (unordered_map<string, size_t>::const_iterator it = _offsets.begin(); it != _offsets.end(); ++it) {
+        if (_added.find(it->first) == _added.end()) size++;
+    }
+    return size;
+}
+
+string AnalysisCache::makeKey(const string& md5, const string& analysis,
+                              const ParameterMap& configuration) {
+    // 64-bit FNV-1a hash of the configuration, parameters being sorted by name
+    uint64_t hash = 14695981039346656037ULL;
+    for (ParameterMap::const_iterator it = configuration.begin(); it != configuration.end(); ++it) {
+        string parameter = it->first + "=" +
+            (it->second.isConfigured() ? it->second.toString() : string()) + ";";
+        for (size_t i=0; i<parameter.size(); i++) {
+            hash ^= (unsigned char)parameter[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "/%d/%016llx", analysisVersion, (unsigned long long)hash);
+    return md5 + "/" + analysis + "/" + essentia::version + suffix;
+}
@@ -0,0 +1,74 @@
+#ifndef IKABEAT_ANALYSISCACHE_H
+#define IKABEAT_ANALYSISCACHE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <essentia/types.h>
+#include <essentia/parameter.h>
+
+/**
+ * Persistent cache of analysis results, keyed by the checksum of the encoded
+ * audio (see essentia::audioMD5) together with the name and configuration of
+ * the analysis, so that a file which has been moved, renamed or retagged is
+ * neither decoded nor analyzed again, even after the app has been restarted.
+ *
+ * Results are appended as records to a single file, which is memory mapped
+ * when the cache is opened: only the keys are indexed in memory, the values
+ * are read from the mapping when they are looked up. Results added while the
+ * cache is open are kept in memory as well. A record which was only partly
+ * written (eg: the app was killed meanwhile) is dropped when the file is
+ * opened again.
+ *
+ * All the methods are thread-safe.
+ */
+class AnalysisCache {
+public:
+    struct Entry {
+        essentia::Real bpm;
+        essentia::Real confidence;
+        std::vector<essentia::Real> ticks;
+
+        Entry() : bpm(0), confidence(0) {}
+    };
+
+    /**
+     * Opens the cache stored in the given file, creating it if needed. If the
+     * file cannot be opened, the cache still works but is not persistent.
+     */
+    explicit AnalysisCache(const std::string& filename);
+    ~AnalysisCache();
+
+    bool find(const std::string& key, Entry& entry) const;
+    void insert(const std::string& key, const Entry& entry);
+
+    int size() const;
+
+    /**
+     * Key of the results of the given analysis of the audio with the given
+     * checksum. The version of essentia and the version of the analysis
+     * results (see analysisVersion in AnalysisCache.cpp, to be bumped on
+     * every change of the results) are part of the key, so that results are
+     * computed again when the algorithms change.
+     */
+    static std::string makeKey(const std::string& md5, const std::string& analysis,
+                               const essentia::ParameterMap& configuration);
+
+private:
+    AnalysisCache(const AnalysisCache&);
+    AnalysisCache& operator=(const AnalysisCache&);
+
+    void open(const std::string& filename);
+    void map(size_t size);
+    void unmap();
+
+    mutable std::mutex _mutex;
+    int _fd;                    // -1 if the cache is not persistent
+    const char* _data;          // mapping of the records found when opening
+    size_t _size;
+    std::unordered_map<std::string, size_t> _offsets; // of the mapped records
+    std::unordered_map<std::string, Entry> _added;
+};
+
+#endif // IKABEAT_ANALYSISCACHE_H
@@ -27,38 +27,39 @@ class BPMDetector {
         }
     }
     
-    /// Detects BPM for multiple audio files concurrently
+    /// Detects BPM for multiple audio files on a bounded pool of workers
     /// - Parameters:
     ///   - urls: An array of URLs for the audio files
     ///   - progress: A closure called with the current progress (files processed and total files)
     ///   - completion: A closure called with a dictionary of URLs and their corresponding BPM values
     static func detectBPMForMultipleFiles(urls: [URL], progress: @escaping (Int, Int) -> Void, completion: @escaping ([URL: Double]) -> Void) {
-        let group = DispatchGroup()
-        let queue = DispatchQueue(label: "com.yourdomain.bpmdetection", attributes: .concurrent)
-        
-        var results = [URL: Double]()
-        let resultsQueue = DispatchQueue(label: "com.yourdomain.bpmresults")
-        
-        for (index, url) in urls.enumerated() {
-            group.enter()
-            queue.async {
-                detectBPM(for: url) { bpm in
-                    if let bpm = bpm {
-                        resultsQueue.async {
-                            results[url] = bpm
-                        }
-                    }
-                    DispatchQueue.main.async {
-                        progress(index + 1, urls.count)
-                    }
-                    group.leave()
+        DispatchQueue.global(qos: .userInitiated).async {
+            var urlsByPath = [String: URL]()
+            for url in urls {
+                urlsByPath[url.path] = url
+            }
+            
+            var results = [URL: Double]()
+            var processed = 0
+            
+            // Results come back on this thread one at a time, the workers
+            // wait while they are not consumed
+            EssentiaWrapper.analyzeBPM(forFiles: Array(urlsByPath.keys), workers: 0) { path, bpm, _ in
+                if bpm > 0, let url = urlsByPath[path] {
+                    results[url] = bpm
+                }
+                processed += 1
+                let count = processed
+                DispatchQueue.main.async {
+                    progress(count, urlsByPath.count)
                 }
+                return true
+            }
+            
+            let finalResults = results
+            DispatchQueue.main.async {
+                completion(finalResults)
             }
-        }
-        
-        // Notify when all BPM detections are complete
-        group.notify(queue: .main) {
-            completion(results)
         }
     }
 }
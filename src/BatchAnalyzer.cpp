@@ -0,0 +1,367 @@
+#include "BatchAnalyzer.h"
+#include "AnalysisCache.h"
+#include <essentia/algorithmfactory.h>
+#include <essentia/scheduler/network.h>
+#include <essentia/scheduler/graphutils.h>
+#include <essentia/streaming/algorithms/poolstorage.h>
+#include <algorithms/io/audioprobe.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include <exception>
+#include <sys/resource.h>
+#include <cmath>
+
+using namespace std;
+using namespace essentia;
+
+
+// FastAnalysis: number and length [s] of the excerpts, and part of the file
+// left out at its beginning and at its end
+static const int numberExcerpts = 3;
+static const Real excerptLength = 30.;
+static const Real excerptMargin = 0.1;
+
+// end of the whole file for the loader
+static const Real endOfFile = 1e6;
+
+
+BPMAnalyzer::BPMAnalyzer(Real sampleRate, AnalysisCache* cache, BPMAnalysisMode mode) :
+    _sampleRate(sampleRate), _mode(mode), _used(false), _cache(cache) {
+    streaming::AlgorithmFactory& factory = streaming::AlgorithmFactory::instance();
+
+    // the loader is only given a filename in analyze(), until then its
+    // configure() does nothing
+    _loader = factory.create("MonoLoader", "sampleRate", _sampleRate);
+    _rhythmExtractor = factory.create("RhythmExtractor2013");
+
+    _loader->output("audio")                >> _rhythmExtractor->input("signal");
+    _rhythmExtractor->output("bpm")         >> PC(_pool, "rhythm.bpm");
+    _rhythmExtractor->output("confidence")  >> PC(_pool, "rhythm.confidence");
+    _rhythmExtractor->output("ticks")       >> PC(_pool, "rhythm.ticks");
+    _rhythmExtractor->output("estimates")   >> streaming::NOWHERE;
+    _rhythmExtractor->output("bpmIntervals") >> streaming::NOWHERE;
+
+    // analyses are run concurrently, one per thread (see BPMAnalyzerPool and
+    // BatchAnalyzer), whatever Network::defaultNumberThreads is
+    _network = new scheduler::Network(_loader);
+    _network->setNumberThreads(1);
+
+    _configuration = _rhythmExtractor->defaultParameters();
+    _configuration.add("sampleRate", _sampleRate);
+    if (_mode == FastAnalysis) {
+        _configuration.add("numberExcerpts", numberExcerpts);
+        _configuration.add("excerptLength", excerptLength);
+        _configuration.add("excerptMargin", excerptMargin);
+    }
+}
+
+BPMAnalyzer::~BPMAnalyzer() {
+    delete _network;
+}
+
+BPMResult BPMAnalyzer::analyze(const string& filename) {
+    BPMResult result;
+    result.filename = filename;
+
+    try {
+        // the checksum only needs the file to be demuxed, so a file which was
+        // already analyzed, maybe under another name, is not decoded at all
+        string key;
+        if (_cache) {
+            const char* analysis = _mode == FastAnalysis ? "RhythmExtractor2013Excerpts" : "RhythmExtractor2013";
+            key = AnalysisCache::makeKey(audioMD5(filename), analysis, _configuration);
+            AnalysisCache::Entry entry;
+            if (_cache->find(key, entry)) {
+                result.bpm = entry.bpm;
+                result.confidence = entry.confidence;
+                result.ticks = entry.ticks;
+                result.cached = true;
+                result.ok = true;
+                return result;
+            }
+        }
+
+        // the excerpts are only worth it if they leave out most of the file
+        Real duration = _mode == FastAnalysis ? audioDuration(filename) : -1;
+        if (duration * (1 - 2*excerptMargin) >= 2 * numberExcerpts * excerptLength) {
+            analyzeExcerpts(filename, duration, result);
+        }
+        else {
+            analyzeSlice(filename, 0, endOfFile, result);
+        }
+
+        if (result.ok) {
+            if (_cache) {
+                AnalysisCache::Entry entry;
+                entry.bpm = result.bpm;
+                entry.confidence = result.confidence;
+                entry.ticks = result.ticks;
+                _cache->insert(key, entry);
+            }
+        }
+        else {
+            result.error = "no tempo could be estimated";
+        }
+    }
+    catch (const exception& e) {
+        result.ok = false;
+        result.error = e.what();
+    }
+
+    return result;
+}
+
+bool BPMAnalyzer::analyzeSlice(const string& filename, Real startTime, Real endTime,
+                               BPMResult& result) {
+    // opens the file (seeking to startTime), and reconfigures the resampling
+    // for its sample rate. This also resets the loader, so only the other
+    // algorithms are reset afterwards: resetting the whole network would
+    // close the file and open it again
+    _loader->configure("filename", filename, "startTime", startTime, "endTime", endTime);
+    if (_used) {
+        scheduler::NodeVector nodes = scheduler::depthFirstSearch(_network->visibleNetworkRoot());
+        for (int i=0; i<(int)nodes.size(); i++) {
+            if (nodes[i]->algorithm() != _loader) nodes[i]->algorithm()->reset();
+        }
+    }
+    _pool.clear();
+
+    _used = true;
+    _network->run();
+
+    if (!_pool.contains<Real>("rhythm.bpm")) return false;
+
+    result.bpm = _pool.value<Real>("rhythm.bpm");
+    result.confidence = _pool.value<Real>("rhythm.confidence");
+    result.ticks.clear();
+    if (_pool.contains<vector<Real> >("rhythm.ticks")) {
+        result.ticks = _pool.value<vector<Real> >("rhythm.ticks");
+    }
+    result.ok = true;
+    return true;
+}
+
+// 1 if the two tempos are the same (within the 4% tolerance commonly used to
+// evaluate tempo estimation), 0.5 if one is twice the other, 0 otherwise
+static Real tempoAgreement(Real bpm1, Real bpm2) {
+    if (fabs(bpm1 - bpm2) <= 0.04 * bpm2) return 1;
+    if (fabs(2*bpm1 - bpm2) <= 0.04 * bpm2 || fabs(2*bpm2 - bpm1) <= 0.04 * bpm1) return 0.5;
+    return 0;
+}
+
+void BPMAnalyzer::analyzeExcerpts(const string& filename, Real duration, BPMResult& result) {
+    // the excerpts are centered on equal parts of the file without its margins
+    Real begin = excerptMargin * duration;
+    Real step = (1 - 2*excerptMargin) * duration / numberExcerpts;
+
+    vector<BPMResult> excerpts;
+    for (int i=0; i<numberExcerpts; i++) {
+        Real startTime = begin + (i + 0.5) * step - excerptLength / 2;
+        BPMResult excerpt;
+        if (!analyzeSlice(filename, startTime, startTime + excerptLength, excerpt)) continue;
+
+        for (int j=0; j<(int)excerpt.ticks.size(); j++) excerpt.ticks[j] += startTime;
+        excerpts.push_back(excerpt);
+    }
+    if (excerpts.empty()) return;
+
+    // vote as TempoTapMaxAgreement does for beat candidates: the estimate
+    // agreeing the most with the others wins, the confidence of the beat
+    // tracker breaking ties. Estimates at half or twice its tempo count for
+    // less, as the beat tracker may follow another metrical level in a part
+    // of the file
+    int best = 0;
+    Real bestVotes = -1;
+    for (int i=0; i<(int)excerpts.size(); i++) {
+        Real votes = 0;
+        for (int j=0; j<(int)excerpts.size(); j++) {
+            votes += tempoAgreement(excerpts[i].bpm, excerpts[j].bpm);
+        }
+        if (votes > bestVotes ||
+            (votes == bestVotes && excerpts[i].confidence > excerpts[best].confidence)) {
+            best = i;
+            bestVotes = votes;
+        }
+    }
+
+    // average over the excerpts at the winning tempo, the confidence being
+    // lowered by the excerpts which disagree or have no estimate
+    Real bpm = 0;
+    Real confidence = 0;
+    int agreeing = 0;
+    result.ticks.clear();
+    for (int i=0; i<(int)excerpts.size(); i++) {
+        if (tempoAgreement(excerpts[best].bpm, excerpts[i].bpm) < 1) continue;
+        bpm += excerpts[i].bpm;
+        confidence += excerpts[i].confidence;
+        agreeing++;
+        result.ticks.insert(result.ticks.end(), excerpts[i].ticks.begin(), excerpts[i].ticks.end());
+    }
+
+    result.bpm = bpm / agreeing;
+    result.confidence = confidence / numberExcerpts;
+    result.ok = true;
+}
+
+
+BPMResult BPMAnalyzerPool::analyze(const string& filename) {
+    unique_ptr<BPMAnalyzer> analyzer;
+    {
+        lock_guard<mutex> lock(_mutex);
+        if (!_idle.empty()) {
+            analyzer = move(_idle.back());
+            _idle.pop_back();
+        }
+    }
+
+    BPMResult result;
+    try {
+        if (!analyzer) analyzer.reset(new BPMAnalyzer(44100., _cache, _mode));
+    }
+    catch (const exception& e) {
+        result.filename = filename;
+        result.error = e.what();
+        return result;
+    }
+
+    result = analyzer->analyze(filename);
+
+    lock_guard<mutex> lock(_mutex);
+    _idle.push_back(move(analyzer));
+    return result;
+}
+
+void BPMAnalyzerPool::clear() {
+    lock_guard<mutex> lock(_mutex);
+    _idle.clear();
+}
+
+
+BatchAnalyzer::BatchAnalyzer(int numberWorkers, int maxPendingResults, AnalysisCache* cache,
+                             BPMAnalysisMode mode) :
+    _cache(cache), _mode(mode) {
+    if (numberWorkers <= 0) numberWorkers = (int)thread::hardware_concurrency();
+    _numberWorkers = max(numberWorkers, 1);
+    _maxPendingResults = maxPendingResults > 0 ? maxPendingResults : _numberWorkers;
+    _analyzers.resize(_numberWorkers);
+}
+
+BatchAnalyzer::~BatchAnalyzer() {}
+
+BatchStatistics BatchAnalyzer::run(const vector<string>& filenames, const Callback& callback) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    BatchStatistics stats;
+
+    mutex resultsMutex;
+    condition_variable resultReady;  // signaled by the workers
+    condition_variable roomReady;    // signaled by the consumer
+    deque<BPMResult> results;
+    int pending = 0;                 // results waiting for the callback
+    int activeWorkers = 0;
+    bool stop = false;
+    size_t next = 0;
+
+    int numberWorkers = min(_numberWorkers, (int)filenames.size());
+
+    vector<thread> workers;
+    for (int i=0; i<numberWorkers; i++) {
+        activeWorkers++;
+        workers.push_back(thread([&, i]() {
+            while (true) {
+                size_t index;
+                {
+                    // backpressure: do not start a new file while too many
+                    // results are waiting for the consumer
+                    unique_lock<mutex> lock(resultsMutex);
+                    while (!stop && pending >= _maxPendingResults) roomReady.wait(lock);
+                    if (stop || next >= filenames.size()) break;
+                    index = next++;
+                }
+
+                BPMResult result;
+                try {
+                    if (!_analyzers[i]) _analyzers[i].reset(new BPMAnalyzer(44100., _cache, _mode));
+                    result = _analyzers[i]->analyze(filenames[index]);
+                }
+                catch (const exception& e) {
+                    result.filename = filenames[index];
+                    result.error = e.what();
+                }
+
+                {
+                    lock_guard<mutex> lock(resultsMutex);
+                    results.push_back(result);
+                    pending++;
+                }
+                resultReady.notify_one();
+            }
+
+            {
+                lock_guard<mutex> lock(resultsMutex);
+                activeWorkers--;
+            }
+            resultReady.notify_one();
+        }));
+    }
+
+    exception_ptr error;
+    while (true) {
+        BPMResult result;
+        {
+            unique_lock<mutex> lock(resultsMutex);
+            while (results.empty() && activeWorkers > 0) resultReady.wait(lock);
+            if (results.empty()) break;
+            result = results.front();
+            results.pop_front();
+            pending--;
+        }
+        roomReady.notify_all();
+
+        // once stopped, the files still being analyzed are not reported
+        bool proceed = false;
+        if (!stop) {
+            stats.files++;
+            if (!result.ok) stats.failed++;
+            if (result.cached) stats.cached++;
+
+            try {
+                proceed = callback(result);
+            }
+            catch (...) {
+                error = current_exception();
+            }
+        }
+
+        if (!proceed && !stop) {
+            {
+                lock_guard<mutex> lock(resultsMutex);
+                stop = true;
+            }
+            roomReady.notify_all();
+        }
+    }
+
+    for (int i=0; i<(int)workers.size(); i++) workers[i].join();
+
+    if (error) rethrow_exception(error);
+
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    stats.filesPerSecond = stats.seconds > 0 ? stats.files / stats.seconds : 0;
+    stats.peakMemory = peakResidentMemory();
+    return stats;
+}
+
+
+size_t peakResidentMemory() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;         // bytes
+#else
+    return (size_t)usage.ru_maxrss * 1024;  // kilobytes
+#endif
+}
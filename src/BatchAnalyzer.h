@@ -0,0 +1,187 @@
+#ifndef IKABEAT_BATCHANALYZER_H
+#define IKABEAT_BATCHANALYZER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <essentia/types.h>
+#include <essentia/pool.h>
+#include <essentia/parameter.h>
+
+class AnalysisCache;
+
+namespace essentia {
+namespace streaming { class Algorithm; }
+namespace scheduler { class Network; }
+}
+
+/**
+ * Result of the BPM analysis of one file.
+ */
+struct BPMResult {
+    std::string filename;
+    bool ok;                // false if the file could not be analyzed
+    std::string error;      // what went wrong when !ok
+    essentia::Real bpm;
+    essentia::Real confidence;
+    std::vector<essentia::Real> ticks; // beat positions [s]
+    bool cached;            // whether the result was found in the cache
+
+    BPMResult() : ok(false), bpm(0), confidence(0), cached(false) {}
+};
+
+/**
+ * How much of a file is analyzed, see BPMAnalyzer.
+ */
+enum BPMAnalysisMode {
+    FullAnalysis,
+    FastAnalysis
+};
+
+/**
+ * MonoLoader -> RhythmExtractor2013 streaming network which is built and
+ * configured once, and only pointed to a new file and reset between two
+ * analyses, so that analyzing a file does not construct any algorithm.
+ *
+ * In FastAnalysis mode, long files (eg: mixes, podcasts) are not decoded
+ * entirely: the loader seeks to a few excerpts spread over the file, leaving
+ * out its intro and outro, each excerpt is analyzed on its own and the
+ * estimates are merged by voting for the tempo most of them agree on. The
+ * ticks then only cover the excerpts. Files which are too short for the
+ * excerpts to save time are analyzed as in FullAnalysis mode.
+ *
+ * If it is given a cache, the results are looked up there by the checksum of
+ * the encoded audio before decoding the file, and stored there afterwards.
+ *
+ * An instance must only be used by one thread at a time.
+ */
+class BPMAnalyzer {
+public:
+    explicit BPMAnalyzer(essentia::Real sampleRate = 44100., AnalysisCache* cache = 0,
+                         BPMAnalysisMode mode = FullAnalysis);
+    ~BPMAnalyzer();
+
+    /**
+     * Analyzes the given file. Errors are reported in the result, this never
+     * throws.
+     */
+    BPMResult analyze(const std::string& filename);
+
+private:
+    BPMAnalyzer(const BPMAnalyzer&);
+    BPMAnalyzer& operator=(const BPMAnalyzer&);
+
+    // analyzes the slice of the file between the given times [s], returns
+    // false if no tempo could be estimated
+    bool analyzeSlice(const std::string& filename, essentia::Real startTime, essentia::Real endTime,
+                      BPMResult& result);
+    void analyzeExcerpts(const std::string& filename, essentia::Real duration, BPMResult& result);
+
+    essentia::Real _sampleRate;
+    BPMAnalysisMode _mode;
+    essentia::streaming::Algorithm* _loader;
+    essentia::streaming::Algorithm* _rhythmExtractor;
+    essentia::Pool _pool;
+    essentia::scheduler::Network* _network; // owns the algorithms
+    bool _used; // whether the network has been run since it was last reset
+
+    AnalysisCache* _cache;
+    essentia::ParameterMap _configuration; // what the results depend on
+};
+
+/**
+ * Set of BPMAnalyzer instances shared by the threads of the process. An
+ * analysis takes an idle analyzer (or creates one if they are all busy) and
+ * gives it back afterwards, so that the algorithms are only constructed once
+ * per concurrent analysis, and not once per file.
+ */
+class BPMAnalyzerPool {
+public:
+    explicit BPMAnalyzerPool(AnalysisCache* cache = 0, BPMAnalysisMode mode = FullAnalysis) :
+        _cache(cache), _mode(mode) {}
+
+    BPMResult analyze(const std::string& filename);
+
+    /**
+     * Deletes the idle analyzers, should not be called while analyses are
+     * running.
+     */
+    void clear();
+
+private:
+    BPMAnalyzerPool(const BPMAnalyzerPool&);
+    BPMAnalyzerPool& operator=(const BPMAnalyzerPool&);
+
+    AnalysisCache* _cache;
+    BPMAnalysisMode _mode;
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<BPMAnalyzer> > _idle;
+};
+
+struct BatchStatistics {
+    int files;              // number of files analyzed
+    int failed;             // number of those which could not be analyzed
+    int cached;             // number of those which were found in the cache
+    double seconds;         // wall clock duration of the batch
+    double filesPerSecond;
+    size_t peakMemory;      // peak resident memory of the process [bytes]
+
+    BatchStatistics() : files(0), failed(0), cached(0), seconds(0), filesPerSecond(0), peakMemory(0) {}
+};
+
+/**
+ * Analyzes a list of files on a fixed number of worker threads, each of them
+ * reusing its own BPMAnalyzer.
+ *
+ * Results are given to the callback on the thread calling run(), in the order
+ * in which they are ready. When maxPendingResults results are waiting for the
+ * callback, the workers do not start
+ * analyzing new files until there is room again, so that a slow consumer
+ * bounds the amount of work (and memory) in flight. The callback can return
+ * false to stop the batch, files which have not been started are then
+ * skipped.
+ */
+class BatchAnalyzer {
+public:
+    typedef std::function<bool (const BPMResult&)> Callback;
+
+    /**
+     * @param numberWorkers number of worker threads, 0 to use one per core
+     * @param maxPendingResults number of results which can wait for the
+     *        callback before the workers pause, 0 to use the number of workers
+     * @param cache where results are looked up and stored, if any
+     * @param mode how much of each file is analyzed
+     */
+    explicit BatchAnalyzer(int numberWorkers = 0, int maxPendingResults = 0,
+                           AnalysisCache* cache = 0, BPMAnalysisMode mode = FullAnalysis);
+    ~BatchAnalyzer();
+
+    /**
+     * Analyzes all the given files, and returns once they have all been given
+     * to the callback (or the callback asked to stop). If the callback throws,
+     * the workers are stopped and the exception is rethrown.
+     */
+    BatchStatistics run(const std::vector<std::string>& filenames, const Callback& callback);
+
+    int numberWorkers() const { return _numberWorkers; }
+
+private:
+    BatchAnalyzer(const BatchAnalyzer&);
+    BatchAnalyzer& operator=(const BatchAnalyzer&);
+
+    int _numberWorkers;
+    int _maxPendingResults;
+    AnalysisCache* _cache;
+    BPMAnalysisMode _mode;
+    // kept between calls to run(), created by the workers when first needed
+    std::vector<std::unique_ptr<BPMAnalyzer> > _analyzers;
+};
+
+/**
+ * Peak resident memory of the process so far [bytes].
+ */
+size_t peakResidentMemory();
+
+#endif // IKABEAT_BATCHANALYZER_H
@@ -6,4 +6,25 @@
 + (void)shutdown;
 + (double)analyzeBPMForFile:(NSString *)filePath;
 
+/// Same as analyzeBPMForFile:, but a long file (eg: a mix or a podcast) is
+/// only analyzed on a few excerpts when fast is YES, which is several times
+/// faster at the cost of some accuracy.
++ (double)analyzeBPMForFile:(NSString *)filePath fast:(BOOL)fast;
+
+/// Analyzes several files on a bounded pool of worker threads (0 = one per
+/// core) and blocks until they are done. The result block is called on the
+/// calling thread for each file as soon as it is ready, with a BPM of 0 if
+/// the file could not be analyzed; returning NO stops the batch. Workers wait
+/// while results are not consumed.
++ (void)analyzeBPMForFiles:(NSArray<NSString *> *)filePaths
+                   workers:(NSInteger)workers
+                    result:(BOOL (^)(NSString *filePath, double bpm, double confidence))result;
+
+/// Same as analyzeBPMForFiles:workers:result:, long files being only analyzed
+/// on a few excerpts when fast is YES.
++ (void)analyzeBPMForFiles:(NSArray<NSString *> *)filePaths
+                   workers:(NSInteger)workers
+                      fast:(BOOL)fast
+                    result:(BOOL (^)(NSString *filePath, double bpm, double confidence))result;
+
 @end
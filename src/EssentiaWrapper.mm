@@ -3,66 +3,136 @@
 #import <essentia/essentia.h>
 #import <essentia/pool.h>
 #import <essentia/algorithm.h>
+#import <algorithms/standard/fftwplancache.h>
+#import "BatchAnalyzer.h"
+#import "AnalysisCache.h"
 #import <vector>
 
 using namespace essentia;
 using namespace essentia::standard;
 
+static std::string cachesPath(NSString *filename) {
+    NSArray *paths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES);
+    NSString *directory = [[paths firstObject] stringByAppendingPathComponent:
+                           [[NSBundle mainBundle] bundleIdentifier] ?: @"ikaBeat"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory
+                              withIntermediateDirectories:YES attributes:nil error:nil];
+    return std::string([[directory stringByAppendingPathComponent:filename] UTF8String]);
+}
+
+// FFTW wisdom is kept in the caches directory of the app, so that the FFT
+// plans only need to be measured the first time the app is run
+static std::string fftwWisdomPath() {
+    return cachesPath(@"fftw.wisdom");
+}
+
+// Results of the analyses, keyed by the checksum of the encoded audio, so that
+// rescanning the library does not analyze again the files which were only
+// moved or renamed, even after the app has been restarted.
+// Never deleted, as it can still be in use by other threads at exit
+static AnalysisCache& analysisCache() {
+    static AnalysisCache* cache = new AnalysisCache(cachesPath(@"analysis.cache"));
+    return *cache;
+}
+
 @implementation EssentiaWrapper
 
-+ (double)analyzeBPMForFile:(NSString *)filePath {
++ (void)setupEssentia {
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
         essentia::init();
+        // Measure the FFT plans missing from the wisdom, they are saved
+        // after the first analysis
+        FFTWPlanCache::importWisdom(fftwWisdomPath());
+        FFTWPlanCache::setMeasure(true);
+    });
+}
+
++ (void)saveFFTWisdom {
+    static dispatch_once_t wisdomToken;
+    dispatch_once(&wisdomToken, ^{
+        FFTWPlanCache::exportWisdom(fftwWisdomPath());
     });
+}
+
+// Analyzers kept between calls, so that the loader and the rhythm extractor
+// (with its inner beat tracking network, FFT plans and transition matrices)
+// are only built once per concurrent analysis instead of once per file.
+// Never deleted, as it can still be in use by other threads at exit
+static BPMAnalyzerPool& analyzerPool(BPMAnalysisMode mode) {
+    static BPMAnalyzerPool* fullPool = new BPMAnalyzerPool(&analysisCache(), FullAnalysis);
+    static BPMAnalyzerPool* fastPool = new BPMAnalyzerPool(&analysisCache(), FastAnalysis);
+    return mode == FastAnalysis ? *fastPool : *fullPool;
+}
+
++ (double)analyzeBPMForFile:(NSString *)filePath {
+    return [self analyzeBPMForFile:filePath fast:NO];
+}
+
++ (double)analyzeBPMForFile:(NSString *)filePath fast:(BOOL)fast {
+    [self setupEssentia];
     
     @autoreleasepool {
-        Real bpm = 0.0f;  // Use Real type (typically float)
-        
-        // Create an instance of the algorithm factory
-        AlgorithmFactory& factory = standard::AlgorithmFactory::instance();
-        
-        // Create MonoLoader algorithm for loading audio files
-        Algorithm* audioLoader = factory.create("MonoLoader",
-                                                    "filename", std::string([filePath UTF8String]),
-                                                    "sampleRate", 44100.0f);  // Use float
-        
-        std::vector<Real> inputSignal;
-        audioLoader->output("audio").set(inputSignal);
-        try {
-            audioLoader->compute();
-        } catch (const std::exception& e) {
-            NSLog(@"Error loading audio file: %s", e.what());
-            delete audioLoader;
+        // The audio file is decoded, downmixed and resampled as a stream
+        // (AudioLoader -> MonoMixer -> Resample) and fed to RhythmExtractor2013
+        // chunk by chunk, so that the onset detection runs while the file is
+        // still being decoded and the whole signal never needs to be in memory
+        BPMAnalysisMode mode = fast ? FastAnalysis : FullAnalysis;
+        BPMResult result = analyzerPool(mode).analyze(std::string([filePath UTF8String]));
+        if (!result.ok) {
+            NSLog(@"Error analyzing audio file: %s", result.error.c_str());
             return 0.0; // Return 0 to indicate processing failure
         }
         
-        // Create an instance of RhythmExtractor2013 algorithm
-        Algorithm* rhythmExtractor = factory.create("RhythmExtractor2013");
-        
-        Real confidence;
-        std::vector<Real> ticks, estimates, bpmIntervals;
-        
-        // Configure input
-        rhythmExtractor->input("signal").set(inputSignal);
-        
-        // Configure output
-        rhythmExtractor->output("bpm").set(bpm);
-        rhythmExtractor->output("ticks").set(ticks);
-        rhythmExtractor->output("estimates").set(estimates);
-        rhythmExtractor->output("bpmIntervals").set(bpmIntervals);
-        rhythmExtractor->output("confidence").set(confidence);
-        
-        // Calculate rhythm
-        rhythmExtractor->compute();
-        
-        NSLog(@"Detected BPM: %f with confidence: %f", bpm, confidence);
+        NSLog(@"Detected BPM: %f with confidence: %f%s", result.bpm, result.confidence,
+              result.cached ? " (cached)" : "");
+
+        [self saveFFTWisdom];
+
+        return result.bpm; // Return the detected BPM value
+    }
+}
+
++ (void)analyzeBPMForFiles:(NSArray<NSString *> *)filePaths
+                   workers:(NSInteger)workers
+                    result:(BOOL (^)(NSString *filePath, double bpm, double confidence))result {
+    [self analyzeBPMForFiles:filePaths workers:workers fast:NO result:result];
+}
 
-        return bpm; // Return the detected BPM value
++ (void)analyzeBPMForFiles:(NSArray<NSString *> *)filePaths
+                   workers:(NSInteger)workers
+                      fast:(BOOL)fast
+                    result:(BOOL (^)(NSString *filePath, double bpm, double confidence))result {
+    [self setupEssentia];
+
+    std::vector<std::string> filenames;
+    for (NSString *filePath in filePaths) {
+        filenames.push_back(std::string([filePath UTF8String]));
     }
+
+    // Each worker keeps its own loader and rhythm extractor for all the files
+    // it analyzes
+    BatchAnalyzer batch((int)workers, 0, &analysisCache(), fast ? FastAnalysis : FullAnalysis);
+    BatchStatistics stats = batch.run(filenames, [result](const BPMResult& r) -> bool {
+        @autoreleasepool {
+            if (!r.ok) {
+                NSLog(@"Error analyzing audio file %s: %s", r.filename.c_str(), r.error.c_str());
+            }
+            NSString *filePath = [NSString stringWithUTF8String:r.filename.c_str()];
+            return result(filePath, r.ok ? r.bpm : 0.0, r.ok ? r.confidence : 0.0);
+        }
+    });
+
+    [self saveFFTWisdom];
+
+    NSLog(@"Analyzed %d files (%d failed, %d cached) in %.1f s on %d workers: %.2f files/s, peak RSS %.1f MB",
+          stats.files, stats.failed, stats.cached, stats.seconds, batch.numberWorkers(),
+          stats.filesPerSecond, stats.peakMemory / (1024.0 * 1024.0));
 }
 
 + (void)dealloc {
+    analyzerPool(FullAnalysis).clear();
+    analyzerPool(FastAnalysis).clear();
     essentia::shutdown();
 }
 
@@ -71,6 +141,8 @@ using namespace essentia::standard;
 }
 
 + (void)shutdown {
+    analyzerPool(FullAnalysis).clear();
+    analyzerPool(FastAnalysis).clear();
     essentia::shutdown();
 }
 